@@ -0,0 +1,141 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace OWEN {
+
+/**
+ * Stop of a batch at the target count without the overshoot of polling. The counter is read continuously, the pulse
+ * rate is estimated from the readings and the stop is issued early by the pulses predicted to come while it takes
+ * effect. Latency of the stop is learned from the overshoot of every batch, so it follows the bus and the line.
+ * Counting is forward from 0 after reset.
+ */
+class BatchController
+{
+public:
+  enum class eStop
+  {
+    SOFTWARE,    ///< StartCounter(false) is sent when the predicted count reaches the target, the bus latency is learned
+    SET_POINT    ///< OUT1 of the device stops the line at set point 1, which is put below the target by the coasting
+  };
+
+  struct Options
+  {
+    eStop stop{eStop::SOFTWARE};
+    double learningRate{0.5};                            ///< weight of the last batch in the learned stop latency
+    std::chrono::milliseconds stallTimeout{10000};        ///< batch fails if the count does not advance so long
+  };
+
+  struct Batch
+  {
+    int32_t target{};
+    int32_t stopAt{};                          ///< predicted count when the stop was issued (SOFTWARE) or set point 1
+    int32_t count{};                           ///< final count
+    double rate{};                             ///< pulses per second when the stop was issued
+    std::chrono::microseconds stopLatency{};   ///< latency the prediction was made with
+    std::chrono::milliseconds duration{};
+    bool isStopUncertain{};                    ///< the stop request or set point write got no reply, the latency is not learned from it
+
+    auto Overshoot() const -> int32_t
+    {
+      return count - target;
+    }
+  };
+
+public:
+  /**
+   * @param counter is used by the controller only while a batch runs.
+   */
+  BatchController(ImpulseCounter30& counter, Options options);
+
+  BatchController(BatchController const&) = delete;
+  BatchController& operator=(BatchController const&) = delete;
+
+  /**
+   * Writes back the counter options SET_POINT batches changed. They are kept between batches, OUT1 keeps the
+   * line stopped with them.
+   */
+  ~BatchController();
+
+  /**
+   * Reset and start the counter and stop it at the target, blocks until the count is final. Failed reads are retried,
+   * they count toward stallTimeout.
+   * @return empty if the count did not advance for stallTimeout, the counter is stopped then if it answers.
+   */
+  auto Run(int32_t target) -> std::optional<Batch>;
+
+  /**
+   * Learned stop latency, it can be kept between runs of the application.
+   */
+  auto GetStopLatency() const -> std::chrono::microseconds;
+
+  void SetStopLatency(std::chrono::microseconds stopLatency);
+
+private:
+  /**
+   * Counter reading, taken at the middle of its exchange.
+   */
+  struct Reading
+  {
+    int32_t value{};
+    std::chrono::steady_clock::time_point time;
+  };
+
+  /**
+   * Rate and round trip of the counter stream.
+   */
+  struct Stream
+  {
+    std::deque<Reading> window;                 ///< last readings, the rate is taken over all of them
+    double rate{};                              ///< pulses per second
+    std::chrono::microseconds roundTrip{};
+    std::chrono::steady_clock::time_point lastAdvance;
+  };
+
+private:
+  auto Read(Stream& stream) -> std::optional<Reading>;
+
+  /**
+   * @return count (not rounded) when the stop was issued, empty if the batch failed.
+   */
+  auto RunSoftware(Batch& batch) -> std::optional<double>;
+
+  auto RunSetPoint(Batch& batch) -> std::optional<double>;
+
+  /**
+   * Read until the count stops changing (the line has coasted to a stop).
+   */
+  auto Settle(Stream& stream, double rate) -> std::optional<int32_t>;
+
+  bool IsStalled(Stream const& stream) const;
+
+  /**
+   * Reset and start the counter, requests are repeated for up to stallTimeout.
+   */
+  bool Start(Stream& stream);
+
+  /**
+   * Stop the counter and read the final count, requests are repeated for up to stallTimeout.
+   */
+  auto Stop(Batch& batch) -> std::optional<int32_t>;
+
+  /**
+   * @param stoppedAt count (not rounded) when the stop was issued.
+   */
+  void Learn(Batch const& batch, double stoppedAt);
+
+private:
+  ImpulseCounter30& _counter;
+  Options _options;
+  std::optional<std::chrono::microseconds> _stopLatency;   ///< empty until the first batch (or set)
+  double _lastRate{};                                     ///< of the previous batch, for the first set point
+  std::optional<ImpulseCounter30::CounterOptions> _savedOptions;   ///< of the device before the first SET_POINT batch
+  bool _isSetPointConfigured{};
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Listen-only decoder of a bus driven by another master (a PLC or SCADA): the port is opened read-only, so the bus
+ * carries no extra load. Requests and responses are reassembled from the raw traffic, confirmed reads and writes of
+ * the counters are put to their register images and snapshots of the counters are produced like those of
+ * ImpulseCounter30 and Poller. Only what the master reads or writes is seen, and only as often as it does.
+ */
+class BusSniffer
+{
+public:
+  /**
+   * Transaction a register value was confirmed by.
+   */
+  struct Stamp
+  {
+    uint64_t transaction{};                        ///< number of the decoded transaction since start, 0 - never read
+    std::chrono::system_clock::time_point time;   ///< when its response was received
+  };
+
+  struct Observed
+  {
+    ImpulseCounter30::RegisterImage image;        ///< registers the master never touched are 0
+    std::chrono::steady_clock::time_point time;   ///< when the image was last changed
+    std::vector<Stamp> inputStamps;               ///< of every input register
+  };
+
+  /**
+   * Transactions the values of a snapshot came from, the master may read them by different ones. A 32 bit value has
+   * the older stamp of its two registers.
+   */
+  struct SnapshotStamps
+  {
+    Stamp counterValue;
+    Stamp counterEU;
+    Stamp startStopMode;
+    Stamp currentMode;
+    Stamp codeErrNet;
+
+    /**
+     * True if all values came from one transaction.
+     */
+    bool IsCoherent() const
+    {
+      auto const transaction = counterValue.transaction;
+      return (counterEU.transaction == transaction) && (startStopMode.transaction == transaction) &&
+             (currentMode.transaction == transaction) && (codeErrNet.transaction == transaction);
+    }
+  };
+
+  struct Statistics
+  {
+    uint64_t frames{};          ///< frames with valid crc
+    uint64_t transactions{};    ///< requests with their responses
+    uint64_t exceptions{};      ///< transactions answered with exception responses
+    uint64_t unanswered{};
+    uint64_t discardedBytes{};  ///< bytes of broken frames (crc errors, collisions) and noise
+    uint64_t snapshots{};
+  };
+
+  /**
+   * @param unit slave address of the counter.
+   * @param time when the response with the new values was received.
+   * @param stamps transactions every value came from.
+   */
+  using tSnapshot = std::function<void(uint8_t unit,
+                                       std::chrono::system_clock::time_point time,
+                                       ImpulseCounter30::Snapshot const& snapshot,
+                                       SnapshotStamps const& stamps)>;
+
+public:
+  /**
+   * @param communicationOptions port path and serial options of the bus, all of them have to be set; the port is
+   *        opened when started.
+   * @param units slave addresses of the counters on the bus, empty - every slave is taken for a counter. Traffic of
+   *        other devices is never decoded with the register map of the counter.
+   * @param gap silence which ends a frame, 0 - t3.5 of the baudrate. Raise it to a few milliseconds for USB adapters,
+   *        which deliver bytes in chunks by their latency timer.
+   */
+  explicit BusSniffer(ImpulseCounter30::CommunicationOptions const& communicationOptions,
+                      std::vector<uint8_t> units = {},
+                      std::chrono::microseconds gap = {});
+  ~BusSniffer();
+  BusSniffer(BusSniffer const&) = delete;
+  BusSniffer& operator=(BusSniffer const&) = delete;
+
+  /**
+   * Subscribe to snapshots, only before Start. A snapshot is produced when the master reads any of its registers,
+   * once all of them have been read at least once, so its values may come from different transactions (see
+   * SnapshotStamps). Callbacks are called from the reader thread.
+   */
+  void OnSnapshot(tSnapshot snapshot);
+
+  /**
+   * Publish snapshots to a shared memory segment like Poller::Publish(), only before Start.
+   * @throw std::runtime_error if segment could not be created.
+   */
+  void Publish(std::string const& shmName);
+
+  /**
+   * Open the port and start the reader thread. A port which is lost is reopened with backoff.
+   * @throw std::runtime_error if port could not be opened.
+   */
+  void Start();
+
+  void Stop();
+
+  /**
+   * Slave addresses of the counters seen on the bus.
+   */
+  auto Units() const -> std::vector<uint8_t>;
+
+  /**
+   * Register image of the unit as confirmed by its responses. Can be called from any thread.
+   * @return nullptr if unit has not been seen.
+   */
+  auto Image(uint8_t unit) const -> std::shared_ptr<Observed const>;
+
+  auto GetStatistics() const -> Statistics;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Counters of many ports. Every port is served by its own worker thread, so buses work in parallel and a slow or
+ * dead bus never delays the others, counters of a port are served one by one as they share the bus. Workers connect
+ * their counters (offline ones are retried), sample them every period and run fleet operations between samples.
+ */
+class Fleet
+{
+public:
+  struct Sample
+  {
+    size_t device{};                               ///< index of the device in the inventory
+    std::chrono::system_clock::time_point time;    ///< when the snapshot was received
+    ImpulseCounter30::Snapshot snapshot;
+  };
+
+  struct Health
+  {
+    bool connected{};                    ///< counter has been constructed (device answered once)
+    bool online{};                       ///< last exchange with the device succeeded
+    uint64_t samples{};
+    uint64_t failures{};                 ///< failed samples and connection attempts
+    uint32_t consecutiveFailures{};
+    std::chrono::system_clock::time_point lastSample;
+    std::string lastError;
+  };
+
+  /**
+   * @param samples samples of one port cycle.
+   */
+  using tSamples = std::function<void(std::vector<Sample> const& samples)>;
+
+  struct AlignedSample
+  {
+    size_t device{};                      ///< index of the device in the inventory
+    std::optional<int32_t> counterValue;  ///< empty if the counter is not connected or did not answer
+    std::chrono::microseconds skew{};     ///< middle of the exchange (taken as the moment of sampling) minus the tick
+    std::chrono::microseconds roundTrip{};
+  };
+
+  struct AlignedSnapshot
+  {
+    std::chrono::system_clock::time_point tick;
+    std::vector<AlignedSample> samples;   ///< in inventory order
+  };
+
+  /**
+   * @param device index of the device in the inventory.
+   */
+  using tConnected = std::function<void(size_t device)>;
+
+  using tOperation = std::function<bool(ImpulseCounter30& counter)>;
+
+  static constexpr auto RECONNECT_PERIOD = std::chrono::seconds{10};
+
+public:
+  /**
+   * @param inventory port path, serial options and slave address (BaseAddr) of every device.
+   * @param period sample period of every port, 0 - sample continuously.
+   */
+  explicit Fleet(std::vector<ImpulseCounter30::CommunicationOptions> const& inventory,
+                 std::chrono::milliseconds period = std::chrono::seconds{1});
+  ~Fleet();
+  Fleet(Fleet const&) = delete;
+  Fleet& operator=(Fleet const&) = delete;
+
+  /**
+   * Subscribe to samples of all devices, only before Start. Callbacks are called from port workers, never concurrently.
+   */
+  void OnSamples(tSamples samples);
+
+  /**
+   * Subscribe to connections of devices, only before Start. Callbacks are called from port workers, never concurrently.
+   */
+  void OnConnected(tConnected connected);
+
+  /**
+   * Start port workers and return at once, workers connect their counters in parallel. Offline devices are retried
+   * after the online ones of their port have been served, so they never delay them.
+   */
+  void Start();
+
+  /**
+   * Stop port workers, queued operations are completed first.
+   */
+  void Stop();
+
+  auto Size() const -> size_t;
+
+  auto GetHealth() const -> std::vector<Health>;
+
+  /**
+   * Latest sample of every device, empty until the first one.
+   */
+  auto GetLatest() const -> std::vector<std::optional<Sample>>;
+
+  /**
+   * Run operation on every connected counter and wait for all results. Ports run it in parallel between
+   * their samples, counters of a port one by one.
+   * @return result of every device, false for devices which are not connected; empty if fleet is not running.
+   */
+  auto ForEach(tOperation operation) -> std::vector<bool>;
+
+  /**
+   * Read counter values of all devices as simultaneously as possible. Every port reads its counters at the tick in
+   * parallel, counters of a port one by one in inventory order: the burst is started earlier by half of its duration
+   * (predicted from round trips of previous bursts), so the reads straddle the tick and the skew of every device
+   * stays nearly the same from tick to tick, which keeps deltas between ticks coherent.
+   * @param tick should leave workers time to complete their current exchange, a late port shows in skews.
+   * @return empty if fleet is not running.
+   */
+  auto SampleAligned(std::chrono::system_clock::time_point tick) -> std::optional<AlignedSnapshot>;
+
+  /**
+   * Reset counters of all devices by one broadcast frame per port, see ImpulseCounter30::BroadcastResetCount().
+   * @return true if frames were sent to all ports (a port without connected counter is not sent to).
+   */
+  bool BroadcastResetCount();
+
+  /**
+   * Start or stop counters of all devices by one broadcast frame per port, see ImpulseCounter30::BroadcastStartCounter().
+   * @return true if frames were sent to all ports (a port without connected counter is not sent to).
+   */
+  bool BroadcastStartCounter(bool isStart);
+
+  /**
+   * Metrics of all connected counters, see ImpulseCounter30::GetMetrics().
+   */
+  auto GetMetrics() const -> std::vector<DeviceMetrics>;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace OWEN {
+
+/**
+ * Process-wide log of raw Modbus frames of all counters to a compact binary file.
+ * Frames are put to a lock-free buffer by the transaction and written to the file by a background thread,
+ * so logging can be left on in production. Use framelog_OWEN_ImpulseCounter30 to print the file.
+ */
+namespace FrameLog {
+
+enum class eLevel
+{
+  OFF,
+  ERRORS,     ///< only request and response of failed transactions (timeout, bad frame, exception)
+  ALL         ///< every request and response
+};
+
+/**
+ * Open (truncate) log file and start writing to it.
+ * @return false if file could not be opened.
+ */
+bool Open(std::string const& path, eLevel level = eLevel::ALL);
+
+/**
+ * Stop logging, write out buffered frames and close the file.
+ */
+void Close();
+
+/**
+ * Change level at runtime, takes effect for the next transaction.
+ */
+void SetLevel(eLevel level);
+
+auto Level() -> eLevel;
+
+/**
+ * Count of frames lost because the buffer was full (writer could not keep up).
+ */
+auto Dropped() -> uint64_t;
+
+} /// end namespace FrameLog
+
+} /// end namespace OWEN
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <OWEN/Poller.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Modbus TCP server which exposes every counter of the pollers as a unit id with the device register layout.
+ * Reads (functions 0x01 - 0x04) are answered from the poller cache without touching the bus, writes
+ * (0x05, 0x06, 0x10) are queued to the poller of the unit and answered when the device confirmed them.
+ * Exceptions: 0x0A - unknown unit, 0x0B - unit has no image younger than maxAge or did not answer the write.
+ */
+class Gateway
+{
+public:
+  static constexpr uint16_t MODBUS_TCP_PORT = 502;
+
+public:
+  /**
+   * Start listening on all interfaces.
+   * @param port TCP port, 0 - any free port (see Port()).
+   * @param maxAge oldest cached image still served to clients.
+   * @throw std::runtime_error if the same unit is polled by several pollers,
+   *        boost::system::system_error if port could not be bound.
+   */
+  Gateway(std::vector<std::reference_wrapper<Poller>> const& pollers,
+          uint16_t port = MODBUS_TCP_PORT,
+          std::chrono::milliseconds maxAge = std::chrono::seconds{5});
+  ~Gateway();
+
+  auto Port() const -> uint16_t;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} /// end namespace OWEN
@@ -1,10 +1,18 @@
 #pragma once
 
+#include <OWEN/Metrics.hpp>
+
+#if defined(OWEN_COROUTINES)
+#include <OWEN/Task.hpp>
+#endif
+
+#include <future>
 #include <memory>
 #include <string>
 #include <optional>
 #include <functional>
 #include <stdexcept>
+#include <vector>
 
 namespace OWEN {
 
@@ -37,7 +45,11 @@ public:
 
      /**
       * Set port path.
-      * @param portPath path to the port or port name.
+      * @param portPath path to the port or port name, or URL of a Modbus TCP device or gateway (tcp://host[:port],
+      *                 default port 502) or of an Ethernet-RS485 gateway tunneling RTU frames (rtutcp://host:port),
+      *                 or port shared by the multiplexing daemon (mux://SOCKET_PATH#PORT_PATH, see MuxServer).
+      *                 Serial options are not used for URLs. Counters of the same port path share one open port
+      *                 (opened with the options of the first one), their exchanges never interleave.
       * @return reference to CommunicationOptions.
       */
      CommunicationOptions& PortPath(std::string portPath) {
@@ -123,6 +135,27 @@ public:
       return *this;
     }
 
+    /**
+     * Record all exchanges with the device to a capture file which can be replayed without hardware.
+     * @param capturePath path to the capture file, empty - do not capture.
+     * @return reference to CommunicationOptions.
+     */
+    CommunicationOptions& CapturePath(std::string capturePath) {
+      _capturePath = std::move(capturePath);
+      return *this;
+    }
+
+    /**
+     * Drive the serial port by the reactor shared by all such ports of the process instead of by the calling thread.
+     * Exchanges of idle ports cost no thread, so hundreds of ports can be served by a few threads (see MuxServer).
+     * Not used for URLs.
+     * @return reference to CommunicationOptions.
+     */
+    CommunicationOptions& SharedReactor(bool sharedReactor) {
+      _sharedReactor = sharedReactor;
+      return *this;
+    }
+
     std::string              _portPath;
     std::optional<eBaudrate> _baudrate;
     std::optional<bool> _dataBitsExtended;
@@ -131,6 +164,8 @@ public:
     std::optional<bool> _lengthAddrExtended;
     std::optional<uint16_t> _baseAddr;
     std::optional<uint8_t> _delayAnswerMs;
+    std::string              _capturePath;
+    std::optional<bool>      _sharedReactor;
   };
 
   using tFindProgress = std::function<bool(uint32_t currentProgress, uint32_t finishValue, CommunicationOptions const& communicationOptions)>;
@@ -356,6 +391,29 @@ public:
     COUNTING_PASWORD_NEEDED
   };
 
+  /**
+   * Current state of the counter read by the frames the device answers (see GetSnapshot()).
+   */
+  struct Snapshot
+  {
+    int32_t counterValue{};
+    int32_t counterEU{};
+    bool startStopMode{};
+    eCurrentMode currentMode{};
+    uint8_t codeErrNet{};
+  };
+
+  /**
+   * Raw values of the whole device register map at the device addresses (32 bit values are high word first).
+   */
+  struct RegisterImage
+  {
+    std::vector<bool> coils;
+    std::vector<bool> discreteInputs;
+    std::vector<uint16_t> holdingRegisters;
+    std::vector<uint16_t> inputRegisters;
+  };
+
 public:
   ImpulseCounter30(CommunicationOptions const& communicationOptions = {},
                    bool neededToBeFound = false,
@@ -364,11 +422,33 @@ public:
   ImpulseCounter30(ImpulseCounter30&&) noexcept;
   ImpulseCounter30& operator=(ImpulseCounter30&&) noexcept;
 
-  bool SetCommunicationOptions(CommunicationOptions const& communicationOptions);
+  /**
+   * Construct the counter in the background and return at once. Counters of different ports are constructed in
+   * parallel, counters of one port in the order of calls, so many devices come up in the time of their slowest port
+   * rather than of all of them. The port is not searched for the device.
+   * @return future of the counter, holds the exception of the constructor if the device did not answer.
+   */
+  static auto ConnectAsync(CommunicationOptions const& communicationOptions) -> std::future<ImpulseCounter30>;
+
+  /**
+   * Write communication options.
+   * @param communicationOptions only set options are written.
+   * @param readback if true written registers are verified in the same transaction (function 0x17),
+   *                 falls back to separate write and read when device does not support it.
+   * @return true if all options were written (and read back equal when readback requested).
+   */
+  bool SetCommunicationOptions(CommunicationOptions const& communicationOptions, bool readback = false);
 
   auto GetCommunicationOptions() -> std::optional<CommunicationOptions>;
 
-  bool SetCounterOptions(CounterOptions const& counterOptions);
+  /**
+   * Write counter options.
+   * @param counterOptions only set options are written.
+   * @param readback if true written registers are verified in the same transaction (function 0x17),
+   *                 falls back to separate write and read when device does not support it.
+   * @return true if all options were written (and read back equal when readback requested).
+   */
+  bool SetCounterOptions(CounterOptions const& counterOptions, bool readback = false);
 
   auto GetCounterOptions() -> std::optional<CounterOptions>;
 
@@ -376,6 +456,14 @@ public:
 
   auto GetCounterEU() -> std::optional<int32_t>;
 
+  /**
+   * Read counter value, EU value, start/stop mode, current mode and network error code by the frames the device
+   * answers: 0x0000-0x0001, 0x0002, 0x0003 and 0x0004-0x0006. The device does not answer reliably a read which
+   * crosses the registers of CounterEU, so they are read one at a time. The values are taken by four transactions,
+   * not at the same instant.
+   */
+  auto GetSnapshot() -> std::optional<Snapshot>;
+
   auto GetStartStopMode() -> std::optional<bool>;
 
   auto GetCurrentMode() -> std::optional<ImpulseCounter30::eCurrentMode>;
@@ -404,6 +492,119 @@ public:
 
   bool StopCounter(bool isStop);
 
+  /**
+   * Write counter options to all devices on the bus of this counter by broadcast (slave address 0).
+   * Contiguous options are sent in one frame, so a full profile costs one frame. Devices do not reply.
+   * @param turnaroundMs delay after each broadcast frame to let devices process it.
+   * @return true if all frames were sent.
+   */
+  bool BroadcastCounterOptions(CounterOptions const& counterOptions, uint16_t turnaroundMs = 100);
+
+  /**
+   * Reset counters of all devices on the bus of this counter by one broadcast frame.
+   * @param turnaroundMs delay after broadcast frame to let devices process it.
+   * @return true if frame was sent.
+   */
+  bool BroadcastResetCount(uint16_t turnaroundMs = 100);
+
+  /**
+   * Start or stop counters of all devices on the bus of this counter simultaneously by one broadcast frame.
+   * @param turnaroundMs delay after broadcast frame to let devices process it.
+   * @return true if frame was sent.
+   */
+  bool BroadcastStartCounter(bool isStart, uint16_t turnaroundMs = 100);
+
+  /**
+   * Read all coils, discrete inputs, holding and input registers with the minimal set of transactions.
+   */
+  auto GetRegisterImage() -> std::optional<RegisterImage>;
+
+  /**
+   * Raw coil write (function 0x05), address as in the device register map.
+   * @return true if device confirmed the write, see LastExceptionCode() if it was rejected.
+   */
+  bool WriteCoil(uint16_t address, bool isOn);
+
+  /**
+   * Raw holding registers write (function 0x10), addresses as in the device register map.
+   * @return true if device confirmed the write, see LastExceptionCode() if it was rejected.
+   */
+  bool WriteHoldingRegisters(uint16_t address, std::vector<uint16_t> const& values);
+
+  /**
+   * Exception code the device replied to the last request with.
+   * @return 0 if the last request was not rejected by the device (succeeded or got no valid reply).
+   */
+  auto LastExceptionCode() const -> uint8_t;
+
+#if defined(OWEN_COROUTINES)
+  /**
+   * Awaitable versions of the getters and setters above (library built with OWEN_COROUTINES), see Task. Exchanges
+   * are not blocking with CommunicationOptions::SharedReactor(), so workflows of any count of counters can run on
+   * the reactor thread; synchronous calls must not be made from there. The counter must outlive its tasks and a
+   * counter should run one task at a time.
+   */
+  auto SetCommunicationOptionsAsync(CommunicationOptions communicationOptions, bool readback = false) -> Task<bool>;
+
+  auto GetCommunicationOptionsAsync() -> Task<std::optional<CommunicationOptions>>;
+
+  auto SetCounterOptionsAsync(CounterOptions counterOptions, bool readback = false) -> Task<bool>;
+
+  auto GetCounterOptionsAsync() -> Task<std::optional<CounterOptions>>;
+
+  auto GetCounterValueAsync() -> Task<std::optional<int32_t>>;
+
+  auto GetCounterEUAsync() -> Task<std::optional<int32_t>>;
+
+  auto GetSnapshotAsync() -> Task<std::optional<Snapshot>>;
+
+  auto GetStartStopModeAsync() -> Task<std::optional<bool>>;
+
+  auto GetCurrentModeAsync() -> Task<std::optional<eCurrentMode>>;
+
+  auto GetCodeErrNetAsync() -> Task<std::optional<uint8_t>>;
+
+  auto GetNameDeviceAsync() -> Task<std::optional<std::string>>;
+
+  auto GetVersionAsync() -> Task<std::optional<std::string>>;
+
+  auto IsResetInputAsync() -> Task<std::optional<bool>>;
+
+  auto IsLockInputAsync() -> Task<std::optional<bool>>;
+
+  auto GetOutState1Async() -> Task<std::optional<bool>>;
+
+  auto GetOutState2Async() -> Task<std::optional<bool>>;
+
+  auto IsResetCountAsync() -> Task<std::optional<bool>>;
+
+  auto ResetCountAsync() -> Task<bool>;
+
+  auto ControlCounterFromProgramAsync(bool isEnabled) -> Task<bool>;
+
+  auto StartCounterAsync(bool isStart) -> Task<bool>;
+
+  auto StopCounterAsync(bool isStop) -> Task<bool>;
+
+  auto GetRegisterImageAsync() -> Task<std::optional<RegisterImage>>;
+
+  auto WriteCoilAsync(uint16_t address, bool isOn) -> Task<bool>;
+
+  auto WriteHoldingRegistersAsync(uint16_t address, std::vector<uint16_t> values) -> Task<bool>;
+#endif
+
+  /**
+   * Per-function transaction counters and latency histograms of this counter (its own address first),
+   * broadcasts sent on its bus are reported under address 0. Can be called from any thread.
+   */
+  auto GetMetrics() const -> std::vector<DeviceMetrics>;
+
+  /**
+   * Same as above, storage of metrics and its elements is reused, so a caller which keeps the vector
+   * does not allocate once all used functions have been seen.
+   */
+  void GetMetrics(std::vector<DeviceMetrics>& metrics) const;
+
 private:
   class Impl;
   std::unique_ptr<Impl> pImpl;
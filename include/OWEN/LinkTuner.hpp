@@ -0,0 +1,126 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Tuning of the link of the counters of one bus: the baudrate is stepped up for all counters together (a bus has one
+ * baudrate) and then DelayAnswer of every counter is stepped down, every step is measured with a burst of reads.
+ * Tuning settles on the last step whose error rate meets the budget. A step which misses it is rolled back: the
+ * previous setting is written again until the counter answers with it, counters which can not be reached with
+ * it are searched on other baudrates of their address. Counters keep working settings when tuning stops anywhere,
+ * only the rolled back step costs timeouts.
+ *
+ * Only baudrates the serial port can be set to are tried. Tuning opens the port itself, so no counter of the bus
+ * may be open meanwhile (shared ports keep the options they were opened with) and the master must be the only one
+ * on the bus.
+ */
+class LinkTuner
+{
+public:
+  using eBaudrate = ImpulseCounter30::CommunicationOptions::eBaudrate;
+
+  struct Options
+  {
+    eBaudrate maxBaudrate{eBaudrate::_115200bps};
+    uint8_t minDelayAnswerMs{};
+    uint32_t burstReads{50};        ///< reads of the counter value per counter and step
+    double errorBudget{0.02};       ///< tolerated share of failed reads of a burst
+  };
+
+  struct Step
+  {
+    eBaudrate baudrate{};
+    std::optional<uint8_t> address;      ///< counter whose DelayAnswer is tuned, empty for baudrate steps of all counters
+    uint8_t delayAnswerMs{};             ///< DelayAnswer of the tuned counter
+    uint32_t reads{};
+    uint32_t errors{};
+    std::chrono::microseconds meanRoundTrip{};   ///< of successful reads
+    bool accepted{};
+  };
+
+  struct Result
+  {
+    eBaudrate baudrate{};                      ///< the bus works with
+    std::map<uint8_t, uint8_t> delayAnswerMs;  ///< of every counter which answers with the baudrate
+    std::vector<Step> steps;
+    bool rolledBack{};
+    std::vector<uint8_t> lost;                 ///< counters which could not be brought back, not found on any baudrate
+  };
+
+  /**
+   * @param step called after every measured step.
+   */
+  using tProgress = std::function<void(Step const& step)>;
+
+public:
+  /**
+   * @param communicationOptions port path and current serial options of the bus, all of them have to be set.
+   * @param addresses slave addresses of all counters of the bus.
+   */
+  LinkTuner(ImpulseCounter30::CommunicationOptions const& communicationOptions, std::vector<uint8_t> addresses, Options options);
+
+  void OnProgress(tProgress progress);
+
+  /**
+   * Tune the link. Counters are opened with the current options first, nothing is changed if any of them does not
+   * answer.
+   * @throw std::runtime_error if a counter does not answer with the current options.
+   */
+  auto Run() -> Result;
+
+private:
+  using tCounters = std::map<uint8_t, std::unique_ptr<ImpulseCounter30>>;
+
+private:
+  /**
+   * Baudrates the port can be set to (termios of Linux has no 14400 and 28800), counters are never switched to others.
+   * The port must not be open.
+   */
+  auto SupportedBaudrates() const -> std::vector<eBaudrate>;
+
+  /**
+   * Counter of the address at the baudrate.
+   * @return nullptr if it does not answer.
+   */
+  auto Open(uint8_t address, eBaudrate baudrate) const -> std::unique_ptr<ImpulseCounter30>;
+
+  /**
+   * Read counter value burstReads times, the burst is cut when errors exceed the budget.
+   */
+  void Burst(ImpulseCounter30& counter, Step& step) const;
+
+  bool IsWithinBudget(Step const& step) const;
+
+  /**
+   * Step the baudrate of all counters up while the bus meets the budget.
+   * @return counters open at the baudrate the bus settled on.
+   */
+  auto TuneBaudrate(tCounters counters, Result& result) -> tCounters;
+
+  /**
+   * Bring counters which were switched to the failed baudrate back to the working one.
+   */
+  auto RollBackBaudrate(eBaudrate failed, eBaudrate working, Result& result) -> tCounters;
+
+  void TuneDelayAnswer(uint8_t address, ImpulseCounter30& counter, eBaudrate baudrate, Result& result);
+
+  void Report(Step const& step, Result& result) const;
+
+private:
+  ImpulseCounter30::CommunicationOptions _communicationOptions;
+  std::vector<uint8_t> _addresses;
+  Options _options;
+  tProgress _progress;
+  std::vector<eBaudrate> _baudrates;   ///< supported by the port, ascending
+};
+
+} /// end namespace OWEN
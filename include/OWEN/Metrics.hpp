@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Log-linear latency histogram in microseconds: every power of two is split into 8 linear sub-buckets,
+ * so a recorded value is known with 12.5% precision from 1 us up to 2^27 us (larger values go to the last bucket).
+ */
+struct LatencyHistogram
+{
+  static constexpr uint32_t SUB_BUCKET_BITS = 3;
+  static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+  static constexpr uint32_t MAX_VALUE_BITS = 27;
+  static constexpr uint32_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  static constexpr auto BucketOf(uint64_t valueUs) -> uint32_t
+  {
+    if (valueUs < 2 * SUB_BUCKET_COUNT)
+    {
+      return static_cast<uint32_t>(valueUs);
+    }
+    uint32_t msb{SUB_BUCKET_BITS + 1};
+    while (((valueUs >> (msb + 1)) != 0) && (msb < (MAX_VALUE_BITS - 1)))
+    {
+      ++msb;
+    }
+    auto const shift = msb - SUB_BUCKET_BITS;
+    auto const subBucket = static_cast<uint32_t>(valueUs >> shift);
+    if (subBucket >= 2 * SUB_BUCKET_COUNT)
+    {
+      return BUCKET_COUNT - 1;
+    }
+    return (shift + 1) * SUB_BUCKET_COUNT + (subBucket - SUB_BUCKET_COUNT);
+  }
+
+  static constexpr auto LowerBoundOf(uint32_t bucket) -> uint64_t
+  {
+    if (bucket < 2 * SUB_BUCKET_COUNT)
+    {
+      return bucket;
+    }
+    auto const shift = bucket / SUB_BUCKET_COUNT - 1;
+    return static_cast<uint64_t>(bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT) << shift;
+  }
+
+  /**
+   * @param percentile from 0.0 to 1.0.
+   * @return highest value of the bucket containing the percentile (not greater than maxUs), 0 if histogram is empty.
+   */
+  auto Percentile(double percentile) const -> uint64_t;
+
+  auto MeanUs() const -> double
+  {
+    return (count != 0) ? (static_cast<double>(sumUs) / count) : 0.0;
+  }
+
+  std::array<uint64_t, BUCKET_COUNT> counts{};
+  uint64_t count{};
+  uint64_t sumUs{};
+  uint64_t maxUs{};
+};
+
+/**
+ * Counters of one Modbus function of one device.
+ * requests = succeeded + timeouts + badFrames + exceptions, broadcast requests always succeed (no reply).
+ */
+struct FunctionMetrics
+{
+  uint8_t function{};
+  uint64_t requests{};
+  uint64_t timeouts{};        ///< nothing received in time
+  uint64_t badFrames{};       ///< incomplete reply, wrong CRC, address, function or length
+  uint64_t exceptions{};      ///< exception reply of the device
+  uint64_t bytesSent{};
+  uint64_t bytesReceived{};
+  LatencyHistogram latency;   ///< request send to reply (or timeout) time
+};
+
+struct DeviceMetrics
+{
+  uint8_t address{};
+  std::vector<FunctionMetrics> functions;   ///< only functions which have been used
+};
+
+std::ostream& operator<<(std::ostream& out, OWEN::DeviceMetrics const& deviceMetrics);
+
+} /// end namespace OWEN
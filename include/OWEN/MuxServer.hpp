@@ -0,0 +1,48 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * Core of the multiplexing daemon: owns the ports and serves Modbus transactions of local processes
+ * (counters with mux://SOCKET_PATH#PORT_PATH port path) over a Unix domain socket.
+ * Transactions of every port are sent one by one by its own thread, or by the shared reactor thread for serial ports
+ * opened with CommunicationOptions::SharedReactor (all such ports are then served by one thread). Identical read requests (functions 0x01 - 0x04)
+ * which are queued or in flight are served by one bus transaction, its response is sent to all of them (single-flight).
+ * A request never shares the transaction of a request queued before its own previous request, so every client
+ * reads its own writes back.
+ */
+class MuxServer
+{
+public:
+  struct Counters
+  {
+    uint64_t requests{};       ///< transactions and broadcasts requested by clients
+    uint64_t transactions{};   ///< transactions and broadcasts sent to the ports
+    uint64_t coalesced{};      ///< requests served by the transaction of another request
+    uint64_t connections{};    ///< clients accepted since start
+  };
+
+public:
+  /**
+   * Open the ports and start listening, a stale socket file is replaced.
+   * @param ports port path and serial options of every served port.
+   * @throw boost::system::system_error if a port could not be opened or socket could not be bound.
+   */
+  MuxServer(std::string const& socketPath, std::vector<ImpulseCounter30::CommunicationOptions> const& ports);
+  ~MuxServer();
+
+  auto GetCounters() const -> Counters;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OWEN {
+
+class SnapshotPublisher;
+
+/**
+ * Register cache of the counters of one bus. A single scheduler thread reads register images of all counters
+ * every period and sends queued writes ahead of the next read, so any number of consumers of the cache
+ * cost the bus the same as one.
+ */
+class Poller
+{
+public:
+  struct Cached
+  {
+    ImpulseCounter30::RegisterImage image;
+    std::chrono::steady_clock::time_point time;   ///< when the image was read
+  };
+
+  struct WriteRequest
+  {
+    enum class eKind
+    {
+      COIL,
+      HOLDING_REGISTERS
+    };
+
+    eKind kind{};
+    uint16_t address{};
+    std::vector<uint16_t> values;   ///< single 0/1 value for a coil
+  };
+
+  /**
+   * @param written true if device confirmed the write.
+   * @param exceptionCode exception code the device rejected the write with, 0 if it did not reply.
+   */
+  using tWriteDone = std::function<void(bool written, uint8_t exceptionCode)>;
+
+public:
+  explicit Poller(std::chrono::milliseconds period = std::chrono::milliseconds{100});
+  ~Poller();
+  Poller(Poller const&) = delete;
+  Poller& operator=(Poller const&) = delete;
+
+  /**
+   * Add counter, only before Start.
+   * @param unit identifier the counter is known by to consumers (usually its slave address).
+   * @throw std::runtime_error if unit is already added.
+   */
+  void Add(uint8_t unit, ImpulseCounter30 counter);
+
+  /**
+   * Publish snapshot (counter values and status) of every counter to a shared memory segment after each poll,
+   * only before Start. Other processes read it with SnapshotShm::Reader. Pollers of different buses can publish
+   * to the same segment when their units differ.
+   * @param shmName POSIX shared memory object name ("/owen-si30").
+   * @throw std::runtime_error if segment could not be created.
+   */
+  void Publish(std::string const& shmName);
+
+  void Start();
+
+  /**
+   * Stop scheduler thread, queued writes are completed as not written.
+   */
+  void Stop();
+
+  auto Units() const -> std::vector<uint8_t>;
+
+  /**
+   * Last successfully read image of the unit, never touches the bus. Can be called from any thread.
+   * @return nullptr if unit is unknown or has not been read yet.
+   */
+  auto Image(uint8_t unit) const -> std::shared_ptr<Cached const>;
+
+  /**
+   * Queue write to the unit. Written values are put to the cached image before done is called, so consumers
+   * read their writes back (side effects of the write are seen after the next poll).
+   * @param done called from the scheduler thread.
+   * @return false if unit is unknown or poller is stopped, done is not called then.
+   */
+  bool Write(uint8_t unit, WriteRequest request, tWriteDone done);
+
+  /**
+   * Per-device metrics of all counters, see ImpulseCounter30::GetMetrics().
+   */
+  auto GetMetrics() const -> std::vector<DeviceMetrics>;
+
+  /**
+   * Metrics of one counter to caller kept storage, see ImpulseCounter30::GetMetrics(std::vector<DeviceMetrics>&).
+   * @return false if unit is unknown.
+   */
+  bool GetMetrics(uint8_t unit, std::vector<DeviceMetrics>& metrics) const;
+
+private:
+  struct Device
+  {
+    ImpulseCounter30 counter;
+    std::shared_ptr<Cached const> cached;
+  };
+
+  struct PendingWrite
+  {
+    uint8_t unit{};
+    WriteRequest request;
+    tWriteDone done;
+  };
+
+private:
+  void Run();
+
+  void Poll(uint8_t unit, Device& device);
+
+  /**
+   * Send all queued writes.
+   */
+  void ExecuteWrites();
+
+  /**
+   * Put confirmed write to the cached image.
+   */
+  void Apply(Device& device, WriteRequest const& request);
+
+private:
+  std::chrono::milliseconds _period;
+  std::map<uint8_t, Device> _devices;   ///< not changed after Start
+  mutable std::mutex _mutex;            ///< guards cached images and write queue
+  std::condition_variable _wakeUp;
+  std::deque<PendingWrite> _writes;
+  std::shared_ptr<SnapshotPublisher> _publisher;
+  std::atomic<bool> _running{};
+  std::thread _thread;
+};
+
+} /// end namespace OWEN
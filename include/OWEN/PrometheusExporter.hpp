@@ -0,0 +1,46 @@
+#pragma once
+
+#include <OWEN/Poller.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OWEN {
+
+/**
+ * HTTP server of GET /metrics in the Prometheus text format (OpenMetrics if the scraper asks for it).
+ * Everything is rendered from the poller cache and transaction metrics, a scrape never touches the bus.
+ * Per counter: counter value, EU value, counting state, current mode, output states, network error code and
+ * age of the image; per counter and Modbus function: transaction, error and byte counters and latency histogram.
+ * Scrapes are served one by one by a single thread into buffers kept between scrapes, so once they have grown
+ * to the size of the response a scrape does not allocate.
+ */
+class PrometheusExporter
+{
+public:
+  static constexpr uint16_t DEFAULT_PORT = 9630;
+
+public:
+  /**
+   * Start listening.
+   * @param port TCP port, 0 - any free port (see Port()).
+   * @param address address to listen on, localhost by default.
+   * @throw std::runtime_error if the same unit is polled by several pollers,
+   *        boost::system::system_error if port could not be bound.
+   */
+  PrometheusExporter(std::vector<std::reference_wrapper<Poller>> const& pollers,
+                     uint16_t port = DEFAULT_PORT,
+                     std::string const& address = "127.0.0.1");
+  ~PrometheusExporter();
+
+  auto Port() const -> uint16_t;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace OWEN {
+
+/**
+ * Latest snapshot of every polled counter in a POSIX shared memory segment (see Poller::Publish).
+ * The segment has a slot per unit id, every slot is a seqlock: the sequence is odd while the publisher writes
+ * the slot and is incremented again when it is done, so a reader which sees the same even sequence before and
+ * after copying the slot has a consistent snapshot. This header is all other processes need to read it (link -lrt
+ * with glibc older than 2.34).
+ */
+namespace SnapshotShm {
+
+constexpr uint32_t MAGIC = 0x534E5753;   ///< "SWNS" in memory
+constexpr uint32_t VERSION = 1;
+constexpr size_t SLOT_COUNT = 256;       ///< slot index is the unit id
+
+/**
+ * Snapshot as it is stored in the slot.
+ */
+struct Snapshot
+{
+  int32_t counterValue{};
+  int32_t counterEU{};
+  uint8_t startStopMode{};
+  uint8_t currentMode{};   ///< ImpulseCounter30::eCurrentMode
+  uint8_t codeErrNet{};
+  uint8_t reserved{};
+  uint32_t updates{};      ///< count of successful polls of the device
+  int64_t timeNs{};        ///< wall clock time of the poll in ns since epoch
+};
+
+constexpr size_t WORD_COUNT = (sizeof(Snapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+/**
+ * Snapshot is copied word by word with relaxed atomics, so a concurrent write is never a data race.
+ */
+struct alignas(64) Slot
+{
+  std::atomic<uint32_t> sequence;   ///< 0 - never written
+  std::atomic<uint64_t> words[WORD_COUNT];
+};
+
+struct Segment
+{
+  std::atomic<uint32_t> magic;      ///< written last by the publisher
+  uint32_t version;
+  uint32_t slotCount;
+  Slot slots[SLOT_COUNT];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory atomics have to be lock-free");
+
+enum class eRead
+{
+  OK,
+  EMPTY,     ///< unit has never been published
+  TORN       ///< publisher was writing the slot, try again
+};
+
+/**
+ * Publisher side of the seqlock, the only writer of the slot.
+ */
+inline void Write(Slot& slot, Snapshot const& snapshot)
+{
+  uint64_t words[WORD_COUNT]{};
+  std::memcpy(words, &snapshot, sizeof(snapshot));
+  auto const sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < WORD_COUNT; ++i)
+  {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * Single wait-free attempt to copy the slot.
+ */
+inline auto TryRead(Slot const& slot, Snapshot& snapshot) -> eRead
+{
+  auto const before = slot.sequence.load(std::memory_order_acquire);
+  if (before == 0)
+  {
+    return eRead::EMPTY;
+  }
+  if ((before & 1) != 0)
+  {
+    return eRead::TORN;
+  }
+  uint64_t words[WORD_COUNT];
+  for (size_t i = 0; i < WORD_COUNT; ++i)
+  {
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != before)
+  {
+    return eRead::TORN;
+  }
+  std::memcpy(&snapshot, words, sizeof(snapshot));
+  return eRead::OK;
+}
+
+/**
+ * Read-only mapping of the segment.
+ */
+class Reader
+{
+public:
+  /**
+   * @param name shared memory object name, as given to Poller::Publish ("/owen-si30").
+   * @throw std::runtime_error if segment does not exist or is not a snapshot segment of this version.
+   */
+  explicit Reader(std::string const& name)
+  {
+    auto const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+      throw std::runtime_error("Could not open shared memory " + name);
+    }
+    auto* memory = ::mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+      throw std::runtime_error("Could not map shared memory " + name);
+    }
+    _segment = static_cast<Segment const*>(memory);
+    if ((_segment->magic.load(std::memory_order_acquire) != MAGIC) || (_segment->version != VERSION))
+    {
+      ::munmap(memory, sizeof(Segment));
+      throw std::runtime_error("Shared memory " + name + " is not a snapshot segment of version " + std::to_string(VERSION));
+    }
+  }
+
+  ~Reader()
+  {
+    ::munmap(const_cast<Segment*>(_segment), sizeof(Segment));
+  }
+
+  Reader(Reader const&) = delete;
+  Reader& operator=(Reader const&) = delete;
+
+  auto TryRead(uint8_t unit, Snapshot& snapshot) const -> eRead
+  {
+    return SnapshotShm::TryRead(_segment->slots[unit], snapshot);
+  }
+
+  /**
+   * Retry torn reads, a slot is written in tens of nanoseconds so a few attempts are enough.
+   */
+  auto Read(uint8_t unit, Snapshot& snapshot, uint32_t attempts = 16) const -> eRead
+  {
+    auto result = eRead::TORN;
+    for (uint32_t i = 0; (i < attempts) && (result == eRead::TORN); ++i)
+    {
+      result = TryRead(unit, snapshot);
+    }
+    return result;
+  }
+
+private:
+  Segment const* _segment{};
+};
+
+} /// end namespace SnapshotShm
+
+} /// end namespace OWEN
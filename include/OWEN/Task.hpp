@@ -0,0 +1,239 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+
+namespace OWEN {
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+/**
+ * Final suspension of a task: resume the awaiting coroutine or, for a started task, report and free the frame.
+ */
+struct TaskFinal
+{
+  bool await_ready() noexcept
+  {
+    return false;
+  }
+
+  template <typename Promise>
+  auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> std::coroutine_handle<>
+  {
+    auto& promise = handle.promise();
+    if (promise.continuation)
+    {
+      return promise.continuation;
+    }
+    promise.Finish(handle);
+    return std::noop_coroutine();
+  }
+
+  void await_resume() noexcept
+  {
+  }
+};
+
+template <typename T>
+struct TaskPromise
+{
+  using tDone = std::function<void(T result)>;
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+  std::optional<T> value;
+  tDone done;
+
+  auto get_return_object() -> Task<T>;
+
+  std::suspend_always initial_suspend() noexcept
+  {
+    return {};
+  }
+
+  TaskFinal final_suspend() noexcept
+  {
+    return {};
+  }
+
+  template <typename U>
+  void return_value(U&& result)
+  {
+    value.emplace(std::forward<U>(result));
+  }
+
+  void unhandled_exception()
+  {
+    exception = std::current_exception();
+  }
+
+  auto Result() -> T
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+    return std::move(value.value());
+  }
+
+  void Finish(std::coroutine_handle<> handle)
+  {
+    auto finished = std::move(done);
+    auto result = Result();
+    handle.destroy();
+    if (finished)
+    {
+      finished(std::move(result));
+    }
+  }
+};
+
+template <>
+struct TaskPromise<void>
+{
+  using tDone = std::function<void()>;
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+  tDone done;
+
+  auto get_return_object() -> Task<void>;
+
+  std::suspend_always initial_suspend() noexcept
+  {
+    return {};
+  }
+
+  TaskFinal final_suspend() noexcept
+  {
+    return {};
+  }
+
+  void return_void()
+  {
+  }
+
+  void unhandled_exception()
+  {
+    exception = std::current_exception();
+  }
+
+  void Result()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  void Finish(std::coroutine_handle<> handle)
+  {
+    auto finished = std::move(done);
+    Result();
+    handle.destroy();
+    if (finished)
+    {
+      finished();
+    }
+  }
+};
+
+} /// end namespace detail
+
+/**
+ * Lazy coroutine of the awaitable API (built with OWEN_COROUTINES). It runs when it is awaited by another coroutine
+ * or started, and resumes on the thread which completed its last exchange: with CommunicationOptions::SharedReactor()
+ * exchanges complete on the reactor thread, so any count of workflows runs on it; other transports complete the
+ * exchange in the calling thread before the coroutine goes on.
+ */
+template <typename T>
+class Task
+{
+public:
+  using promise_type = detail::TaskPromise<T>;
+
+public:
+  Task(Task&& other) noexcept
+    : _handle{std::exchange(other._handle, {})}
+  {
+  }
+
+  Task& operator=(Task&& other) noexcept
+  {
+    if (this != &other)
+    {
+      if (_handle)
+      {
+        _handle.destroy();
+      }
+      _handle = std::exchange(other._handle, {});
+    }
+    return *this;
+  }
+
+  ~Task()
+  {
+    if (_handle)
+    {
+      _handle.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  auto await_suspend(std::coroutine_handle<> continuation) noexcept -> std::coroutine_handle<>
+  {
+    _handle.promise().continuation = continuation;
+    return _handle;
+  }
+
+  auto await_resume() -> T
+  {
+    return _handle.promise().Result();
+  }
+
+  /**
+   * Run the task without awaiting it, the task owns itself until it completes. An exception which escapes the task
+   * terminates the process like one escaping a thread function.
+   * @param done called with the result on the thread which completed the task.
+   */
+  void Start(typename promise_type::tDone done = {}) &&
+  {
+    auto handle = std::exchange(_handle, {});
+    handle.promise().done = std::move(done);
+    handle.resume();
+  }
+
+private:
+  friend promise_type;
+
+  explicit Task(std::coroutine_handle<promise_type> handle)
+    : _handle{handle}
+  {
+  }
+
+private:
+  std::coroutine_handle<promise_type> _handle;
+};
+
+template <typename T>
+auto detail::TaskPromise<T>::get_return_object() -> Task<T>
+{
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline auto detail::TaskPromise<void>::get_return_object() -> Task<void>
+{
+  return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,325 @@
+#include <OWEN/BatchController.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace OWEN {
+
+namespace {
+
+/// Readings the rate is taken over, enough to smooth the quantization of counts of short intervals
+constexpr size_t RATE_WINDOW = 8;
+/// Readings before the rate is trusted for a prediction
+constexpr size_t MIN_READINGS = 3;
+/// Pulse periods without a change of the count which mean that the line has stopped
+constexpr double SETTLED_PERIODS = 3.0;
+
+using Seconds = std::chrono::duration<double>;
+
+/**
+ * Repeat the request until it succeeds or the deadline passes, a failure is only a lost frame on a noisy bus.
+ */
+template <typename Request>
+bool Repeat(std::chrono::steady_clock::time_point deadline, Request request)
+{
+  auto isDone = request();
+  while (!isDone && (std::chrono::steady_clock::now() < deadline))
+  {
+    isDone = request();
+  }
+  return isDone;
+}
+
+} /// end namespace anonymous
+
+BatchController::BatchController(ImpulseCounter30& counter, Options options)
+  : _counter{counter}
+  , _options{options}
+{
+}
+
+BatchController::~BatchController()
+{
+  if (!_savedOptions.has_value())
+  {
+    return;
+  }
+  try
+  {
+    _counter.SetCounterOptions(_savedOptions.value());
+  }
+  catch (std::exception const&)
+  {
+  }
+}
+
+auto BatchController::Run(int32_t target) -> std::optional<Batch>
+{
+  auto const start = std::chrono::steady_clock::now();
+  Batch batch;
+  batch.target = target;
+  auto const stoppedAt = (_options.stop == eStop::SOFTWARE) ? RunSoftware(batch) : RunSetPoint(batch);
+  if (!stoppedAt.has_value())
+  {
+    _counter.StartCounter(false);
+    return {};
+  }
+  batch.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  Learn(batch, stoppedAt.value());
+  return batch;
+}
+
+auto BatchController::GetStopLatency() const -> std::chrono::microseconds
+{
+  return _stopLatency.value_or(std::chrono::microseconds{});
+}
+
+void BatchController::SetStopLatency(std::chrono::microseconds stopLatency)
+{
+  _stopLatency = stopLatency;
+}
+
+auto BatchController::Read(Stream& stream) -> std::optional<Reading>
+{
+  auto const start = std::chrono::steady_clock::now();
+  auto const value = _counter.GetCounterValue();
+  auto const end = std::chrono::steady_clock::now();
+  if (!value.has_value())
+  {
+    return {};
+  }
+  auto const roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  stream.roundTrip = stream.window.empty() ? roundTrip : (stream.roundTrip + (roundTrip - stream.roundTrip) / 4);
+  Reading const reading{value.value(), start + (end - start) / 2};
+  if (stream.window.empty() || (reading.value != stream.window.back().value))
+  {
+    stream.lastAdvance = reading.time;
+  }
+  stream.window.push_back(reading);
+  if (stream.window.size() > RATE_WINDOW)
+  {
+    stream.window.pop_front();
+  }
+  auto const& first = stream.window.front();
+  auto const elapsed = Seconds(reading.time - first.time).count();
+  stream.rate = (elapsed > 0) ? ((reading.value - first.value) / elapsed) : 0.0;
+  return reading;
+}
+
+bool BatchController::IsStalled(Stream const& stream) const
+{
+  return (std::chrono::steady_clock::now() - stream.lastAdvance) > _options.stallTimeout;
+}
+
+bool BatchController::Start(Stream& stream)
+{
+  // Both writes are idempotent, so a write whose reply was lost is simply repeated
+  auto const deadline = std::chrono::steady_clock::now() + _options.stallTimeout;
+  auto const isStarted = Repeat(deadline, [this] { return _counter.ResetCount(); }) &&
+                         Repeat(deadline, [this] { return _counter.StartCounter(true); });
+  stream.lastAdvance = std::chrono::steady_clock::now();
+  return isStarted;
+}
+
+auto BatchController::Stop(Batch& batch) -> std::optional<int32_t>
+{
+  auto const deadline = std::chrono::steady_clock::now() + _options.stallTimeout;
+  std::optional<int32_t> count;
+  uint32_t attempts{};
+  auto const isStopped = Repeat(deadline, [&] {
+    ++attempts;
+    return _counter.StartCounter(false);
+  });
+  batch.isStopUncertain = (attempts > 1);
+  // Counting stops when the device processes the request, so the count is final once it has answered
+  if (isStopped)
+  {
+    Repeat(deadline, [&] {
+      count = _counter.GetCounterValue();
+      return count.has_value();
+    });
+  }
+  return count;
+}
+
+auto BatchController::RunSoftware(Batch& batch) -> std::optional<double>
+{
+  Stream stream;
+  if (!Start(stream))
+  {
+    return {};
+  }
+  std::optional<std::chrono::steady_clock::time_point> stopTime;
+  while (true)
+  {
+    // A failed read is only a gap in the stream, the batch fails when the count has not advanced for stallTimeout
+    auto const reading = Read(stream);
+    if (IsStalled(stream))
+    {
+      return {};
+    }
+    if (reading.has_value())
+    {
+      // Initial latency: the device acts on the request about the middle of the exchange
+      auto const latency = _stopLatency.value_or(stream.roundTrip / 2);
+      batch.rate = stream.rate;
+      batch.stopLatency = latency;
+      if (reading->value >= batch.target)
+      {
+        // Too short for a prediction, the rate jumped up or the reads failed until past the target
+        break;
+      }
+      if ((stream.window.size() >= MIN_READINGS) && (stream.rate > 0))
+      {
+        auto const toTarget = Seconds((batch.target - reading->value) / stream.rate);
+        stopTime = reading->time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(toTarget) - latency;
+      }
+    }
+    // The next reading is done a round trip later, the stop is timed now if it would be due before that.
+    // After a failed read the last prediction holds, a further read could cost another timeout.
+    if (stopTime.has_value() && (stopTime.value() <= (std::chrono::steady_clock::now() + stream.roundTrip)))
+    {
+      std::this_thread::sleep_until(stopTime.value());
+      break;
+    }
+  }
+  auto const& last = stream.window.back();
+  auto const stoppedAt = last.value + stream.rate * Seconds(std::chrono::steady_clock::now() - last.time).count();
+  batch.stopAt = static_cast<int32_t>(std::lround(stoppedAt));
+  auto const count = Stop(batch);
+  if (!count.has_value())
+  {
+    return {};
+  }
+  batch.count = count.value();
+  return stoppedAt;
+}
+
+auto BatchController::RunSetPoint(Batch& batch) -> std::optional<double>
+{
+  using CounterOptions = ImpulseCounter30::CounterOptions;
+  auto const deadline = std::chrono::steady_clock::now() + _options.stallTimeout;
+  if (!_savedOptions.has_value())
+  {
+    std::optional<CounterOptions> current;
+    if (!Repeat(deadline, [&] {
+      current = _counter.GetCounterOptions();
+      return current.has_value();
+    }))
+    {
+      return {};
+    }
+    CounterOptions saved;
+    saved._outputMode = current->_outputMode;
+    saved._pointMode = current->_pointMode;
+    saved._point1Threshold = current->_point1Threshold;
+    _savedOptions = saved;
+  }
+  if (!_isSetPointConfigured)
+  {
+    // The output switches at the set point and stays on until reset, pulses of the coasting line are still counted
+    auto const options = CounterOptions{}.OutputMode(CounterOptions::eOutputMode::TURNED_ON_ABOVE_THRESHOLD)
+                                         .SetPointMode(CounterOptions::ePointMode::CONTINUE_WITHOUT_RESET);
+    _isSetPointConfigured = Repeat(deadline, [&] { return _counter.SetCounterOptions(options); });
+    if (!_isSetPointConfigured)
+    {
+      return {};
+    }
+  }
+  auto const latency = _stopLatency.value_or(std::chrono::microseconds{});
+  auto const setPointFor = [&](double rate) {
+    auto const lead = static_cast<int32_t>(std::lround(rate * Seconds(latency).count()));
+    return std::clamp(batch.target - lead, 0, batch.target);
+  };
+  auto setPoint = setPointFor(_lastRate);
+  Stream stream;
+  if (!Repeat(deadline, [&] { return _counter.SetCounterOptions(CounterOptions{}.SetPoint1(setPoint)); }) || !Start(stream))
+  {
+    return {};
+  }
+  batch.stopLatency = latency;
+
+  auto isAdjusted = false;
+  while (true)
+  {
+    auto const reading = Read(stream);
+    if (IsStalled(stream))
+    {
+      return {};
+    }
+    if (!reading.has_value())
+    {
+      continue;
+    }
+    if (reading->value >= setPoint)
+    {
+      break;
+    }
+    batch.rate = stream.rate;
+    if (isAdjusted || (stream.window.size() < RATE_WINDOW) || (stream.rate <= 0))
+    {
+      continue;
+    }
+    // Once, with the rate of this batch, while the counter is below both set points by more than the write takes
+    isAdjusted = true;
+    auto const adjusted = setPointFor(stream.rate);
+    auto const margin = stream.rate * Seconds(stream.roundTrip * 2).count();
+    if ((adjusted != setPoint) && ((reading->value + margin) < std::min(adjusted, setPoint)))
+    {
+      // Without the reply the write may or may not have been applied, the line stops at the lower one at the latest
+      batch.isStopUncertain = !_counter.SetCounterOptions(CounterOptions{}.SetPoint1(adjusted));
+      setPoint = batch.isStopUncertain ? std::min(adjusted, setPoint) : adjusted;
+    }
+  }
+  batch.stopAt = setPoint;
+  auto const count = Settle(stream, batch.rate);
+  if (!count.has_value())
+  {
+    return {};
+  }
+  batch.count = count.value();
+  return static_cast<double>(setPoint);
+}
+
+auto BatchController::Settle(Stream& stream, double rate) -> std::optional<int32_t>
+{
+  auto const quiet = std::max<std::chrono::steady_clock::duration>(
+          stream.roundTrip, std::chrono::duration_cast<std::chrono::steady_clock::duration>(Seconds(SETTLED_PERIODS / std::max(rate, 1.0))));
+  auto const deadline = std::chrono::steady_clock::now() + _options.stallTimeout;
+  auto last = stream.window.back().value;
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(quiet);
+    auto const reading = Read(stream);
+    if (!reading.has_value())
+    {
+      continue;
+    }
+    if (reading->value == last)
+    {
+      return last;
+    }
+    last = reading->value;
+  }
+  return {};
+}
+
+void BatchController::Learn(Batch const& batch, double stoppedAt)
+{
+  if ((batch.rate <= 0) || batch.isStopUncertain)
+  {
+    return;
+  }
+  _lastRate = batch.rate;
+  // Pulses counted after the stop was issued took this long at the rate of the batch
+  auto const observed = std::chrono::duration_cast<std::chrono::microseconds>(Seconds(std::max(0.0, (batch.count - stoppedAt) / batch.rate)));
+  if (!_stopLatency.has_value())
+  {
+    _stopLatency = observed;
+    return;
+  }
+  _stopLatency = _stopLatency.value() + std::chrono::duration_cast<std::chrono::microseconds>((observed - _stopLatency.value()) * _options.learningRate);
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,185 @@
+#include "BusReassembler.hpp"
+
+#include "ModBusCodec.hpp"
+
+#include <iterator>
+#include <utility>
+
+namespace {
+
+/// Exception response, the shortest frame
+constexpr size_t MIN_FRAME_SIZE = 5;
+constexpr uint8_t BROADCAST_ADDRESS = 0;
+/// Start, stop, parity (or second stop) and 8 data bits
+constexpr uint32_t BITS_PER_CHARACTER = 11;
+
+auto Byte(std::string const& frame, size_t offset) -> uint8_t
+{
+  return static_cast<uint8_t>(frame[offset]);
+}
+
+} /// end namespace anonymous
+
+auto BusReassembler::FrameGap(uint32_t baudrate) -> std::chrono::microseconds
+{
+  if ((baudrate == 0) || (baudrate > 19200))
+  {
+    return std::chrono::microseconds{1750};
+  }
+  return std::chrono::microseconds{(35 * BITS_PER_CHARACTER * 1000000ULL) / (10ULL * baudrate)};
+}
+
+BusReassembler::BusReassembler(uint32_t baudrate, std::chrono::microseconds gap, tTransaction transaction)
+  : _characterTime{std::chrono::nanoseconds{(BITS_PER_CHARACTER * 1000000000ULL) / ((baudrate == 0) ? 115200 : baudrate)}}
+  , _gap{(gap.count() == 0) ? FrameGap(baudrate) : gap}
+  , _transaction{std::move(transaction)}
+{
+}
+
+void BusReassembler::Feed(char const* data, size_t size, std::chrono::steady_clock::time_point time)
+{
+  if (size == 0)
+  {
+    return;
+  }
+  // The chunk is read when its last byte has come, its first byte was on the wire earlier by the size of the chunk
+  auto const firstByte = time - _characterTime * static_cast<int64_t>(size);
+  if (!_buffer.empty() && ((firstByte - _lastByte) > _gap))
+  {
+    Discard(_buffer.size());
+  }
+  _lastByte = time;
+  _buffer.append(data, size);
+  auto const wallTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+          std::chrono::system_clock::now() - (std::chrono::steady_clock::now() - time));
+  Split(wallTime);
+}
+
+auto BusReassembler::RequestSize() const -> std::optional<size_t>
+{
+  switch (Byte(_buffer, 1))
+  {
+    case 0x01:
+    case 0x02:
+    case 0x03:
+    case 0x04:
+    case 0x05:
+    case 0x06:
+      return 8;
+    case 0x0F:
+    case 0x10:
+      if (_buffer.size() < 7)
+      {
+        return {};
+      }
+      return 7 + Byte(_buffer, 6) + 2;
+    case 0x17:
+      if (_buffer.size() < 11)
+      {
+        return {};
+      }
+      return 11 + Byte(_buffer, 10) + 2;
+    default:
+      return 0;
+  }
+}
+
+auto BusReassembler::ResponseSize() const -> std::optional<size_t>
+{
+  if (_pending.empty() || (Byte(_buffer, 0) != Byte(_pending, 0)))
+  {
+    return 0;
+  }
+  auto const function = Byte(_pending, 1);
+  if (Byte(_buffer, 1) == (function | ModBusCodec::EXCEPTION_FLAG))
+  {
+    return MIN_FRAME_SIZE;
+  }
+  if (Byte(_buffer, 1) != function)
+  {
+    return 0;
+  }
+  switch (function)
+  {
+    case 0x01:
+    case 0x02:
+    case 0x03:
+    case 0x04:
+    case 0x17:
+      return 3 + Byte(_buffer, 2) + 2;
+    case 0x05:
+    case 0x06:
+    case 0x0F:
+    case 0x10:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+void BusReassembler::Split(std::chrono::system_clock::time_point time)
+{
+  while (_buffer.size() >= MIN_FRAME_SIZE)
+  {
+    // Response first: responses to single writes echo their requests
+    std::optional<size_t> const sizes[] = {ResponseSize(), RequestSize()};
+    auto isWaiting = false;
+    auto isTaken = false;
+    for (size_t i = 0; (i < std::size(sizes)) && !isTaken; ++i)
+    {
+      if (!sizes[i].has_value() || (sizes[i].value() > _buffer.size()))
+      {
+        isWaiting = true;
+        continue;
+      }
+      if ((sizes[i].value() == 0) || !ModBusCodec::IsCrcValid(_buffer.substr(0, sizes[i].value())))
+      {
+        continue;
+      }
+      auto frame = _buffer.substr(0, sizes[i].value());
+      _buffer.erase(0, sizes[i].value());
+      ++_statistics.frames;
+      isTaken = true;
+      if (i == 0)
+      {
+        ++_statistics.transactions;
+        _transaction(Transaction{std::exchange(_pending, {}), std::move(frame), time});
+      }
+      else
+      {
+        Request(std::move(frame));
+      }
+    }
+    if (isTaken)
+    {
+      continue;
+    }
+    if (isWaiting)
+    {
+      return;
+    }
+    // Noise or a frame of unknown function, look for the next frame from the following byte
+    Discard(1);
+  }
+}
+
+void BusReassembler::Request(std::string frame)
+{
+  if (!_pending.empty())
+  {
+    ++_statistics.unanswered;
+  }
+  _pending.clear();
+  if (Byte(frame, 0) == BROADCAST_ADDRESS)
+  {
+    ++_statistics.broadcasts;
+    return;
+  }
+  _pending = std::move(frame);
+}
+
+void BusReassembler::Discard(size_t count)
+{
+  _buffer.erase(0, count);
+  _statistics.discardedBytes += count;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+/**
+ * Reassembly of ModBus RTU transactions from raw bytes of a bus driven by another master, no I/O. A silence of
+ * t3.5 on the line ends the frame: bytes of a frame which is incomplete at the silence are discarded. Frames which
+ * follow each other without the silence being seen (the reader got them in one chunk) are split by their size, taken
+ * from the function code, and told apart by crc; a frame is a response if it comes from the slave the pending
+ * request was sent to and carries its function.
+ */
+class BusReassembler
+{
+public:
+  struct Transaction
+  {
+    std::string request;
+    std::string response;                           ///< normal or exception response with valid crc
+    std::chrono::system_clock::time_point time;     ///< when the response was received
+  };
+
+  struct Statistics
+  {
+    uint64_t frames{};          ///< frames with valid crc
+    uint64_t transactions{};
+    uint64_t unanswered{};      ///< requests (not broadcasts) followed by another request instead of the response
+    uint64_t broadcasts{};
+    uint64_t discardedBytes{};  ///< bytes of broken frames and noise
+  };
+
+  using tTransaction = std::function<void(Transaction const& transaction)>;
+
+  /**
+   * Silence which ends the frame, 3.5 characters and fixed 1.75 ms above 19200 bps as the RTU specification says.
+   */
+  static auto FrameGap(uint32_t baudrate) -> std::chrono::microseconds;
+
+public:
+  /**
+   * @param baudrate of the line, gives the time of a character on the wire.
+   * @param gap silence which ends the frame, 0 - FrameGap(baudrate). USB adapters deliver bytes late by their latency
+   *        timer, so a gap of a few milliseconds may be seen inside a frame, it has to be raised for them.
+   */
+  BusReassembler(uint32_t baudrate, std::chrono::microseconds gap, tTransaction transaction);
+
+  /**
+   * Bytes read from the line, all received by time. Completed transactions are reported before the call returns.
+   */
+  void Feed(char const* data, size_t size, std::chrono::steady_clock::time_point time);
+
+  auto GetStatistics() const -> Statistics const&
+  {
+    return _statistics;
+  }
+
+private:
+  /**
+   * Size of the frame at the start of the buffer.
+   * @return 0 if frame can not be of this kind, empty if more bytes are needed to tell the size.
+   */
+  auto RequestSize() const -> std::optional<size_t>;
+  auto ResponseSize() const -> std::optional<size_t>;
+
+  /**
+   * Take complete frames from the start of the buffer.
+   */
+  void Split(std::chrono::system_clock::time_point time);
+
+  void Request(std::string frame);
+
+  void Discard(size_t count);
+
+private:
+  std::chrono::nanoseconds _characterTime;
+  std::chrono::nanoseconds _gap;
+  tTransaction _transaction;
+  std::string _buffer;
+  std::chrono::steady_clock::time_point _lastByte;
+  std::string _pending;                     ///< request awaiting its response
+  Statistics _statistics;
+};
@@ -0,0 +1,479 @@
+#include <OWEN/BusSniffer.hpp>
+
+#include "BusReassembler.hpp"
+#include "ModBusCodec.hpp"
+#include "SI30RegisterMap.hpp"
+#include "SerialLine.hpp"
+#include "SnapshotPublisher.hpp"
+#include "TransportFactory.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace OWEN {
+
+namespace {
+
+constexpr uint16_t COILS_COUNT = SI30::StartCounter::address + SI30::StartCounter::width;
+constexpr uint16_t DISCRETE_INPUTS_COUNT = SI30::LockInput::address + SI30::LockInput::width;
+constexpr uint16_t HOLDING_REGISTERS_COUNT = SI30::Password::address + SI30::Password::width;
+constexpr uint16_t INPUT_REGISTERS_COUNT = SI30::Version::address + SI30::Version::width;
+
+/// Input registers of the snapshot, CounterValue to CodeErrNet
+constexpr uint16_t SNAPSHOT_FIRST = SI30::CounterValue::address;
+constexpr uint16_t SNAPSHOT_END = SI30::CodeErrNet::address + SI30::CodeErrNet::width;
+
+auto ReadOnly(SerialLineSettings settings) -> SerialLineSettings
+{
+  settings.isReadOnly = true;
+  return settings;
+}
+
+/**
+ * Stamp of a value of registers from the address: the older one of them.
+ */
+template <typename Reg>
+auto StampOf(std::vector<BusSniffer::Stamp> const& stamps) -> BusSniffer::Stamp
+{
+  auto const first = std::next(stamps.cbegin(), Reg::address);
+  return *std::min_element(first, std::next(first, Reg::width), [](auto const& lhs, auto const& rhs) {
+    return lhs.transaction < rhs.transaction;
+  });
+}
+
+auto Byte(std::string const& frame, size_t offset) -> uint8_t
+{
+  return static_cast<uint8_t>(frame[offset]);
+}
+
+/**
+ * Put values to the table from the start address, values beyond the register map are dropped.
+ */
+template <typename Table, typename Values>
+void Put(Table& table, uint16_t start, Values const& values)
+{
+  for (size_t i = 0; (i < values.size()) && ((start + i) < table.size()); ++i)
+  {
+    table[start + i] = values[i];
+  }
+}
+
+auto WrittenRegisters(std::string const& request, size_t offset, uint16_t count) -> std::vector<uint16_t>
+{
+  std::vector<uint16_t> values(count);
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    values[i] = ModBusCodec::Word(request, offset + i * 2);
+  }
+  return values;
+}
+
+auto WrittenBits(std::string const& request, size_t offset, uint16_t count) -> std::vector<bool>
+{
+  std::vector<bool> bits(count);
+  for (uint16_t bit = 0; bit < count; ++bit)
+  {
+    bits[bit] = (Byte(request, offset + bit / 8) & (1 << (bit % 8))) != 0;
+  }
+  return bits;
+}
+
+} /// end namespace anonymous
+
+class BusSniffer::Impl
+{
+public:
+  Impl(ImpulseCounter30::CommunicationOptions const& communicationOptions, std::vector<uint8_t> const& units, std::chrono::microseconds gap)
+    : _portPath{communicationOptions._portPath}
+    , _settings{ReadOnly(SerialSettingsOf(communicationOptions))}
+    , _units{units.cbegin(), units.cend()}
+    , _port{_io}
+    , _retry{_io}
+    , _reassembler{_settings.baudrate, gap, [this](BusReassembler::Transaction const& transaction) { Decode(transaction); }}
+  {
+  }
+
+  ~Impl()
+  {
+    Stop();
+  }
+
+  void OnSnapshot(tSnapshot snapshot)
+  {
+    if (_running)
+    {
+      throw std::runtime_error("Subscription can not be changed on running sniffer");
+    }
+    _snapshot = std::move(snapshot);
+  }
+
+  void Publish(std::string const& shmName)
+  {
+    if (_running)
+    {
+      throw std::runtime_error("Publishing can not be started on running sniffer");
+    }
+    _publisher = SnapshotPublisher::Open(shmName);
+  }
+
+  void Start()
+  {
+    if (_running)
+    {
+      return;
+    }
+    try
+    {
+      _settings.Open(_port, _portPath);
+    }
+    catch (boost::system::system_error const& ex)
+    {
+      throw std::runtime_error("Port " + _portPath + " could not be opened: " + ex.what());
+    }
+    _running = true;
+    _io.restart();
+    Read();
+    _thread = std::thread([this] { _io.run(); });
+  }
+
+  void Stop()
+  {
+    if (!_running.exchange(false))
+    {
+      return;
+    }
+    _io.stop();
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+    boost::system::error_code ignored;
+    _port.close(ignored);
+  }
+
+  auto Units() const -> std::vector<uint8_t>
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    std::vector<uint8_t> units;
+    for (auto const& device : _devices)
+    {
+      units.push_back(device.first);
+    }
+    return units;
+  }
+
+  auto Image(uint8_t unit) const -> std::shared_ptr<Observed const>
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto const it = _devices.find(unit);
+    return (it == _devices.cend()) ? nullptr : it->second.observed;
+  }
+
+  auto GetStatistics() const -> Statistics
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _statistics;
+  }
+
+private:
+  struct Device
+  {
+    std::shared_ptr<Observed const> observed;   ///< guarded by the mutex
+  };
+
+private:
+  void Read()
+  {
+    _port.async_read_some(boost::asio::buffer(_chunk), [this](boost::system::error_code const& error, size_t size) {
+      auto const time = std::chrono::steady_clock::now();
+      if (error == boost::asio::error::operation_aborted)
+      {
+        return;
+      }
+      if (error)
+      {
+        _reconnect.Lost(_port);
+        Reopen();
+        return;
+      }
+      _reassembler.Feed(_chunk.data(), size, time);
+      auto const& statistics = _reassembler.GetStatistics();
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _statistics.frames = statistics.frames;
+        _statistics.transactions = statistics.transactions;
+        _statistics.unanswered = statistics.unanswered;
+        _statistics.discardedBytes = statistics.discardedBytes;
+      }
+      Read();
+    });
+  }
+
+  void Reopen()
+  {
+    if (_reconnect.Reopen(_port, _portPath, _settings))
+    {
+      Read();
+      return;
+    }
+    _retry.expires_after(SerialReconnect::MIN_BACKOFF);
+    _retry.async_wait([this](boost::system::error_code const& error) {
+      if (!error)
+      {
+        Reopen();
+      }
+    });
+  }
+
+  /**
+   * Put confirmed transaction to the image of its unit, produce snapshot if the master read its registers.
+   */
+  void Decode(BusReassembler::Transaction const& transaction)
+  {
+    auto const unit = Byte(transaction.request, 0);
+    if (!_units.empty() && (_units.count(unit) == 0))
+    {
+      return;
+    }
+    if ((Byte(transaction.response, 1) & ModBusCodec::EXCEPTION_FLAG) != 0)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      ++_statistics.exceptions;
+      return;
+    }
+
+    Device* device{};
+    Observed observed;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      device = &_devices[unit];
+      if (device->observed)
+      {
+        observed = *device->observed;
+      }
+      else
+      {
+        observed.image = ImpulseCounter30::RegisterImage{std::vector<bool>(COILS_COUNT),
+                                                         std::vector<bool>(DISCRETE_INPUTS_COUNT),
+                                                         std::vector<uint16_t>(HOLDING_REGISTERS_COUNT),
+                                                         std::vector<uint16_t>(INPUT_REGISTERS_COUNT)};
+        observed.inputStamps.resize(INPUT_REGISTERS_COUNT);
+      }
+    }
+    auto const inputs = Apply(transaction, observed.image);
+    if (!inputs.has_value())
+    {
+      return;
+    }
+    ++_decoded;
+    observed.time = std::chrono::steady_clock::now();
+    for (auto address = inputs->first; (address < inputs->second) && (address < INPUT_REGISTERS_COUNT); ++address)
+    {
+      observed.inputStamps[address] = Stamp{_decoded, transaction.time};
+    }
+    auto const* input = observed.image.inputRegisters.data();
+    auto const isSnapshot = (inputs->first < SNAPSHOT_END) && (inputs->second > SNAPSHOT_FIRST) &&
+                            std::all_of(std::next(observed.inputStamps.cbegin(), SNAPSHOT_FIRST),
+                                        std::next(observed.inputStamps.cbegin(), SNAPSHOT_END),
+                                        [](Stamp const& stamp) { return stamp.transaction != 0; });
+    ImpulseCounter30::Snapshot snapshot{};
+    SnapshotStamps stamps{};
+    if (isSnapshot)
+    {
+      using namespace SI30;
+      snapshot = ImpulseCounter30::Snapshot{CounterValue::Decode(input + CounterValue::address),
+                                            CounterEU::Decode(input + CounterEU::address),
+                                            StartStopMode::Decode(input + StartStopMode::address),
+                                            CurrentMode::Decode(input + CurrentMode::address),
+                                            CodeErrNet::Decode(input + CodeErrNet::address)};
+      stamps = SnapshotStamps{StampOf<CounterValue>(observed.inputStamps),
+                              StampOf<CounterEU>(observed.inputStamps),
+                              StampOf<StartStopMode>(observed.inputStamps),
+                              StampOf<CurrentMode>(observed.inputStamps),
+                              StampOf<CodeErrNet>(observed.inputStamps)};
+    }
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      device->observed = std::make_shared<Observed const>(std::move(observed));
+      _statistics.snapshots += isSnapshot ? 1 : 0;
+    }
+    if (!isSnapshot)
+    {
+      return;
+    }
+    if (_publisher)
+    {
+      SnapshotShm::Snapshot published{};
+      published.counterValue = snapshot.counterValue;
+      published.counterEU = snapshot.counterEU;
+      published.startStopMode = snapshot.startStopMode;
+      published.currentMode = static_cast<uint8_t>(snapshot.currentMode);
+      published.codeErrNet = snapshot.codeErrNet;
+      published.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(transaction.time.time_since_epoch()).count();
+      _publisher->Publish(unit, published);
+    }
+    if (_snapshot)
+    {
+      _snapshot(unit, transaction.time, snapshot, stamps);
+    }
+  }
+
+  /**
+   * Put values the response confirms to the image.
+   * @return range of input registers read, empty range for other tables; empty if the transaction is not understood.
+   */
+  static auto Apply(BusReassembler::Transaction const& transaction, ImpulseCounter30::RegisterImage& image)
+          -> std::optional<std::pair<uint16_t, uint16_t>>
+  {
+    auto const& request = transaction.request;
+    auto const& response = transaction.response;
+    auto const unit = Byte(request, 0);
+    auto const function = Byte(request, 1);
+    auto const start = ModBusCodec::Word(request, 2);
+    auto const count = ModBusCodec::Word(request, 4);
+    std::pair<uint16_t, uint16_t> const none{0, 0};
+    switch (function)
+    {
+      case 0x01:
+      case 0x02:
+        if (!ModBusCodec::IsReadResponseValid(response, unit, function, count))
+        {
+          return {};
+        }
+        Put((function == 0x01) ? image.coils : image.discreteInputs, start, ModBusCodec::DecodeBits(response, count));
+        return none;
+      case 0x03:
+      case 0x04:
+        if (!ModBusCodec::IsReadResponseValid(response, unit, function, count))
+        {
+          return {};
+        }
+        Put((function == 0x03) ? image.holdingRegisters : image.inputRegisters, start, ModBusCodec::DecodeRegisters(response, count));
+        return (function == 0x04) ? std::make_pair(start, static_cast<uint16_t>(start + count)) : none;
+      case 0x05:
+      case 0x06:
+        // Responses echo the requests
+        if (response != request)
+        {
+          return {};
+        }
+        if (function == 0x05)
+        {
+          Put(image.coils, start, std::vector<bool>{count == 0xFF00});
+        }
+        else
+        {
+          Put(image.holdingRegisters, start, std::vector<uint16_t>{count});
+        }
+        return none;
+      case 0x0F:
+        if ((request.size() != static_cast<std::size_t>(9 + (count + 7) / 8)) || (response.size() != 8) || (response.compare(0, 6, request, 0, 6) != 0))
+        {
+          return {};
+        }
+        Put(image.coils, start, WrittenBits(request, 7, count));
+        return none;
+      case 0x10:
+        if ((request.size() != static_cast<std::size_t>(9 + count * 2)) || !ModBusCodec::IsWriteMultipleResponseValid(response, unit, start, count))
+        {
+          return {};
+        }
+        Put(image.holdingRegisters, start, WrittenRegisters(request, 7, count));
+        return none;
+      case 0x17:
+      {
+        auto const writeStart = ModBusCodec::Word(request, 6);
+        auto const writeCount = ModBusCodec::Word(request, 8);
+        if ((request.size() != static_cast<std::size_t>(13 + writeCount * 2)) || !ModBusCodec::IsReadResponseValid(response, unit, function, count))
+        {
+          return {};
+        }
+        // The device writes before it reads
+        Put(image.holdingRegisters, writeStart, WrittenRegisters(request, 11, writeCount));
+        Put(image.holdingRegisters, start, ModBusCodec::DecodeRegisters(response, count));
+        return none;
+      }
+      default:
+        return {};
+    }
+  }
+
+private:
+  std::string _portPath;
+  SerialLineSettings _settings;
+  std::set<uint8_t> _units;
+  tSnapshot _snapshot;
+  std::shared_ptr<SnapshotPublisher> _publisher;
+
+  boost::asio::io_service _io;
+  boost::asio::serial_port _port;
+  boost::asio::steady_timer _retry;
+  SerialReconnect _reconnect;
+  std::array<char, 256> _chunk{};
+  BusReassembler _reassembler;   ///< reader thread only
+  uint64_t _decoded{};           ///< transactions put to images, reader thread only
+  std::atomic<bool> _running{};
+  std::thread _thread;
+
+  mutable std::mutex _mutex;   ///< guards images and statistics
+  std::map<uint8_t, Device> _devices;
+  Statistics _statistics;
+};
+
+BusSniffer::BusSniffer(ImpulseCounter30::CommunicationOptions const& communicationOptions,
+                       std::vector<uint8_t> units,
+                       std::chrono::microseconds gap)
+  : pImpl{std::make_unique<Impl>(communicationOptions, units, gap)}
+{
+}
+
+BusSniffer::~BusSniffer() = default;
+
+void BusSniffer::OnSnapshot(tSnapshot snapshot)
+{
+  pImpl->OnSnapshot(std::move(snapshot));
+}
+
+void BusSniffer::Publish(std::string const& shmName)
+{
+  pImpl->Publish(shmName);
+}
+
+void BusSniffer::Start()
+{
+  pImpl->Start();
+}
+
+void BusSniffer::Stop()
+{
+  pImpl->Stop();
+}
+
+auto BusSniffer::Units() const -> std::vector<uint8_t>
+{
+  return pImpl->Units();
+}
+
+auto BusSniffer::Image(uint8_t unit) const -> std::shared_ptr<Observed const>
+{
+  return pImpl->Image(unit);
+}
+
+auto BusSniffer::GetStatistics() const -> Statistics
+{
+  return pImpl->GetStatistics();
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,33 @@
+#include "CaptureWriter.hpp"
+
+#include <iomanip>
+#include <stdexcept>
+
+CaptureWriter::CaptureWriter(std::string const& capturePath, std::string const& portPath)
+  : _file{capturePath, std::ios::trunc}
+  , _start{std::chrono::steady_clock::now()}
+{
+  if (!_file)
+  {
+    throw std::runtime_error("Could not create capture file " + capturePath);
+  }
+  _file << "# OWEN serial capture 1, port " << portPath << '\n';
+}
+
+void CaptureWriter::End(bool complete)
+{
+  using namespace std::chrono;
+  _file << "= " << duration_cast<microseconds>(steady_clock::now() - _start).count()
+        << (complete ? " complete" : " timeout") << std::endl;
+}
+
+void CaptureWriter::Record(char kind, char const* data, size_t size)
+{
+  using namespace std::chrono;
+  _file << kind << ' ' << duration_cast<microseconds>(steady_clock::now() - _start).count() << std::hex << std::setfill('0');
+  for (size_t i = 0; i < size; ++i)
+  {
+    _file << ' ' << std::setw(2) << static_cast<uint32_t>(static_cast<uint8_t>(data[i]));
+  }
+  _file << std::dec << std::setfill(' ') << '\n';
+}
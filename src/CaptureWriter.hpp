@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+/**
+ * Text capture of transport exchanges which can be served back by replay_OWEN_ImpulseCounter30.
+ * Frames are RTU frames whatever the transport is. One record per line, times in microseconds since the capture start:
+ *   > TIME HEX...            request
+ *   < TIME HEX...            received chunk
+ *   = TIME complete|timeout  end of exchange (broadcast exchanges have no chunks)
+ */
+class CaptureWriter
+{
+public:
+  /**
+   * @throw std::runtime_error if file could not be created.
+   */
+  CaptureWriter(std::string const& capturePath, std::string const& portPath);
+
+  void Request(char const* data, size_t size)
+  {
+    Record('>', data, size);
+  }
+
+  void Chunk(char const* data, size_t size)
+  {
+    Record('<', data, size);
+  }
+
+  /**
+   * End of exchange, file is flushed so the capture survives a crash.
+   */
+  void End(bool complete);
+
+private:
+  void Record(char kind, char const* data, size_t size);
+
+private:
+  std::ofstream _file;
+  std::chrono::steady_clock::time_point _start;
+};
@@ -0,0 +1,61 @@
+#include "Connector.hpp"
+
+namespace OWEN {
+
+auto Connector::Shared() -> Connector&
+{
+  static Connector connector;
+  return connector;
+}
+
+Connector::~Connector()
+{
+  for (auto& port : _ports)
+  {
+    if (port.second.thread.joinable())
+    {
+      port.second.thread.join();
+    }
+  }
+}
+
+auto Connector::Connect(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::future<ImpulseCounter30>
+{
+  std::packaged_task<ImpulseCounter30()> task{[communicationOptions] { return ImpulseCounter30{communicationOptions}; }};
+  auto future = task.get_future();
+  std::lock_guard<std::mutex> lock{_mutex};
+  auto& port = _ports[communicationOptions._portPath];
+  port.queue.emplace_back(std::move(task));
+  if (!port.running)
+  {
+    // Thread of the previous batch has nothing left to do but to exit
+    if (port.thread.joinable())
+    {
+      port.thread.join();
+    }
+    port.running = true;
+    port.thread = std::thread([this, &port] { Run(port); });
+  }
+  return future;
+}
+
+void Connector::Run(Port& port)
+{
+  while (true)
+  {
+    std::packaged_task<ImpulseCounter30()> task;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      if (port.queue.empty())
+      {
+        port.running = false;
+        return;
+      }
+      task = std::move(port.queue.front());
+      port.queue.pop_front();
+    }
+    task();
+  }
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace OWEN {
+
+/**
+ * Background construction of counters (see ImpulseCounter30::ConnectAsync). Every port path gets its own thread while
+ * it has counters to construct, so ports connect in parallel and counters of a port one by one as they share the bus.
+ */
+class Connector
+{
+public:
+  /**
+   * Connector of the process.
+   */
+  static auto Shared() -> Connector&;
+
+  /**
+   * Wait until all queued counters are constructed.
+   */
+  ~Connector();
+  Connector(Connector const&) = delete;
+  Connector& operator=(Connector const&) = delete;
+
+  auto Connect(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::future<ImpulseCounter30>;
+
+private:
+  struct Port
+  {
+    std::deque<std::packaged_task<ImpulseCounter30()>> queue;   ///< guarded by mutex
+    std::thread thread;
+    bool running{};                                             ///< guarded by mutex
+  };
+
+  Connector() = default;
+
+  void Run(Port& port);
+
+private:
+  std::mutex _mutex;
+  std::map<std::string, Port> _ports;   ///< ports are never erased, so workers may keep references
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,489 @@
+#include <OWEN/Fleet.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace OWEN {
+
+class Fleet::Impl
+{
+public:
+  Impl(std::vector<ImpulseCounter30::CommunicationOptions> const& inventory, std::chrono::milliseconds period)
+    : _period{period}
+  {
+    std::map<std::string, Worker*> workers;
+    for (size_t i = 0; i < inventory.size(); ++i)
+    {
+      _devices.emplace_back(std::make_unique<Device>());
+      auto& device = *_devices.back();
+      device.index = i;
+      device.communicationOptions = inventory[i];
+      auto& worker = workers[inventory[i]._portPath];
+      if (worker == nullptr)
+      {
+        _workers.emplace_back(std::make_unique<Worker>());
+        worker = _workers.back().get();
+        worker->index = _workers.size() - 1;
+      }
+      worker->devices.emplace_back(&device);
+    }
+  }
+
+  ~Impl()
+  {
+    Stop();
+  }
+
+  void OnSamples(tSamples samples)
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (_running)
+    {
+      throw std::runtime_error("Samples can not be subscribed to on running fleet");
+    }
+    _onSamples.emplace_back(std::move(samples));
+  }
+
+  void OnConnected(tConnected connected)
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (_running)
+    {
+      throw std::runtime_error("Connections can not be subscribed to on running fleet");
+    }
+    _onConnected.emplace_back(std::move(connected));
+  }
+
+  void Start()
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (_running)
+    {
+      return;
+    }
+    _running = true;
+    for (auto& worker : _workers)
+    {
+      worker->thread = std::thread([this, &worker = *worker] { Run(worker); });
+    }
+  }
+
+  void Stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _running = false;
+      for (auto& worker : _workers)
+      {
+        worker->wakeUp.notify_one();
+      }
+    }
+    for (auto& worker : _workers)
+    {
+      if (worker->thread.joinable())
+      {
+        worker->thread.join();
+      }
+    }
+  }
+
+  auto Size() const -> size_t
+  {
+    return _devices.size();
+  }
+
+  auto GetHealth() const -> std::vector<Health>
+  {
+    std::vector<Health> health;
+    std::lock_guard<std::mutex> lock{_mutex};
+    for (auto const& device : _devices)
+    {
+      health.emplace_back(device->health);
+    }
+    return health;
+  }
+
+  auto GetLatest() const -> std::vector<std::optional<Sample>>
+  {
+    std::vector<std::optional<Sample>> latest;
+    std::lock_guard<std::mutex> lock{_mutex};
+    for (auto const& device : _devices)
+    {
+      latest.emplace_back(device->latest);
+    }
+    return latest;
+  }
+
+  auto ForEach(tOperation const& operation) -> std::vector<bool>
+  {
+    // Every worker writes its own elements, std::vector<bool> elements share words
+    std::vector<uint8_t> results(_devices.size());
+    auto const ran = RunOnWorkers([&](Worker& worker) {
+      for (auto* device : worker.devices)
+      {
+        results[device->index] = device->counter.has_value() && operation(*device->counter);
+      }
+    });
+    if (!ran)
+    {
+      return {};
+    }
+    return {results.cbegin(), results.cend()};
+  }
+
+  auto SampleAligned(std::chrono::system_clock::time_point tick) -> std::optional<AlignedSnapshot>
+  {
+    using namespace std::chrono;
+    // Workers sleep on the steady clock, so wall clock steps do not disturb them
+    auto const steadyTick = steady_clock::now() + duration_cast<steady_clock::duration>(tick - system_clock::now());
+    AlignedSnapshot snapshot{tick, std::vector<AlignedSample>(_devices.size())};
+    auto const ran = RunOnWorkers([&](Worker& worker) {
+      steady_clock::duration burst{};
+      for (auto* device : worker.devices)
+      {
+        burst += device->roundTrip;
+      }
+      // Waking up is late by scheduling latency, it is learnt like round trips
+      auto const wakeUp = steadyTick - burst / 2;
+      std::this_thread::sleep_until(wakeUp - worker.wakeUpLateness);
+      auto const lateness = steady_clock::now() - (wakeUp - worker.wakeUpLateness);
+      worker.wakeUpLateness = (worker.wakeUpLateness * 7 + lateness) / 8;
+      for (auto* device : worker.devices)
+      {
+        auto& sample = snapshot.samples[device->index];
+        sample.device = device->index;
+        if (!device->counter.has_value())
+        {
+          continue;
+        }
+        auto const sent = steady_clock::now();
+        sample.counterValue = device->counter->GetCounterValue();
+        auto const received = steady_clock::now();
+        sample.roundTrip = duration_cast<microseconds>(received - sent);
+        sample.skew = duration_cast<microseconds>(sent + (received - sent) / 2 - steadyTick);
+        if (sample.counterValue.has_value())
+        {
+          device->roundTrip = (device->roundTrip == steady_clock::duration{})
+                              ? received - sent
+                              : (device->roundTrip * 7 + (received - sent)) / 8;
+        }
+      }
+    });
+    if (!ran)
+    {
+      return {};
+    }
+    return snapshot;
+  }
+
+  /**
+   * Run broadcast on one connected counter of every port.
+   */
+  bool Broadcast(std::function<bool(ImpulseCounter30& counter)> const& broadcast)
+  {
+    std::vector<uint8_t> sent(_workers.size());
+    auto const ran = RunOnWorkers([&](Worker& worker) {
+      auto const it = std::find_if(worker.devices.cbegin(), worker.devices.cend(), [](Device const* device) {
+        return device->counter.has_value();
+      });
+      sent[worker.index] = (it != worker.devices.cend()) && broadcast(*(*it)->counter);
+    });
+    return ran && std::all_of(sent.cbegin(), sent.cend(), [](uint8_t value) { return value != 0; });
+  }
+
+  auto GetMetrics() const -> std::vector<DeviceMetrics>
+  {
+    std::vector<DeviceMetrics> metrics;
+    std::lock_guard<std::mutex> lock{_mutex};
+    for (auto const& device : _devices)
+    {
+      if (device->counter.has_value())
+      {
+        auto deviceMetrics = device->counter->GetMetrics();
+        std::move(deviceMetrics.begin(), deviceMetrics.end(), std::back_inserter(metrics));
+      }
+    }
+    return metrics;
+  }
+
+private:
+  struct Device
+  {
+    size_t index{};
+    ImpulseCounter30::CommunicationOptions communicationOptions;
+    std::optional<ImpulseCounter30> counter;             ///< set by the worker with mutex locked, used by the worker only
+    std::chrono::steady_clock::time_point nextConnect;
+    std::chrono::steady_clock::duration roundTrip{};     ///< average of aligned reads, used by the worker only
+    Health health;                                       ///< guarded by mutex
+    std::optional<Sample> latest;                        ///< guarded by mutex
+  };
+
+  struct Worker
+  {
+    size_t index{};
+    std::vector<Device*> devices;
+    std::deque<std::function<void()>> jobs;                 ///< guarded by mutex
+    std::chrono::steady_clock::duration wakeUpLateness{};   ///< average of aligned reads, used by the worker only
+    std::condition_variable wakeUp;
+    std::thread thread;
+  };
+
+private:
+  void Run(Worker& worker)
+  {
+    using namespace std::chrono;
+    auto nextPoll = steady_clock::now();
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (true)
+    {
+      worker.wakeUp.wait_until(lock, nextPoll, [&] { return !_running || !worker.jobs.empty(); });
+      if (!worker.jobs.empty())
+      {
+        lock.unlock();
+        RunJobs(worker);
+        lock.lock();
+        continue;
+      }
+      if (!_running)
+      {
+        return;
+      }
+      if (steady_clock::now() < nextPoll)
+      {
+        continue;
+      }
+      lock.unlock();
+      Cycle(worker);
+      // A slow bus does not accumulate a backlog of cycles
+      nextPoll = std::max(nextPoll + _period, steady_clock::now());
+      lock.lock();
+    }
+  }
+
+  /**
+   * Sample connected counters of the port, then try to connect the others (a connection attempt of an offline device
+   * costs the bus a response timeout). Jobs are run between counters.
+   */
+  void Cycle(Worker& worker)
+  {
+    std::vector<Sample> samples;
+    for (auto* device : worker.devices)
+    {
+      if (device->counter.has_value())
+      {
+        SampleOf(*device, samples);
+        RunJobs(worker);
+      }
+    }
+    for (auto* device : worker.devices)
+    {
+      if (!device->counter.has_value() && Connect(*device))
+      {
+        SampleOf(*device, samples);
+        RunJobs(worker);
+      }
+    }
+    if (!samples.empty())
+    {
+      std::lock_guard<std::mutex> lock{_callbackMutex};
+      for (auto const& onSamples : _onSamples)
+      {
+        onSamples(samples);
+      }
+    }
+  }
+
+  bool Connect(Device& device)
+  {
+    auto const now = std::chrono::steady_clock::now();
+    if (now < device.nextConnect)
+    {
+      return false;
+    }
+    try
+    {
+      ImpulseCounter30 counter{device.communicationOptions};
+      std::lock_guard<std::mutex> lock{_mutex};
+      device.counter.emplace(std::move(counter));
+      device.health.connected = true;
+    }
+    catch (std::exception const& ex)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      // An offline device costs its bus one connection timeout per reconnect period
+      device.nextConnect = now + RECONNECT_PERIOD;
+      Fail(device.health, ex.what());
+      return false;
+    }
+    std::lock_guard<std::mutex> lock{_callbackMutex};
+    for (auto const& onConnected : _onConnected)
+    {
+      onConnected(device.index);
+    }
+    return true;
+  }
+
+  void SampleOf(Device& device, std::vector<Sample>& samples)
+  {
+    auto const snapshot = device.counter->GetSnapshot();
+    auto const time = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto& health = device.health;
+    if (!snapshot.has_value())
+    {
+      auto const exceptionCode = device.counter->LastExceptionCode();
+      std::ostringstream error;
+      if (exceptionCode != 0)
+      {
+        error << "Exception 0x" << std::hex << static_cast<uint32_t>(exceptionCode);
+      }
+      else
+      {
+        error << "No response";
+      }
+      Fail(health, error.str());
+      return;
+    }
+    health.online = true;
+    ++health.samples;
+    health.consecutiveFailures = 0;
+    health.lastSample = time;
+    device.latest = Sample{device.index, time, snapshot.value()};
+    samples.emplace_back(device.latest.value());
+  }
+
+  static void Fail(Health& health, std::string const& error)
+  {
+    health.online = false;
+    ++health.failures;
+    ++health.consecutiveFailures;
+    health.lastError = error;
+  }
+
+  void RunJobs(Worker& worker)
+  {
+    std::deque<std::function<void()>> jobs;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      jobs.swap(worker.jobs);
+    }
+    for (auto const& job : jobs)
+    {
+      job();
+    }
+  }
+
+  /**
+   * Run job on every worker and wait until all have run it. Must not be called from a worker (sample callbacks).
+   * @return false if fleet is not running.
+   */
+  bool RunOnWorkers(std::function<void(Worker& worker)> const& job)
+  {
+    std::unique_lock<std::mutex> lock{_mutex};
+    if (!_running)
+    {
+      return false;
+    }
+    auto pending = _workers.size();
+    std::condition_variable done;
+    for (auto& worker : _workers)
+    {
+      worker->jobs.emplace_back([&, &worker = *worker] {
+        job(worker);
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (--pending == 0)
+        {
+          done.notify_all();
+        }
+      });
+      worker->wakeUp.notify_one();
+    }
+    done.wait(lock, [&] { return pending == 0; });
+    return true;
+  }
+
+private:
+  std::chrono::milliseconds _period;
+  std::vector<std::unique_ptr<Device>> _devices;
+  std::vector<std::unique_ptr<Worker>> _workers;   ///< one per port path
+  std::vector<tSamples> _onSamples;                ///< not changed after Start
+  std::vector<tConnected> _onConnected;            ///< not changed after Start
+  mutable std::mutex _mutex;                       ///< guards running flag, jobs, health and latest samples
+  std::mutex _callbackMutex;                       ///< callbacks are never called concurrently
+  bool _running{};
+};
+
+Fleet::Fleet(std::vector<ImpulseCounter30::CommunicationOptions> const& inventory, std::chrono::milliseconds period)
+  : pImpl{std::make_unique<Impl>(inventory, period)}
+{
+}
+
+Fleet::~Fleet() = default;
+
+void Fleet::OnSamples(tSamples samples)
+{
+  pImpl->OnSamples(std::move(samples));
+}
+
+void Fleet::OnConnected(tConnected connected)
+{
+  pImpl->OnConnected(std::move(connected));
+}
+
+void Fleet::Start()
+{
+  pImpl->Start();
+}
+
+void Fleet::Stop()
+{
+  pImpl->Stop();
+}
+
+auto Fleet::Size() const -> size_t
+{
+  return pImpl->Size();
+}
+
+auto Fleet::GetHealth() const -> std::vector<Health>
+{
+  return pImpl->GetHealth();
+}
+
+auto Fleet::GetLatest() const -> std::vector<std::optional<Sample>>
+{
+  return pImpl->GetLatest();
+}
+
+auto Fleet::ForEach(tOperation operation) -> std::vector<bool>
+{
+  return pImpl->ForEach(operation);
+}
+
+auto Fleet::SampleAligned(std::chrono::system_clock::time_point tick) -> std::optional<AlignedSnapshot>
+{
+  return pImpl->SampleAligned(tick);
+}
+
+bool Fleet::BroadcastResetCount()
+{
+  return pImpl->Broadcast([](ImpulseCounter30& counter) { return counter.BroadcastResetCount(); });
+}
+
+bool Fleet::BroadcastStartCounter(bool isStart)
+{
+  return pImpl->Broadcast([isStart](ImpulseCounter30& counter) { return counter.BroadcastStartCounter(isStart); });
+}
+
+auto Fleet::GetMetrics() const -> std::vector<DeviceMetrics>
+{
+  return pImpl->GetMetrics();
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,214 @@
+#include "FrameLogger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void WriteValue(std::ofstream& file, T value)
+{
+  file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+} /// end namespace anonymous
+
+auto FrameLogger::Instance() -> FrameLogger&
+{
+  static FrameLogger frameLogger;
+  return frameLogger;
+}
+
+FrameLogger::FrameLogger()
+  : _slots{new Slot[CAPACITY]}
+{
+  for (size_t i = 0; i < CAPACITY; ++i)
+  {
+    _slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+FrameLogger::~FrameLogger()
+{
+  Close();
+}
+
+auto FrameLogger::ChannelOf(std::string const& portPath) -> uint16_t
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  auto const it = std::find(_channels.cbegin(), _channels.cend(), portPath);
+  if (it != _channels.cend())
+  {
+    return static_cast<uint16_t>(std::distance(_channels.cbegin(), it));
+  }
+  _channels.emplace_back(portPath);
+  return static_cast<uint16_t>(_channels.size() - 1);
+}
+
+void FrameLogger::Push(uint16_t channel,
+                       FrameLogFormat::eDirection direction,
+                       FrameLogFormat::eOutcome outcome,
+                       std::chrono::system_clock::time_point time,
+                       std::string const& frame) noexcept
+{
+  // Bounded multi-producer queue: producer claims a position and owns the slot until it publishes the sequence
+  auto position = _enqueuePosition.load(std::memory_order_relaxed);
+  Slot* slot{};
+  while (true)
+  {
+    slot = &_slots[position % CAPACITY];
+    auto const sequence = slot->sequence.load(std::memory_order_acquire);
+    auto const difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0)
+    {
+      if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      position = _enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+  slot->timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  slot->channel = channel;
+  slot->direction = direction;
+  slot->outcome = outcome;
+  slot->length = static_cast<uint16_t>(std::min(frame.size(), slot->data.size()));
+  std::memcpy(slot->data.data(), frame.data(), slot->length);
+  slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool FrameLogger::Open(std::string const& path, OWEN::FrameLog::eLevel level)
+{
+  Close();
+  std::lock_guard<std::mutex> lock{_mutex};
+  // Frames buffered while the log was closed belong to no file
+  while (Drain())
+  {
+  }
+  _file.open(path, std::ios::binary | std::ios::trunc);
+  if (!_file)
+  {
+    return false;
+  }
+  _file.write(FrameLogFormat::MAGIC, sizeof(FrameLogFormat::MAGIC));
+  _channelsWritten = 0;
+  _level.store(level, std::memory_order_relaxed);
+  _running = true;
+  _writer = std::thread([this] {
+    while (_running)
+    {
+      bool drained{};
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        WriteChannels();
+        drained = Drain();
+      }
+      if (!drained)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+  });
+  return true;
+}
+
+void FrameLogger::Close()
+{
+  _level.store(OWEN::FrameLog::eLevel::OFF, std::memory_order_relaxed);
+  _running = false;
+  if (_writer.joinable())
+  {
+    _writer.join();
+  }
+  std::lock_guard<std::mutex> lock{_mutex};
+  if (_file.is_open())
+  {
+    WriteChannels();
+    while (Drain())
+    {
+    }
+    _file.close();
+  }
+}
+
+void FrameLogger::WriteChannels()
+{
+  for (; _channelsWritten < _channels.size(); ++_channelsWritten)
+  {
+    auto const& name = _channels[_channelsWritten];
+    WriteValue(_file, FrameLogFormat::eRecord::CHANNEL);
+    WriteValue(_file, static_cast<uint16_t>(_channelsWritten));
+    WriteValue(_file, static_cast<uint16_t>(name.size()));
+    _file.write(name.data(), static_cast<std::streamsize>(name.size()));
+  }
+}
+
+bool FrameLogger::Drain()
+{
+  bool drained{};
+  while (true)
+  {
+    auto& slot = _slots[_dequeuePosition % CAPACITY];
+    if (slot.sequence.load(std::memory_order_acquire) != (_dequeuePosition + 1))
+    {
+      break;
+    }
+    if (_file.is_open())
+    {
+      WriteValue(_file, FrameLogFormat::eRecord::FRAME);
+      WriteValue(_file, slot.timeNs);
+      WriteValue(_file, slot.channel);
+      WriteValue(_file, slot.direction);
+      WriteValue(_file, slot.outcome);
+      WriteValue(_file, slot.length);
+      _file.write(slot.data.data(), slot.length);
+    }
+    slot.sequence.store(_dequeuePosition + CAPACITY, std::memory_order_release);
+    ++_dequeuePosition;
+    drained = true;
+  }
+  if (drained && _file.is_open())
+  {
+    _file.flush();
+  }
+  return drained;
+}
+
+namespace OWEN {
+namespace FrameLog {
+
+bool Open(std::string const& path, eLevel level)
+{
+  return FrameLogger::Instance().Open(path, level);
+}
+
+void Close()
+{
+  FrameLogger::Instance().Close();
+}
+
+void SetLevel(eLevel level)
+{
+  FrameLogger::Instance().SetLevel(level);
+}
+
+auto Level() -> eLevel
+{
+  return FrameLogger::Instance().Level();
+}
+
+auto Dropped() -> uint64_t
+{
+  return FrameLogger::Instance().Dropped();
+}
+
+} /// end namespace FrameLog
+} /// end namespace OWEN
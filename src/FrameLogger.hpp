@@ -0,0 +1,140 @@
+#pragma once
+
+#include <OWEN/FrameLog.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Frame log file format (little endian):
+ *   "OWENFLG1" magic,
+ *   then records, each starting with a record type byte:
+ *     CHANNEL: uint16 channel, uint16 name length, name (port path)
+ *     FRAME:   int64 wall clock time in ns since epoch, uint16 channel, uint8 direction, uint8 outcome,
+ *              uint16 length, frame bytes
+ */
+namespace FrameLogFormat {
+
+constexpr char MAGIC[8] = {'O', 'W', 'E', 'N', 'F', 'L', 'G', '1'};
+
+enum class eRecord : uint8_t
+{
+  CHANNEL = 1,
+  FRAME = 2
+};
+
+enum class eDirection : uint8_t
+{
+  TX = 0,
+  RX = 1
+};
+
+/**
+ * Outcome of the transaction the frame belongs to, same values as MetricsRecorder::eOutcome.
+ */
+enum class eOutcome : uint8_t
+{
+  OK,
+  TIMEOUT,
+  BAD_FRAME,
+  EXCEPTION
+};
+
+constexpr size_t MAX_FRAME_SIZE = 256;
+
+} /// end namespace FrameLogFormat
+
+class FrameLogger
+{
+public:
+  static auto Instance() -> FrameLogger&;
+
+  ~FrameLogger();
+
+  /**
+   * Cheap check for the transaction path whether frames of the transaction have to be logged.
+   */
+  bool IsEnabled(bool failed) const noexcept
+  {
+    auto const level = _level.load(std::memory_order_relaxed);
+    return (level == OWEN::FrameLog::eLevel::ALL) || (failed && (level == OWEN::FrameLog::eLevel::ERRORS));
+  }
+
+  /**
+   * Channel identifier of the port, assigned once per port path.
+   */
+  auto ChannelOf(std::string const& portPath) -> uint16_t;
+
+  /**
+   * Put frame to the buffer, never blocks. Frame is dropped if buffer is full.
+   */
+  void Push(uint16_t channel,
+            FrameLogFormat::eDirection direction,
+            FrameLogFormat::eOutcome outcome,
+            std::chrono::system_clock::time_point time,
+            std::string const& frame) noexcept;
+
+  bool Open(std::string const& path, OWEN::FrameLog::eLevel level);
+
+  void Close();
+
+  void SetLevel(OWEN::FrameLog::eLevel level)
+  {
+    _level.store(level, std::memory_order_relaxed);
+  }
+
+  auto Level() const -> OWEN::FrameLog::eLevel
+  {
+    return _level.load(std::memory_order_relaxed);
+  }
+
+  auto Dropped() const -> uint64_t
+  {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr size_t CAPACITY = 4096;
+
+  struct Slot
+  {
+    std::atomic<size_t> sequence{};
+    int64_t timeNs{};
+    uint16_t channel{};
+    FrameLogFormat::eDirection direction{};
+    FrameLogFormat::eOutcome outcome{};
+    uint16_t length{};
+    std::array<char, FrameLogFormat::MAX_FRAME_SIZE> data{};
+  };
+
+private:
+  FrameLogger();
+
+  /**
+   * Write all buffered frames to the file. Called by the writer thread only (single consumer).
+   */
+  bool Drain();
+
+  void WriteChannels();
+
+private:
+  std::unique_ptr<Slot[]> _slots;
+  alignas(64) std::atomic<size_t> _enqueuePosition{};
+  alignas(64) size_t _dequeuePosition{};
+  std::atomic<OWEN::FrameLog::eLevel> _level{OWEN::FrameLog::eLevel::OFF};
+  std::atomic<uint64_t> _dropped{};
+
+  std::mutex _mutex;                    ///< guards channels, file and writer thread (not the buffer)
+  std::vector<std::string> _channels;
+  size_t _channelsWritten{};
+  std::ofstream _file;
+  std::atomic<bool> _running{};
+  std::thread _writer;
+};
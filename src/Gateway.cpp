@@ -0,0 +1,364 @@
+#include <OWEN/Gateway.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace OWEN {
+
+namespace {
+
+constexpr size_t MBAP_HEADER_SIZE = 7;   ///< transaction id, protocol id, length, unit id
+
+constexpr uint8_t EXCEPTION_FLAG = 0x80;
+constexpr uint8_t EXCEPTION_ILLEGAL_FUNCTION = 0x01;
+constexpr uint8_t EXCEPTION_ILLEGAL_DATA_ADDRESS = 0x02;
+constexpr uint8_t EXCEPTION_ILLEGAL_DATA_VALUE = 0x03;
+constexpr uint8_t EXCEPTION_GATEWAY_PATH_UNAVAILABLE = 0x0A;
+constexpr uint8_t EXCEPTION_GATEWAY_TARGET_FAILED = 0x0B;
+
+constexpr uint16_t MAX_READ_BITS = 2000;
+constexpr uint16_t MAX_READ_REGISTERS = 125;
+constexpr uint16_t MAX_WRITE_REGISTERS = 123;
+
+auto Get16(std::string const& data, size_t offset) -> uint16_t
+{
+  return static_cast<uint16_t>((static_cast<uint8_t>(data[offset]) << 8) | static_cast<uint8_t>(data[offset + 1]));
+}
+
+void Put16(std::string& data, uint16_t value)
+{
+  data += static_cast<char>(value >> 8);
+  data += static_cast<char>(value & 0xFF);
+}
+
+auto ExceptionPdu(uint8_t function, uint8_t exceptionCode) -> std::string
+{
+  return {static_cast<char>(function | EXCEPTION_FLAG), static_cast<char>(exceptionCode)};
+}
+
+auto ReadBitsPdu(uint8_t function, std::vector<bool> const& bits, uint16_t address, uint16_t count) -> std::string
+{
+  if ((count == 0) || (count > MAX_READ_BITS))
+  {
+    return ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE);
+  }
+  if ((static_cast<size_t>(address) + count) > bits.size())
+  {
+    return ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_ADDRESS);
+  }
+  std::string pdu{static_cast<char>(function), static_cast<char>((count + 7) / 8)};
+  pdu.resize(2 + (count + 7) / 8);
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    if (bits[address + i])
+    {
+      pdu[2 + i / 8] = static_cast<char>(pdu[2 + i / 8] | (1 << (i % 8)));
+    }
+  }
+  return pdu;
+}
+
+auto ReadRegistersPdu(uint8_t function, std::vector<uint16_t> const& registers, uint16_t address, uint16_t count) -> std::string
+{
+  if ((count == 0) || (count > MAX_READ_REGISTERS))
+  {
+    return ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE);
+  }
+  if ((static_cast<size_t>(address) + count) > registers.size())
+  {
+    return ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_ADDRESS);
+  }
+  std::string pdu{static_cast<char>(function), static_cast<char>(count * 2)};
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    Put16(pdu, registers[address + i]);
+  }
+  return pdu;
+}
+
+} /// end namespace anonymous
+
+class Gateway::Impl
+{
+public:
+  using tReply = std::function<void(std::string const& pdu)>;
+
+  Impl(std::vector<std::reference_wrapper<Poller>> const& pollers, uint16_t port, std::chrono::milliseconds maxAge)
+    : _maxAge{maxAge}
+    , _acceptor{_io, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)}
+  {
+    for (auto& poller : pollers)
+    {
+      for (auto const unit : poller.get().Units())
+      {
+        if (!_units.emplace(unit, &poller.get()).second)
+        {
+          throw std::runtime_error("Unit " + std::to_string(unit) + " is polled by several pollers");
+        }
+      }
+    }
+    Accept();
+    _thread = std::thread([this] { _io.run(); });
+  }
+
+  ~Impl()
+  {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _stopped = true;
+    }
+    _io.stop();
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+    // Completion callbacks of queued writes refer to this gateway
+    std::unique_lock<std::mutex> lock{_mutex};
+    _writesDone.wait(lock, [this] { return _pendingWrites == 0; });
+  }
+
+  auto Port() const -> uint16_t
+  {
+    return _acceptor.local_endpoint().port();
+  }
+
+  /**
+   * Handle request PDU to the unit, reply is called with response PDU (possibly later, from the io thread).
+   */
+  void Handle(uint8_t unit, std::string const& pdu, tReply reply)
+  {
+    auto const function = static_cast<uint8_t>(pdu[0]);
+    auto const it = _units.find(unit);
+    if (it == _units.cend())
+    {
+      reply(ExceptionPdu(function, EXCEPTION_GATEWAY_PATH_UNAVAILABLE));
+      return;
+    }
+    auto& poller = *it->second;
+    switch (function)
+    {
+      case 0x01:
+      case 0x02:
+      case 0x03:
+      case 0x04:
+      {
+        if (pdu.size() != 5)
+        {
+          reply(ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE));
+          return;
+        }
+        auto const cached = poller.Image(unit);
+        if (!cached || ((std::chrono::steady_clock::now() - cached->time) > _maxAge))
+        {
+          reply(ExceptionPdu(function, EXCEPTION_GATEWAY_TARGET_FAILED));
+          return;
+        }
+        auto const& image = cached->image;
+        auto const address = Get16(pdu, 1);
+        auto const count = Get16(pdu, 3);
+        switch (function)
+        {
+          case 0x01: reply(ReadBitsPdu(function, image.coils, address, count)); break;
+          case 0x02: reply(ReadBitsPdu(function, image.discreteInputs, address, count)); break;
+          case 0x03: reply(ReadRegistersPdu(function, image.holdingRegisters, address, count)); break;
+          default: reply(ReadRegistersPdu(function, image.inputRegisters, address, count)); break;
+        }
+        return;
+      }
+      case 0x05:
+      {
+        if ((pdu.size() != 5) || ((Get16(pdu, 3) != 0xFF00) && (Get16(pdu, 3) != 0x0000)))
+        {
+          reply(ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE));
+          return;
+        }
+        Forward(poller, unit, {Poller::WriteRequest::eKind::COIL, Get16(pdu, 1), {Get16(pdu, 3) != 0}}, pdu, std::move(reply));
+        return;
+      }
+      case 0x06:
+      {
+        if (pdu.size() != 5)
+        {
+          reply(ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE));
+          return;
+        }
+        Forward(poller, unit, {Poller::WriteRequest::eKind::HOLDING_REGISTERS, Get16(pdu, 1), {Get16(pdu, 3)}}, pdu, std::move(reply));
+        return;
+      }
+      case 0x10:
+      {
+        auto const count = (pdu.size() >= 6) ? Get16(pdu, 3) : uint16_t{};
+        if ((count == 0) || (count > MAX_WRITE_REGISTERS) ||
+            (static_cast<uint8_t>(pdu[5]) != (count * 2)) || (pdu.size() != (6u + count * 2)))
+        {
+          reply(ExceptionPdu(function, EXCEPTION_ILLEGAL_DATA_VALUE));
+          return;
+        }
+        Poller::WriteRequest request{Poller::WriteRequest::eKind::HOLDING_REGISTERS, Get16(pdu, 1), {}};
+        for (uint16_t i = 0; i < count; ++i)
+        {
+          request.values.emplace_back(Get16(pdu, 6 + i * 2));
+        }
+        Forward(poller, unit, std::move(request), pdu.substr(0, 5), std::move(reply));
+        return;
+      }
+      default:
+        reply(ExceptionPdu(function, EXCEPTION_ILLEGAL_FUNCTION));
+        return;
+    }
+  }
+
+private:
+  class Session : public std::enable_shared_from_this<Session>
+  {
+  public:
+    Session(Impl& gateway, boost::asio::ip::tcp::socket socket)
+      : _gateway{gateway}
+      , _socket{std::move(socket)}
+    {
+    }
+
+    void ReadHeader()
+    {
+      auto self = shared_from_this();
+      boost::asio::async_read(_socket, boost::asio::buffer(_header), [self](boost::system::error_code const& error, size_t) {
+        if (error)
+        {
+          return;
+        }
+        std::string const header{self->_header.data(), self->_header.size()};
+        auto const length = Get16(header, 4);
+        if ((Get16(header, 2) != 0) || (length < 2) || (length > 254))
+        {
+          // Not Modbus TCP, connection is closed
+          return;
+        }
+        self->_pdu.resize(length - 1u);
+        self->ReadPdu();
+      });
+    }
+
+  private:
+    void ReadPdu()
+    {
+      auto self = shared_from_this();
+      boost::asio::async_read(_socket, boost::asio::buffer(&_pdu[0], _pdu.size()), [self](boost::system::error_code const& error, size_t) {
+        if (error)
+        {
+          return;
+        }
+        self->_gateway.Handle(static_cast<uint8_t>(self->_header[6]), self->_pdu, [self](std::string const& pdu) {
+          self->Reply(pdu);
+        });
+      });
+    }
+
+    void Reply(std::string const& pdu)
+    {
+      _response.assign(_header.data(), 4);
+      Put16(_response, static_cast<uint16_t>(pdu.size() + 1));
+      _response += _header[6];
+      _response += pdu;
+      auto self = shared_from_this();
+      boost::asio::async_write(_socket, boost::asio::buffer(_response), [self](boost::system::error_code const& error, size_t) {
+        if (!error)
+        {
+          self->ReadHeader();
+        }
+      });
+    }
+
+  private:
+    Impl& _gateway;
+    boost::asio::ip::tcp::socket _socket;
+    std::array<char, MBAP_HEADER_SIZE> _header{};
+    std::string _pdu;
+    std::string _response;
+  };
+
+private:
+  void Accept()
+  {
+    _acceptor.async_accept(_socket, [this](boost::system::error_code const& error) {
+      if (error)
+      {
+        return;
+      }
+      boost::system::error_code ignored;
+      _socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+      std::make_shared<Session>(*this, std::move(_socket))->ReadHeader();
+      _socket = boost::asio::ip::tcp::socket{_io};
+      Accept();
+    });
+  }
+
+  /**
+   * Queue write to the poller, reply is posted to the io thread when device confirmed or rejected it.
+   */
+  void Forward(Poller& poller, uint8_t unit, Poller::WriteRequest request, std::string const& successPdu, tReply reply)
+  {
+    auto const function = static_cast<uint8_t>(successPdu[0]);
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      ++_pendingWrites;
+    }
+    auto const queued = poller.Write(unit, std::move(request), [this, function, successPdu, reply](bool written, uint8_t exceptionCode) mutable {
+      auto const pdu = written
+                       ? successPdu
+                       : ExceptionPdu(function, (exceptionCode != 0) ? exceptionCode : EXCEPTION_GATEWAY_TARGET_FAILED);
+      std::lock_guard<std::mutex> lock{_mutex};
+      if (!_stopped)
+      {
+        _io.post([reply, pdu] { reply(pdu); });
+      }
+      // Session is released before the gateway can be destroyed
+      reply = nullptr;
+      --_pendingWrites;
+      _writesDone.notify_all();
+    });
+    if (!queued)
+    {
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        --_pendingWrites;
+      }
+      reply(ExceptionPdu(function, EXCEPTION_GATEWAY_TARGET_FAILED));
+    }
+  }
+
+private:
+  std::chrono::milliseconds _maxAge;
+  std::map<uint8_t, Poller*> _units;
+  boost::asio::io_service _io;
+  boost::asio::ip::tcp::acceptor _acceptor;
+  boost::asio::ip::tcp::socket _socket{_io};
+  std::thread _thread;
+  std::mutex _mutex;                    ///< guards pending writes count and stopped flag
+  std::condition_variable _writesDone;
+  size_t _pendingWrites{};
+  bool _stopped{};
+};
+
+Gateway::Gateway(std::vector<std::reference_wrapper<Poller>> const& pollers, uint16_t port, std::chrono::milliseconds maxAge)
+  : pImpl{std::make_unique<Impl>(pollers, port, maxAge)}
+{
+}
+
+Gateway::~Gateway() = default;
+
+auto Gateway::Port() const -> uint16_t
+{
+  return pImpl->Port();
+}
+
+} /// end namespace OWEN
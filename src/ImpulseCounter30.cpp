@@ -1,65 +1,24 @@
 #include <OWEN/ImpulseCounter30.hpp>
 
-#include "SerialPort.hpp"
+#include "Connector.hpp"
 #include "ModBus.hpp"
+#include "SharedTransport.hpp"
+#include "TransportFactory.hpp"
+#include "SI30RegisterMap.hpp"
 
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 namespace OWEN {
 
 namespace {
 
-auto ToSerialPortType(ImpulseCounter30::CommunicationOptions::eParity parity) -> SerialPort::eParity
-{
-   using eParity = ImpulseCounter30::CommunicationOptions::eParity;
-   switch(parity)
-   {
-      case eParity::EVEN:
-         return SerialPort::eParity::even;
-      case eParity::ODD:
-         return SerialPort::eParity::odd;
-      case eParity::NO:
-      default:
-         return SerialPort::eParity::none;
-   }
-}
-
-static auto ToSerialPortType(ImpulseCounter30::CommunicationOptions::eBaudrate baudrate) -> uint32_t
-{
-   using eBaudrate = ImpulseCounter30::CommunicationOptions::eBaudrate;
-   switch(baudrate)
-   {
-      case eBaudrate::_2400bps:
-         return 2400;
-      case eBaudrate::_4800bps:
-         return 4800;
-      case eBaudrate::_9600bps:
-         return 9600;
-      case eBaudrate::_14400bps:
-         return 14400;
-      case eBaudrate::_19200bps:
-         return 19200;
-      case eBaudrate::_28800bps:
-         return 28800;
-      case eBaudrate::_38400bps:
-         return 38400;
-      case eBaudrate::_57600bps:
-         return 57600;
-      case eBaudrate::_115200bps:
-         return 115200;
-      default: return 0;
-   }
-}
-
-auto AutoFind(ImpulseCounter30::CommunicationOptions& communicationOptions, ImpulseCounter30::tFindProgress progress) -> SerialPort
+auto AutoFind(ImpulseCounter30::CommunicationOptions& communicationOptions, ImpulseCounter30::tFindProgress progress) -> std::unique_ptr<Transport>
 {
-   auto serialPortCreator = [](ImpulseCounter30::CommunicationOptions const& communicationOptions) -> SerialPort {
-     return SerialPort(communicationOptions._portPath,
-                       ToSerialPortType(communicationOptions._baudrate.value()),
-                       ToSerialPortType(communicationOptions._parity.value()),
-                       communicationOptions._stopBitsExtended.value() ? SerialPort::eStopBits::two : SerialPort::eStopBits::one,
-                       communicationOptions._dataBitsExtended.value() ? static_cast<uint8_t>(8) : static_cast<uint8_t>(7));
-   };
+   auto serialPortCreator = CreateSerialPort;
    using eBaudrate = ImpulseCounter30::CommunicationOptions::eBaudrate;
    using eParity = ImpulseCounter30::CommunicationOptions::eParity;
 
@@ -91,15 +50,15 @@ auto AutoFind(ImpulseCounter30::CommunicationOptions& communicationOptions, Impu
                      {
                         auto serialPort = serialPortCreator(co);
                         std::cout << "Trying to send request" << std::endl;
-                        auto modbus = ModBus(serialPort, co._baseAddr.value());
-                        if (!modbus.ReadHoldingRegisters(0x0000, 1, 100).empty())
+                        auto modbus = ModBus(*serialPort, co._baseAddr.value());
+                        if (!modbus.ReadHoldingRegisters(SI30::BaudRate::address, 1, 100).empty())
                         {
                            progress(totalIterations, totalIterations, co);
-                           return serialPortCreator(co);
+                           return serialPort;
                         }
                         if (!progress(currentIt, totalIterations, co))
                         {
-                           return serialPortCreator(co);
+                           return serialPort;
                         }
                      }
                      catch(boost::system::system_error ex)
@@ -120,6 +79,132 @@ auto AutoFind(ImpulseCounter30::CommunicationOptions& communicationOptions, Impu
          co._baudrate = static_cast<eBaudrate>(baudrate);
       }
    }
+   throw std::runtime_error("Device was not found");
+}
+
+/**
+ * Transport for the port path, serial port is searched for the device if needed (URLs are never searched).
+ * Found ports are probed with many serial options, so only ports which are not searched are shared.
+ */
+auto FindOrCreateTransport(ImpulseCounter30::CommunicationOptions& communicationOptions,
+                           bool neededToBeFound,
+                           ImpulseCounter30::tFindProgress progress) -> std::unique_ptr<Transport>
+{
+   if (neededToBeFound && !IsTransportUrl(communicationOptions._portPath))
+   {
+      return AutoFind(communicationOptions, progress);
+   }
+   return SharedTransport::Acquire(communicationOptions);
+}
+
+constexpr uint16_t COMMUNICATION_OPTIONS_ADDRESS = SI30::BaudRate::address;
+constexpr uint16_t COMMUNICATION_OPTIONS_COUNT = SI30::DelayAnswer::address + SI30::DelayAnswer::width - COMMUNICATION_OPTIONS_ADDRESS;
+constexpr uint16_t COUNTER_OPTIONS_ADDRESS = SI30::DecPoint::address;
+constexpr uint16_t COUNTER_OPTIONS_COUNT = SI30::Password::address + SI30::Password::width - COUNTER_OPTIONS_ADDRESS;
+
+constexpr uint16_t COILS_COUNT = SI30::StartCounter::address + SI30::StartCounter::width;
+constexpr uint16_t DISCRETE_INPUTS_COUNT = SI30::LockInput::address + SI30::LockInput::width;
+constexpr uint16_t HOLDING_REGISTERS_COUNT = SI30::Password::address + SI30::Password::width;
+constexpr uint16_t INPUT_REGISTERS_COUNT = SI30::Version::address + SI30::Version::width;
+
+constexpr uint8_t EXCEPTION_ILLEGAL_FUNCTION = 0x01;
+
+/**
+ * Batch planner parameters of the device: batches are read by the frames typed reads use.
+ */
+auto DeviceLinkCost() -> ModBus::LinkCostModel
+{
+   ModBus::LinkCostModel linkCostModel;
+   linkCostModel.readSplits[static_cast<uint8_t>(SI30::eTable::HOLDING)].assign(SI30::HOLDING_READ_SPLITS.cbegin(),
+                                                                             SI30::HOLDING_READ_SPLITS.cend());
+   linkCostModel.readSplits[static_cast<uint8_t>(SI30::eTable::INPUT)].assign(SI30::INPUT_READ_SPLITS.cbegin(),
+                                                                           SI30::INPUT_READ_SPLITS.cend());
+   return linkCostModel;
+}
+
+template <typename Reg, typename T>
+void ToRegisters(std::vector<std::optional<uint16_t>>& image, uint16_t imageAddress, std::optional<T> const& value)
+{
+   if (!value.has_value())
+   {
+      return;
+   }
+   uint16_t registers[Reg::width]{};
+   Reg::Encode(static_cast<typename Reg::type>(value.value()), registers);
+   for (uint8_t i = 0; i < Reg::width; ++i)
+   {
+      image[Reg::address - imageAddress + i] = registers[i];
+   }
+}
+
+auto ToRegisters(ImpulseCounter30::CommunicationOptions const& co) -> std::vector<std::optional<uint16_t>>
+{
+   using namespace SI30;
+   std::vector<std::optional<uint16_t>> image(COMMUNICATION_OPTIONS_COUNT);
+   ToRegisters<BaudRate>(image, COMMUNICATION_OPTIONS_ADDRESS, co._baudrate);
+   ToRegisters<DataBits>(image, COMMUNICATION_OPTIONS_ADDRESS, co._dataBitsExtended);
+   ToRegisters<Parity>(image, COMMUNICATION_OPTIONS_ADDRESS, co._parity);
+   ToRegisters<StopBits>(image, COMMUNICATION_OPTIONS_ADDRESS, co._stopBitsExtended);
+   ToRegisters<LengthAddr>(image, COMMUNICATION_OPTIONS_ADDRESS, co._lengthAddrExtended);
+   ToRegisters<BaseAddr>(image, COMMUNICATION_OPTIONS_ADDRESS, co._baseAddr);
+   ToRegisters<DelayAnswer>(image, COMMUNICATION_OPTIONS_ADDRESS, co._delayAnswerMs);
+   return image;
+}
+
+auto ToRegisters(ImpulseCounter30::CounterOptions const& co) -> std::vector<std::optional<uint16_t>>
+{
+   using namespace SI30;
+   std::vector<std::optional<uint16_t>> image(COUNTER_OPTIONS_COUNT);
+   ToRegisters<DecPoint>(image, COUNTER_OPTIONS_ADDRESS, co._decPoint);
+   ToRegisters<InputMode>(image, COUNTER_OPTIONS_ADDRESS, co._inputMode);
+   ToRegisters<OutputMode>(image, COUNTER_OPTIONS_ADDRESS, co._outputMode);
+   ToRegisters<PointMode>(image, COUNTER_OPTIONS_ADDRESS, co._pointMode);
+   ToRegisters<ResetType>(image, COUNTER_OPTIONS_ADDRESS, co._resetType);
+   ToRegisters<SetPoint1>(image, COUNTER_OPTIONS_ADDRESS, co._point1Threshold);
+   ToRegisters<SetPoint2>(image, COUNTER_OPTIONS_ADDRESS, co._point2Threshold);
+   ToRegisters<TimeOUT1>(image, COUNTER_OPTIONS_ADDRESS, co._timeout1);
+   ToRegisters<TimeOUT2>(image, COUNTER_OPTIONS_ADDRESS, co._timeout2);
+   ToRegisters<DecPointMult>(image, COUNTER_OPTIONS_ADDRESS, co._decPointMult);
+   ToRegisters<Multiplexer>(image, COUNTER_OPTIONS_ADDRESS, co._multiplexer);
+   ToRegisters<MaxFreq>(image, COUNTER_OPTIONS_ADDRESS, co._maxFreq);
+   ToRegisters<MinControl>(image, COUNTER_OPTIONS_ADDRESS, co._minControl);
+   ToRegisters<LockKBD>(image, COUNTER_OPTIONS_ADDRESS, co._lockKbd);
+   ToRegisters<ShowSetPoint>(image, COUNTER_OPTIONS_ADDRESS, co._showSetPoint);
+   ToRegisters<Brightness>(image, COUNTER_OPTIONS_ADDRESS, co._brightness);
+   ToRegisters<InputType>(image, COUNTER_OPTIONS_ADDRESS, co._inputType);
+   ToRegisters<Password>(image, COUNTER_OPTIONS_ADDRESS, co._password);
+   return image;
+}
+
+template <typename Reg>
+auto FromRegisters(std::vector<uint16_t> const& registers, uint16_t registersAddress) -> typename Reg::type
+{
+   return Reg::Decode(registers.data() + (Reg::address - registersAddress));
+}
+
+auto ToCounterOptions(std::vector<uint16_t> const& registers) -> ImpulseCounter30::CounterOptions
+{
+   using namespace SI30;
+   auto const& r = registers;
+   auto const a = COUNTER_OPTIONS_ADDRESS;
+   return ImpulseCounter30::CounterOptions{}.DecPoint(FromRegisters<DecPoint>(r, a))
+                                            .InputMode(FromRegisters<InputMode>(r, a))
+                                            .OutputMode(FromRegisters<OutputMode>(r, a))
+                                            .SetPointMode(FromRegisters<PointMode>(r, a))
+                                            .ResetType(FromRegisters<ResetType>(r, a))
+                                            .SetPoint1(FromRegisters<SetPoint1>(r, a))
+                                            .SetPoint2(FromRegisters<SetPoint2>(r, a))
+                                            .TimeOUT1(FromRegisters<TimeOUT1>(r, a))
+                                            .TimeOUT2(FromRegisters<TimeOUT2>(r, a))
+                                            .DecPointMult(FromRegisters<DecPointMult>(r, a))
+                                            .Multiplexer(FromRegisters<Multiplexer>(r, a))
+                                            .MaxFreq(FromRegisters<MaxFreq>(r, a))
+                                            .MinControl(FromRegisters<MinControl>(r, a))
+                                            .LockKBD(FromRegisters<LockKBD>(r, a))
+                                            .ShowSetPoint(FromRegisters<ShowSetPoint>(r, a))
+                                            .Brightness(FromRegisters<Brightness>(r, a))
+                                            .InputType(FromRegisters<InputType>(r, a))
+                                            .Password(FromRegisters<Password>(r, a));
 }
 
 } /// end namespace anonymous
@@ -130,16 +215,16 @@ public:
   Impl(CommunicationOptions communicationOptions,
        bool neededToBeFound,
        tFindProgress progress)
-    : _serialPort(!neededToBeFound
-        ? SerialPort(communicationOptions._portPath,
-                     ToSerialPortType(communicationOptions._baudrate.value()),
-                     ToSerialPortType(communicationOptions._parity.value()),
-                     communicationOptions._stopBitsExtended.value() ? SerialPort::eStopBits::two : SerialPort::eStopBits::one,
-                     communicationOptions._dataBitsExtended.value() ? static_cast<uint8_t>(8) : static_cast<uint8_t>(7))
-        : AutoFind(communicationOptions, progress))
-    , _modBus{_serialPort, static_cast<uint8_t>(communicationOptions._baseAddr.value())}
-  {
-     if (_modBus.ReadHoldingRegisters(0x0000, 1, 1000).empty())
+    : _transport{FindOrCreateTransport(communicationOptions, neededToBeFound, progress)}
+    , _modBus{*_transport, static_cast<uint8_t>(communicationOptions._baseAddr.value())}
+    , _broadcastModBus{*_transport, ModBus::BROADCAST_ADDRESS}
+  {
+     if (!communicationOptions._capturePath.empty())
+     {
+        _transport->Capture(communicationOptions._capturePath);
+     }
+     _modBus.LinkCost(DeviceLinkCost());
+     if (_modBus.ReadHoldingRegisters(SI30::BaudRate::address, 1, 1000).empty())
      {
         throw std::runtime_error("Could not connected");
      }
@@ -147,286 +232,664 @@ public:
 
   auto GetCommunicationOptions() -> std::optional<CommunicationOptions>
   {
-    auto const registers = _modBus.ReadHoldingRegisters(0x0000, 7);
-    if (registers.size() < 7)
+    using namespace SI30;
+    auto const values = Read<BaudRate, DataBits, Parity, StopBits, LengthAddr, BaseAddr, DelayAnswer>(_modBus);
+    if (!values.has_value())
     {
       return {};
     }
-    return CommunicationOptions{}.BaudeRate(static_cast<CommunicationOptions::eBaudrate>(registers[0]))
-                                 .DataBits(registers[1])
-                                 .Parity(static_cast<CommunicationOptions::eParity>(registers[2]))
-                                 .StopBits(registers[3])
-                                 .LengthAddr(registers[4])
-                                 .BaseAddr(registers[5])
-                                 .DelayAnswer(static_cast<uint8_t>(registers[6]));
+    auto const& [baudrate, dataBits, parity, stopBits, lengthAddr, baseAddr, delayAnswer] = values.value();
+    return CommunicationOptions{}.BaudeRate(baudrate)
+                                 .DataBits(dataBits)
+                                 .Parity(parity)
+                                 .StopBits(stopBits)
+                                 .LengthAddr(lengthAddr)
+                                 .BaseAddr(baseAddr)
+                                 .DelayAnswer(delayAnswer);
   }
 
-  bool SetCommunicationOptions(ImpulseCounter30::CommunicationOptions const& communicationOptions)
+  bool SetCommunicationOptions(ImpulseCounter30::CommunicationOptions const& communicationOptions, bool readback)
   {
-    bool result{true};
-    if (communicationOptions._baudrate.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0000, static_cast<uint16_t>(communicationOptions._baudrate.value()));
-    }
-    if (communicationOptions._dataBitsExtended.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0001, static_cast<uint16_t>(communicationOptions._dataBitsExtended.value()));
-    }
-    if (communicationOptions._parity.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0002, static_cast<uint16_t>(communicationOptions._parity.value()));
-    }
-    if (communicationOptions._stopBitsExtended.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0003, static_cast<uint16_t>(communicationOptions._stopBitsExtended.value()));
-    }
-    if (communicationOptions._lengthAddrExtended.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0004, static_cast<uint16_t>(communicationOptions._lengthAddrExtended.value()));
-    }
-    if (communicationOptions._baseAddr.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0005, static_cast<uint16_t>(communicationOptions._baseAddr.value()));
-    }
-    if (communicationOptions._delayAnswerMs.has_value())
+    if (readback)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x0006, static_cast<uint16_t>(communicationOptions._delayAnswerMs.value()));
+      return WriteWithReadback(COMMUNICATION_OPTIONS_ADDRESS, ToRegisters(communicationOptions), 1000);
     }
+    using namespace SI30;
+    bool result{true};
+    result &= WriteIfSet<BaudRate>(communicationOptions._baudrate);
+    result &= WriteIfSet<DataBits>(communicationOptions._dataBitsExtended);
+    result &= WriteIfSet<Parity>(communicationOptions._parity);
+    result &= WriteIfSet<StopBits>(communicationOptions._stopBitsExtended);
+    result &= WriteIfSet<LengthAddr>(communicationOptions._lengthAddrExtended);
+    result &= WriteIfSet<BaseAddr>(communicationOptions._baseAddr);
+    result &= WriteIfSet<DelayAnswer>(communicationOptions._delayAnswerMs);
     return result;
   }
 
   auto GetCounterOptions() -> std::optional<ImpulseCounter30::CounterOptions>
   {
-    auto registers = _modBus.ReadHoldingRegisters(0x0007, 13, 10000);
-    auto registersContinue = _modBus.ReadHoldingRegisters(0x0007 + 13, 11, 10000);
+    auto registers = _modBus.ReadHoldingRegisters(COUNTER_OPTIONS_ADDRESS, 13, 10000);
+    auto registersContinue = _modBus.ReadHoldingRegisters(COUNTER_OPTIONS_ADDRESS + 13, COUNTER_OPTIONS_COUNT - 13, 10000);
     registers.insert(registers.end(), registersContinue.cbegin(), registersContinue.cend());
-    if (registers.size() < 24)
+    if (registers.size() < COUNTER_OPTIONS_COUNT)
     {
       return {};
     }
-    return CounterOptions{}.DecPoint(static_cast<CounterOptions::eDecPoint>(registers[0]))
-                           .InputMode(static_cast<CounterOptions::eInputMode>(registers[1]))
-                           .OutputMode(static_cast<CounterOptions::eOutputMode>(registers[2]))
-                           .SetPointMode(static_cast<CounterOptions::ePointMode>(registers[3]))
-                           .ResetType(static_cast<CounterOptions::eResetType>(registers[4]))
-                           .SetPoint1((((uint32_t)registers[5]) << 16) | (((uint32_t)registers[6]) & 0xFFFF))
-                           .SetPoint2((((uint32_t)registers[7]) << 16) | (((uint32_t)registers[8]) & 0xFFFF))
-                           .TimeOUT1((((uint32_t)registers[9]) << 16) | (((uint32_t)registers[10]) & 0xFFFF))
-                           .TimeOUT2((((uint32_t)registers[11]) << 16) | (((uint32_t)registers[12]) & 0xFFFF))
-                           .DecPointMult(static_cast<uint8_t>(registers[13]))
-                           .Multiplexer((((uint32_t)registers[14]) << 16) | (((uint32_t)registers[15]) & 0xFFFF))
-                           .MaxFreq(registers[16])
-                           .MinControl((((uint32_t)registers[17]) << 16) | (((uint32_t)registers[18]) & 0xFFFF))
-                           .LockKBD(static_cast<CounterOptions::eLockKBD>(registers[19]))
-                           .ShowSetPoint(static_cast<CounterOptions::eShowSetPoint>(registers[20]))
-                           .Brightness(registers[21])
-                           .InputType(static_cast<CounterOptions::eInputType>(registers[22]))
-                           .Password(registers[23]);
-  }
-
-  bool SetCounterOptions(ImpulseCounter30::CounterOptions const& counterOptions)
+    return ToCounterOptions(registers);
+  }
+
+  bool SetCounterOptions(ImpulseCounter30::CounterOptions const& counterOptions, bool readback)
   {
-    bool result{true};
-    if (counterOptions._decPoint.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0007, static_cast<uint16_t>(counterOptions._decPoint.value()));
-    }
-    if (counterOptions._inputMode.has_value())
+    if (readback)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x0008, static_cast<uint16_t>(counterOptions._inputMode.value()));
+      return WriteWithReadback(COUNTER_OPTIONS_ADDRESS, ToRegisters(counterOptions), 10000);
     }
-    if (counterOptions._outputMode.has_value())
-    {
-      result &= _modBus.WriteSingleHoldingRegister(0x0009, static_cast<uint16_t>(counterOptions._outputMode.value()));
-    }
-    if (counterOptions._pointMode.has_value())
+    using namespace SI30;
+    bool result{true};
+    result &= WriteIfSet<DecPoint>(counterOptions._decPoint);
+    result &= WriteIfSet<InputMode>(counterOptions._inputMode);
+    result &= WriteIfSet<OutputMode>(counterOptions._outputMode);
+    result &= WriteIfSet<PointMode>(counterOptions._pointMode);
+    result &= WriteIfSet<ResetType>(counterOptions._resetType);
+    result &= WriteIfSet<SetPoint1>(counterOptions._point1Threshold);
+    result &= WriteIfSet<SetPoint2>(counterOptions._point2Threshold);
+    result &= WriteIfSet<TimeOUT1>(counterOptions._timeout1);
+    result &= WriteIfSet<TimeOUT2>(counterOptions._timeout2);
+    result &= WriteIfSet<DecPointMult>(counterOptions._decPointMult);
+    result &= WriteIfSet<Multiplexer>(counterOptions._multiplexer);
+    result &= WriteIfSet<MaxFreq>(counterOptions._maxFreq);
+    result &= WriteIfSet<MinControl>(counterOptions._minControl);
+    result &= WriteIfSet<LockKBD>(counterOptions._lockKbd);
+    result &= WriteIfSet<ShowSetPoint>(counterOptions._showSetPoint);
+    result &= WriteIfSet<Brightness>(counterOptions._brightness);
+    result &= WriteIfSet<InputType>(counterOptions._inputType);
+    result &= WriteIfSet<Password>(counterOptions._password);
+    return result;
+  }
+
+  auto GetCounterValue() -> std::optional<int32_t>
+  {
+    return SI30::ReadValue<SI30::CounterValue>(_modBus);
+  }
+
+  auto GetCounterEU() -> std::optional<int32_t>
+  {
+#if 0
+    return SI30::ReadValue<SI30::CounterEU>(_modBus);
+#else
+    auto const registers1 = _modBus.ReadInputRegisters(SI30::CounterEU::address, 1);
+    auto const registers2 = _modBus.ReadInputRegisters(SI30::CounterEU::address + 1, 1);
+    uint16_t const registers[] = {registers1.empty() ? uint16_t{} : registers1[0], registers2.empty() ? uint16_t{} : registers2[0]};
+    return ((registers1.size() != 1) || (registers2.size() != 1))
+           ? std::optional<int32_t>{}
+           : std::optional<int32_t>{SI30::CounterEU::Decode(registers)};
+#endif
+  }
+
+  auto GetSnapshot() -> std::optional<ImpulseCounter30::Snapshot>
+  {
+    using namespace SI30;
+    auto const values = Read<CounterValue, CounterEU, StartStopMode, CurrentMode, CodeErrNet>(_modBus);
+    if (!values.has_value())
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x000A, static_cast<uint16_t>(counterOptions._pointMode.value()));
+      return {};
     }
-    if (counterOptions._resetType.has_value())
+    auto const& [counterValue, counterEU, startStopMode, currentMode, codeErrNet] = values.value();
+    return ImpulseCounter30::Snapshot{counterValue, counterEU, startStopMode, currentMode, codeErrNet};
+  }
+
+  auto GetStartStopMode() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::StartStopMode>(_modBus);
+  }
+
+  auto GetCurrentMode() -> std::optional<ImpulseCounter30::eCurrentMode>
+  {
+    return SI30::ReadValue<SI30::CurrentMode>(_modBus);
+  }
+
+  auto GetCodeErrNet() -> std::optional<uint8_t>
+  {
+    return SI30::ReadValue<SI30::CodeErrNet>(_modBus);
+  }
+
+  auto GetNameDevice() -> std::optional<std::string>
+  {
+    auto const registers = _modBus.ReadInputRegisters(SI30::NameDevice::address, SI30::NameDevice::width);
+    return (registers.size() != SI30::NameDevice::width)
+           ? std::optional<std::string>{}
+           : std::optional<std::string>{std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2}};
+  }
+
+  auto GetVersion() -> std::optional<std::string>
+  {
+    auto const registers = _modBus.ReadInputRegisters(SI30::Version::address, SI30::Version::width);
+    return (registers.size() != SI30::Version::width)
+           ? std::optional<std::string>{}
+           : std::optional<std::string>{std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2}};
+  }
+
+  auto IsResetInput() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::ResetInput>(_modBus);
+  }
+
+  auto IsLockInput() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::LockInput>(_modBus);
+  }
+
+  auto GetOutState1() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::OutState1>(_modBus);
+  }
+
+  auto GetOutState2() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::OutState2>(_modBus);
+  }
+
+  auto IsResetCount() -> std::optional<bool>
+  {
+    return SI30::ReadValue<SI30::ResetCount>(_modBus);
+  }
+
+  bool ResetCount()
+  {
+    return SI30::WriteValue<SI30::ResetCount>(_modBus, true);
+  }
+
+  bool ControlCounterFromProgram(bool isEnabled)
+  {
+    return SI30::WriteValue<SI30::ControlFromProgram>(_modBus, isEnabled);
+  }
+
+  bool StartCounter(bool isStart)
+  {
+    return SI30::WriteValue<SI30::StartCounter>(_modBus, isStart);
+  }
+
+  bool StopCounter(bool isStop)
+  {
+    return StartCounter(!isStop);
+  }
+
+  bool BroadcastCounterOptions(ImpulseCounter30::CounterOptions const& counterOptions, uint16_t turnaroundMs)
+  {
+    _broadcastModBus.BroadcastTurnaround(turnaroundMs);
+    auto const image = ToRegisters(counterOptions);
+    bool result{true};
+    for (uint16_t i = 0; i < COUNTER_OPTIONS_COUNT;)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x000B, static_cast<uint16_t>(counterOptions._resetType.value()));
+      if (!image[i].has_value())
+      {
+        ++i;
+        continue;
+      }
+      auto const runAddress = static_cast<uint16_t>(COUNTER_OPTIONS_ADDRESS + i);
+      std::vector<uint16_t> values;
+      for (; (i < COUNTER_OPTIONS_COUNT) && image[i].has_value(); ++i)
+      {
+        values.emplace_back(image[i].value());
+      }
+      result &= _broadcastModBus.WriteMultipleHoldingRegister(runAddress, values);
     }
-    if (counterOptions._point1Threshold.has_value())
+    return result;
+  }
+
+  bool BroadcastResetCount(uint16_t turnaroundMs)
+  {
+    _broadcastModBus.BroadcastTurnaround(turnaroundMs);
+    return SI30::WriteValue<SI30::ResetCount>(_broadcastModBus, true);
+  }
+
+  bool BroadcastStartCounter(bool isStart, uint16_t turnaroundMs)
+  {
+    _broadcastModBus.BroadcastTurnaround(turnaroundMs);
+    return SI30::WriteValue<SI30::StartCounter>(_broadcastModBus, isStart);
+  }
+
+  auto GetRegisterImage() -> std::optional<ImpulseCounter30::RegisterImage>
+  {
+    auto const values = _modBus.ReadBatch({{static_cast<uint8_t>(SI30::eTable::COIL), 0, COILS_COUNT},
+                                           {static_cast<uint8_t>(SI30::eTable::DISCRETE_INPUT), 0, DISCRETE_INPUTS_COUNT},
+                                           {static_cast<uint8_t>(SI30::eTable::HOLDING), 0, HOLDING_REGISTERS_COUNT},
+                                           {static_cast<uint8_t>(SI30::eTable::INPUT), 0, INPUT_REGISTERS_COUNT}});
+    if (std::any_of(values.cbegin(), values.cend(), [](auto const& value) { return value.empty(); }))
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x000C,
-                                                   {static_cast<uint16_t>(counterOptions._point1Threshold.value() >> 16),
-                                                    static_cast<uint16_t>(counterOptions._point1Threshold.value() & 0xFFFF)});
+      return {};
     }
-    if (counterOptions._point2Threshold.has_value())
+    return ImpulseCounter30::RegisterImage{{values[0].cbegin(), values[0].cend()},
+                                           {values[1].cbegin(), values[1].cend()},
+                                           values[2],
+                                           values[3]};
+  }
+
+  bool WriteCoil(uint16_t address, bool isOn)
+  {
+    return _modBus.ForceSingleCoil(address, isOn);
+  }
+
+  bool WriteHoldingRegisters(uint16_t address, std::vector<uint16_t> const& values)
+  {
+    return _modBus.WriteMultipleHoldingRegister(address, values, 10000);
+  }
+
+  auto LastExceptionCode() const -> uint8_t
+  {
+    return _modBus.LastExceptionCode();
+  }
+
+  auto GetMetrics() const -> std::vector<DeviceMetrics>
+  {
+    std::vector<DeviceMetrics> metrics{_modBus.Metrics()};
+    auto broadcastMetrics = _broadcastModBus.Metrics();
+    if (!broadcastMetrics.functions.empty())
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x000E,
-                                                     {static_cast<uint16_t>(counterOptions._point2Threshold.value() >> 16),
-                                                      static_cast<uint16_t>(counterOptions._point2Threshold.value() & 0xFFFF)});
+      metrics.emplace_back(std::move(broadcastMetrics));
     }
-    if (counterOptions._timeout1.has_value())
+    return metrics;
+  }
+
+  void GetMetrics(std::vector<DeviceMetrics>& metrics) const
+  {
+    // Broadcast metrics never become empty again, so the vector only grows when the caller keeps it
+    if (metrics.empty())
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x0010,
-                                                     {static_cast<uint16_t>(counterOptions._timeout1.value() >> 16),
-                                                      static_cast<uint16_t>(counterOptions._timeout1.value() & 0xFFFF)});
+      metrics.emplace_back();
     }
-    if (counterOptions._timeout2.has_value())
+    _modBus.Metrics(metrics[0]);
+    if (metrics.size() < 2)
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x0012,
-                                                     {static_cast<uint16_t>(counterOptions._timeout2.value() >> 16),
-                                                      static_cast<uint16_t>(counterOptions._timeout2.value() & 0xFFFF)});
+      metrics.emplace_back();
     }
-    if (counterOptions._decPointMult.has_value())
+    _broadcastModBus.Metrics(metrics[1]);
+    if (metrics[1].functions.empty())
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x0014, static_cast<uint16_t>(counterOptions._decPointMult.value()));
+      metrics.pop_back();
     }
-    if (counterOptions._multiplexer.has_value())
+  }
+
+#if defined(OWEN_COROUTINES)
+  auto SetCommunicationOptionsAsync(ImpulseCounter30::CommunicationOptions communicationOptions, bool readback) -> Task<bool>
+  {
+    if (readback)
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x0015,
-                                                     {static_cast<uint16_t>(counterOptions._multiplexer.value() >> 16),
-                                                      static_cast<uint16_t>(counterOptions._multiplexer.value() & 0xFFFF)});
+      co_return co_await WriteWithReadbackAsync(COMMUNICATION_OPTIONS_ADDRESS, ToRegisters(communicationOptions), 1000);
     }
-    if (counterOptions._maxFreq.has_value())
+    using namespace SI30;
+    bool result{true};
+    result &= co_await WriteIfSetAsync<BaudRate>(communicationOptions._baudrate);
+    result &= co_await WriteIfSetAsync<DataBits>(communicationOptions._dataBitsExtended);
+    result &= co_await WriteIfSetAsync<Parity>(communicationOptions._parity);
+    result &= co_await WriteIfSetAsync<StopBits>(communicationOptions._stopBitsExtended);
+    result &= co_await WriteIfSetAsync<LengthAddr>(communicationOptions._lengthAddrExtended);
+    result &= co_await WriteIfSetAsync<BaseAddr>(communicationOptions._baseAddr);
+    result &= co_await WriteIfSetAsync<DelayAnswer>(communicationOptions._delayAnswerMs);
+    co_return result;
+  }
+
+  auto GetCommunicationOptionsAsync() -> Task<std::optional<CommunicationOptions>>
+  {
+    using namespace SI30;
+    auto const values = co_await ReadAsync<BaudRate, DataBits, Parity, StopBits, LengthAddr, BaseAddr, DelayAnswer>(_modBus);
+    if (!values.has_value())
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x0017, static_cast<uint16_t>(counterOptions._maxFreq.value()));
+      co_return std::nullopt;
     }
-    if (counterOptions._minControl.has_value())
+    auto const& [baudrate, dataBits, parity, stopBits, lengthAddr, baseAddr, delayAnswer] = values.value();
+    co_return CommunicationOptions{}.BaudeRate(baudrate)
+                                    .DataBits(dataBits)
+                                    .Parity(parity)
+                                    .StopBits(stopBits)
+                                    .LengthAddr(lengthAddr)
+                                    .BaseAddr(baseAddr)
+                                    .DelayAnswer(delayAnswer);
+  }
+
+  auto SetCounterOptionsAsync(ImpulseCounter30::CounterOptions counterOptions, bool readback) -> Task<bool>
+  {
+    if (readback)
     {
-      result &= _modBus.WriteMultipleHoldingRegister(0x0018,
-                                                     {static_cast<uint16_t>(counterOptions._minControl.value() >> 16),
-                                                      static_cast<uint16_t>(counterOptions._minControl.value() & 0xFFFF)});
+      co_return co_await WriteWithReadbackAsync(COUNTER_OPTIONS_ADDRESS, ToRegisters(counterOptions), 10000);
     }
-    if (counterOptions._lockKbd.has_value())
+    using namespace SI30;
+    bool result{true};
+    result &= co_await WriteIfSetAsync<DecPoint>(counterOptions._decPoint);
+    result &= co_await WriteIfSetAsync<InputMode>(counterOptions._inputMode);
+    result &= co_await WriteIfSetAsync<OutputMode>(counterOptions._outputMode);
+    result &= co_await WriteIfSetAsync<PointMode>(counterOptions._pointMode);
+    result &= co_await WriteIfSetAsync<ResetType>(counterOptions._resetType);
+    result &= co_await WriteIfSetAsync<SetPoint1>(counterOptions._point1Threshold);
+    result &= co_await WriteIfSetAsync<SetPoint2>(counterOptions._point2Threshold);
+    result &= co_await WriteIfSetAsync<TimeOUT1>(counterOptions._timeout1);
+    result &= co_await WriteIfSetAsync<TimeOUT2>(counterOptions._timeout2);
+    result &= co_await WriteIfSetAsync<DecPointMult>(counterOptions._decPointMult);
+    result &= co_await WriteIfSetAsync<Multiplexer>(counterOptions._multiplexer);
+    result &= co_await WriteIfSetAsync<MaxFreq>(counterOptions._maxFreq);
+    result &= co_await WriteIfSetAsync<MinControl>(counterOptions._minControl);
+    result &= co_await WriteIfSetAsync<LockKBD>(counterOptions._lockKbd);
+    result &= co_await WriteIfSetAsync<ShowSetPoint>(counterOptions._showSetPoint);
+    result &= co_await WriteIfSetAsync<Brightness>(counterOptions._brightness);
+    result &= co_await WriteIfSetAsync<InputType>(counterOptions._inputType);
+    result &= co_await WriteIfSetAsync<Password>(counterOptions._password);
+    co_return result;
+  }
+
+  auto GetCounterOptionsAsync() -> Task<std::optional<ImpulseCounter30::CounterOptions>>
+  {
+    auto registers = co_await _modBus.ReadHoldingRegistersAsync(COUNTER_OPTIONS_ADDRESS, 13, 10000);
+    auto const registersContinue = co_await _modBus.ReadHoldingRegistersAsync(COUNTER_OPTIONS_ADDRESS + 13, COUNTER_OPTIONS_COUNT - 13, 10000);
+    registers.insert(registers.end(), registersContinue.cbegin(), registersContinue.cend());
+    if (registers.size() < COUNTER_OPTIONS_COUNT)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x001A, static_cast<uint16_t>(counterOptions._lockKbd.value()));
+      co_return std::nullopt;
     }
-    if (counterOptions._showSetPoint.has_value())
+    co_return ToCounterOptions(registers);
+  }
+
+  auto GetCounterValueAsync() -> Task<std::optional<int32_t>>
+  {
+    return SI30::ReadValueAsync<SI30::CounterValue>(_modBus);
+  }
+
+  auto GetCounterEUAsync() -> Task<std::optional<int32_t>>
+  {
+    // Read by halves like GetCounterEU()
+    auto const registers1 = co_await _modBus.ReadInputRegistersAsync(SI30::CounterEU::address, 1);
+    auto const registers2 = co_await _modBus.ReadInputRegistersAsync(SI30::CounterEU::address + 1, 1);
+    if ((registers1.size() != 1) || (registers2.size() != 1))
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x001B, static_cast<uint16_t>(counterOptions._showSetPoint.value()));
+      co_return std::nullopt;
     }
-    if (counterOptions._brightness.has_value())
+    uint16_t const registers[] = {registers1[0], registers2[0]};
+    co_return SI30::CounterEU::Decode(registers);
+  }
+
+  auto GetSnapshotAsync() -> Task<std::optional<ImpulseCounter30::Snapshot>>
+  {
+    using namespace SI30;
+    auto const values = co_await ReadAsync<CounterValue, CounterEU, StartStopMode, CurrentMode, CodeErrNet>(_modBus);
+    if (!values.has_value())
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x001C, static_cast<uint16_t>(counterOptions._brightness.value()));
+      co_return std::nullopt;
     }
-    if (counterOptions._inputType.has_value())
+    auto const& [counterValue, counterEU, startStopMode, currentMode, codeErrNet] = values.value();
+    co_return ImpulseCounter30::Snapshot{counterValue, counterEU, startStopMode, currentMode, codeErrNet};
+  }
+
+  auto GetStartStopModeAsync() -> Task<std::optional<bool>>
+  {
+    return SI30::ReadValueAsync<SI30::StartStopMode>(_modBus);
+  }
+
+  auto GetCurrentModeAsync() -> Task<std::optional<ImpulseCounter30::eCurrentMode>>
+  {
+    return SI30::ReadValueAsync<SI30::CurrentMode>(_modBus);
+  }
+
+  auto GetCodeErrNetAsync() -> Task<std::optional<uint8_t>>
+  {
+    return SI30::ReadValueAsync<SI30::CodeErrNet>(_modBus);
+  }
+
+  auto GetNameDeviceAsync() -> Task<std::optional<std::string>>
+  {
+    auto const registers = co_await _modBus.ReadInputRegistersAsync(SI30::NameDevice::address, SI30::NameDevice::width);
+    if (registers.size() != SI30::NameDevice::width)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x001D, static_cast<uint16_t>(counterOptions._inputType.value()));
+      co_return std::nullopt;
     }
-    if (counterOptions._password.has_value())
+    co_return std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2};
+  }
+
+  auto GetVersionAsync() -> Task<std::optional<std::string>>
+  {
+    auto const registers = co_await _modBus.ReadInputRegistersAsync(SI30::Version::address, SI30::Version::width);
+    if (registers.size() != SI30::Version::width)
     {
-      result &= _modBus.WriteSingleHoldingRegister(0x001E, static_cast<uint16_t>(counterOptions._password.value()));
+      co_return std::nullopt;
     }
-    return result;
+    co_return std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2};
   }
 
-  auto GetCounterValue() -> std::optional<int32_t>
+  auto IsResetInputAsync() -> Task<std::optional<bool>>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0000, 2);
-    return (registers.size() != 2)
-              ? std::optional<int32_t>{}
-              : std::optional<int32_t>{(((uint32_t)registers[0]) << 16) | (((uint32_t)registers[1]) & 0xFFFF)};
+    return SI30::ReadValueAsync<SI30::ResetInput>(_modBus);
   }
 
-  auto GetCounterEU() -> std::optional<int32_t>
+  auto IsLockInputAsync() -> Task<std::optional<bool>>
   {
-#if 0
-    auto const registers = _modBus.ReadInputRegisters(0x0002, 2);
-    return (registers.size() != 2)
-           ? std::optional<int32_t>{}
-           : std::optional<int32_t>{(((uint32_t)registers[0]) << 16) | (((uint32_t)registers[1]) & 0xFFFF)};
-#else
-    auto const registers1 = _modBus.ReadInputRegisters(0x0002, 1);
-    auto const registers2 = _modBus.ReadInputRegisters(0x0003, 1);
-    return ((registers1.size() != 1) || (registers2.size() != 1))
-           ? std::optional<int32_t>{}
-           : std::optional<int32_t>{(((uint32_t)registers1[0]) << 16) | (((uint32_t)registers2[0]) & 0xFFFF)};
-#endif
+    return SI30::ReadValueAsync<SI30::LockInput>(_modBus);
   }
 
-  auto GetStartStopMode() -> std::optional<bool>
+  auto GetOutState1Async() -> Task<std::optional<bool>>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0004, 1);
-    return (registers.size() != 1) ? std::optional<bool>{} : std::optional<bool>{static_cast<bool>(registers[0])};
+    return SI30::ReadValueAsync<SI30::OutState1>(_modBus);
   }
 
-  auto GetCurrentMode() -> std::optional<ImpulseCounter30::eCurrentMode>
+  auto GetOutState2Async() -> Task<std::optional<bool>>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0005, 1);
-    return (registers.size() != 1)
-              ? std::optional<ImpulseCounter30::eCurrentMode>{}
-              : std::optional<ImpulseCounter30::eCurrentMode>{static_cast<ImpulseCounter30::eCurrentMode>(registers[0])};
+    return SI30::ReadValueAsync<SI30::OutState2>(_modBus);
   }
 
-  auto GetCodeErrNet() -> std::optional<uint8_t>
+  auto IsResetCountAsync() -> Task<std::optional<bool>>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0006, 1);
-    return (registers.size() != 1) ? std::optional<uint8_t >{} : std::optional<uint8_t >{static_cast<uint8_t >(registers[0])};
+    return SI30::ReadValueAsync<SI30::ResetCount>(_modBus);
   }
 
-  auto GetNameDevice() -> std::optional<std::string>
+  auto ResetCountAsync() -> Task<bool>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0007, 2);
-    return (registers.size() != 2)
-           ? std::optional<std::string>{}
-           : std::optional<std::string>{std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2}};
+    return SI30::WriteValueAsync<SI30::ResetCount>(_modBus, true);
   }
 
-  auto GetVersion() -> std::optional<std::string>
+  auto ControlCounterFromProgramAsync(bool isEnabled) -> Task<bool>
   {
-    auto const registers = _modBus.ReadInputRegisters(0x0009, 2);
-    return (registers.size() != 2)
-           ? std::optional<std::string>{}
-           : std::optional<std::string>{std::string{reinterpret_cast<char const*>(registers.data()), registers.size() * 2}};
+    return SI30::WriteValueAsync<SI30::ControlFromProgram>(_modBus, isEnabled);
   }
 
-  auto IsResetInput() -> std::optional<bool>
+  auto StartCounterAsync(bool isStart) -> Task<bool>
   {
-     auto const bits = _modBus.ReadInputStatus(0x0000, 1);
-     return (bits.empty()) ? std::optional<bool>{} : std::optional<bool>{bits[0]};
+    return SI30::WriteValueAsync<SI30::StartCounter>(_modBus, isStart);
   }
 
-  auto IsLockInput() -> std::optional<bool>
+  auto GetRegisterImageAsync() -> Task<std::optional<ImpulseCounter30::RegisterImage>>
   {
-    auto const bits = _modBus.ReadInputStatus(0x0001, 1);
-    return (bits.empty()) ? std::optional<bool>{} : std::optional<bool>{bits[0]};
+    std::vector<ModBus::ReadRequest> requests{{static_cast<uint8_t>(SI30::eTable::COIL), 0, COILS_COUNT},
+                                              {static_cast<uint8_t>(SI30::eTable::DISCRETE_INPUT), 0, DISCRETE_INPUTS_COUNT},
+                                              {static_cast<uint8_t>(SI30::eTable::HOLDING), 0, HOLDING_REGISTERS_COUNT},
+                                              {static_cast<uint8_t>(SI30::eTable::INPUT), 0, INPUT_REGISTERS_COUNT}};
+    auto const values = co_await _modBus.ReadBatchAsync(std::move(requests));
+    if (std::any_of(values.cbegin(), values.cend(), [](auto const& value) { return value.empty(); }))
+    {
+      co_return std::nullopt;
+    }
+    co_return ImpulseCounter30::RegisterImage{{values[0].cbegin(), values[0].cend()},
+                                              {values[1].cbegin(), values[1].cend()},
+                                              values[2],
+                                              values[3]};
   }
 
-  auto GetOutState1() -> std::optional<bool>
+  auto WriteCoilAsync(uint16_t address, bool isOn) -> Task<bool>
   {
-    auto const bits = _modBus.ReadCoilStatus(0x0000, 1);
-    return (bits.empty()) ? std::optional<bool>{} : std::optional<bool>{bits[0]};
+    return _modBus.ForceSingleCoilAsync(address, isOn);
   }
 
-  auto GetOutState2() -> std::optional<bool>
+  auto WriteHoldingRegistersAsync(uint16_t address, std::vector<uint16_t> values) -> Task<bool>
   {
-    auto const bits = _modBus.ReadCoilStatus(0x0001, 1);
-    return (bits.empty()) ? std::optional<bool>{} : std::optional<bool>{bits[0]};
+    return _modBus.WriteMultipleHoldingRegisterAsync(address, std::move(values), 10000);
   }
+#endif
 
-  auto IsResetCount() -> std::optional<bool>
+private:
+  template <typename Reg, typename T>
+  bool WriteIfSet(std::optional<T> const& value)
   {
-    auto const bits = _modBus.ReadCoilStatus(0x0002, 1);
-    return (bits.empty()) ? std::optional<bool>{} : std::optional<bool>{bits[0]};
+    return !value.has_value() || SI30::WriteValue<Reg>(_modBus, static_cast<typename Reg::type>(value.value()));
   }
 
-  bool ResetCount()
+  /**
+   * Write all set registers of the block and verify them by reading the whole block back, by the frames of the
+   * device read splits. Last contiguous run of set registers is written by function 0x17 together with the readback
+   * of the first frame, preceding runs (if options have gaps) are written by function 0x10.
+   * If device rejects 0x17 it falls back to 0x10 + 0x03 for this and all next calls.
+   */
+  bool WriteWithReadback(uint16_t blockAddress, std::vector<std::optional<uint16_t>> const& image, uint16_t timeoutMs)
+  {
+    auto const blockCount = static_cast<uint16_t>(image.size());
+    auto const runs = RunsOf(blockAddress, image);
+    if (runs.empty())
+    {
+      return true;
+    }
+    for (auto it = runs.cbegin(); it != std::prev(runs.cend()); ++it)
+    {
+      if (!_modBus.WriteMultipleHoldingRegister(it->first, it->second, timeoutMs))
+      {
+        return false;
+      }
+    }
+    auto const frames = SI30::detail::SplitSpan(SI30::eTable::HOLDING, {blockAddress, blockCount});
+    auto frame = frames.cbegin();
+    std::vector<uint16_t> readback;
+    if (_readWriteMultipleSupported)
+    {
+      readback = _modBus.ReadWriteMultipleRegisters(frame->address, frame->count, runs.back().first, runs.back().second, timeoutMs);
+      if (readback.empty() && (_modBus.LastExceptionCode() == EXCEPTION_ILLEGAL_FUNCTION))
+      {
+        _readWriteMultipleSupported = false;
+      }
+      else if (readback.size() != frame->count)
+      {
+        return false;
+      }
+      else
+      {
+        ++frame;
+      }
+    }
+    if (!_readWriteMultipleSupported && !_modBus.WriteMultipleHoldingRegister(runs.back().first, runs.back().second, timeoutMs))
+    {
+      return false;
+    }
+    for (; frame != frames.cend(); ++frame)
+    {
+      auto const values = _modBus.ReadHoldingRegisters(frame->address, frame->count, timeoutMs);
+      if (values.size() != frame->count)
+      {
+        return false;
+      }
+      readback.insert(readback.end(), values.cbegin(), values.cend());
+    }
+    return IsReadBack(image, readback);
+  }
+
+#if defined(OWEN_COROUTINES)
+  template <typename Reg, typename T>
+  auto WriteIfSetAsync(std::optional<T> value) -> Task<bool>
   {
-    return _modBus.ForceSingleCoil(0x0002, true);
+    co_return !value.has_value() || co_await SI30::WriteValueAsync<Reg>(_modBus, static_cast<typename Reg::type>(value.value()));
   }
 
-  bool ControlCounterFromProgram(bool isEnabled)
+  /**
+   * Awaitable version of WriteWithReadback().
+   */
+  auto WriteWithReadbackAsync(uint16_t blockAddress, std::vector<std::optional<uint16_t>> image, uint16_t timeoutMs) -> Task<bool>
   {
-    return _modBus.ForceSingleCoil(0x0003, isEnabled);
+    auto const blockCount = static_cast<uint16_t>(image.size());
+    auto const runs = RunsOf(blockAddress, image);
+    if (runs.empty())
+    {
+      co_return true;
+    }
+    for (auto it = runs.cbegin(); it != std::prev(runs.cend()); ++it)
+    {
+      if (!co_await _modBus.WriteMultipleHoldingRegisterAsync(it->first, it->second, timeoutMs))
+      {
+        co_return false;
+      }
+    }
+    auto const frames = SI30::detail::SplitSpan(SI30::eTable::HOLDING, {blockAddress, blockCount});
+    auto frame = frames.cbegin();
+    std::vector<uint16_t> readback;
+    if (_readWriteMultipleSupported)
+    {
+      readback = co_await _modBus.ReadWriteMultipleRegistersAsync(frame->address, frame->count, runs.back().first, runs.back().second, timeoutMs);
+      if (readback.empty() && (_modBus.LastExceptionCode() == EXCEPTION_ILLEGAL_FUNCTION))
+      {
+        _readWriteMultipleSupported = false;
+      }
+      else if (readback.size() != frame->count)
+      {
+        co_return false;
+      }
+      else
+      {
+        ++frame;
+      }
+    }
+    if (!_readWriteMultipleSupported && !co_await _modBus.WriteMultipleHoldingRegisterAsync(runs.back().first, runs.back().second, timeoutMs))
+    {
+      co_return false;
+    }
+    for (; frame != frames.cend(); ++frame)
+    {
+      auto const values = co_await _modBus.ReadHoldingRegistersAsync(frame->address, frame->count, timeoutMs);
+      if (values.size() != frame->count)
+      {
+        co_return false;
+      }
+      readback.insert(readback.end(), values.cbegin(), values.cend());
+    }
+    co_return IsReadBack(image, readback);
   }
+#endif
 
-  bool StartCounter(bool isStart)
+  /**
+   * Contiguous runs of set registers of the block: address and values.
+   */
+  static auto RunsOf(uint16_t blockAddress, std::vector<std::optional<uint16_t>> const& image)
+    -> std::vector<std::pair<uint16_t, std::vector<uint16_t>>>
   {
-    return _modBus.ForceSingleCoil(0x0004, isStart);
+    std::vector<std::pair<uint16_t, std::vector<uint16_t>>> runs;
+    for (uint16_t i = 0; i < image.size(); ++i)
+    {
+      if (!image[i].has_value())
+      {
+        continue;
+      }
+      if (runs.empty() || ((runs.back().first + runs.back().second.size()) != (blockAddress + i)))
+      {
+        runs.emplace_back(static_cast<uint16_t>(blockAddress + i), std::vector<uint16_t>{});
+      }
+      runs.back().second.emplace_back(image[i].value());
+    }
+    return runs;
   }
 
-  bool StopCounter(bool isStop)
+  /**
+   * True if every set register of the block was read back equal.
+   */
+  static bool IsReadBack(std::vector<std::optional<uint16_t>> const& image, std::vector<uint16_t> const& readback)
   {
-    return StartCounter(!isStop);
+    if (readback.size() != image.size())
+    {
+      return false;
+    }
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+      if (image[i].has_value() && (image[i].value() != readback[i]))
+      {
+        return false;
+      }
+    }
+    return true;
   }
 
-private:
-  SerialPort _serialPort;
+  std::unique_ptr<Transport> _transport;
   ModBus _modBus;
+  ModBus _broadcastModBus;
+  bool _readWriteMultipleSupported{true};
 };
 
 ImpulseCounter30::ImpulseCounter30(CommunicationOptions const& communicationOptions, bool neededToBeFound, tFindProgress progress)
@@ -440,9 +903,14 @@ ImpulseCounter30::ImpulseCounter30(ImpulseCounter30&&) noexcept = default;
 
 ImpulseCounter30& ImpulseCounter30::operator=(ImpulseCounter30&&) noexcept = default;
 
-bool ImpulseCounter30::SetCommunicationOptions(CommunicationOptions const& communicationOptions)
+auto ImpulseCounter30::ConnectAsync(CommunicationOptions const& communicationOptions) -> std::future<ImpulseCounter30>
+{
+   return Connector::Shared().Connect(communicationOptions);
+}
+
+bool ImpulseCounter30::SetCommunicationOptions(CommunicationOptions const& communicationOptions, bool readback)
 {
-   return pImpl->SetCommunicationOptions(communicationOptions);
+   return pImpl->SetCommunicationOptions(communicationOptions, readback);
 }
 
 auto ImpulseCounter30::GetCommunicationOptions() -> std::optional<CommunicationOptions>
@@ -450,9 +918,9 @@ auto ImpulseCounter30::GetCommunicationOptions() -> std::optional<CommunicationO
    return pImpl->GetCommunicationOptions();
 }
 
-bool ImpulseCounter30::SetCounterOptions(CounterOptions const& counterOptions)
+bool ImpulseCounter30::SetCounterOptions(CounterOptions const& counterOptions, bool readback)
 {
-   return pImpl->SetCounterOptions(counterOptions);
+   return pImpl->SetCounterOptions(counterOptions, readback);
 }
 
 auto ImpulseCounter30::GetCounterOptions() -> std::optional<CounterOptions>
@@ -470,6 +938,11 @@ auto ImpulseCounter30::GetCounterEU() -> std::optional<int32_t>
   return pImpl->GetCounterEU();
 }
 
+auto ImpulseCounter30::GetSnapshot() -> std::optional<Snapshot>
+{
+  return pImpl->GetSnapshot();
+}
+
 auto ImpulseCounter30::GetStartStopMode() -> std::optional<bool>
 {
   return pImpl->GetStartStopMode();
@@ -540,6 +1013,173 @@ bool ImpulseCounter30::StopCounter(bool isStop)
   return pImpl->StopCounter(isStop);
 }
 
+bool ImpulseCounter30::BroadcastCounterOptions(CounterOptions const& counterOptions, uint16_t turnaroundMs)
+{
+  return pImpl->BroadcastCounterOptions(counterOptions, turnaroundMs);
+}
+
+bool ImpulseCounter30::BroadcastResetCount(uint16_t turnaroundMs)
+{
+  return pImpl->BroadcastResetCount(turnaroundMs);
+}
+
+bool ImpulseCounter30::BroadcastStartCounter(bool isStart, uint16_t turnaroundMs)
+{
+  return pImpl->BroadcastStartCounter(isStart, turnaroundMs);
+}
+
+auto ImpulseCounter30::GetRegisterImage() -> std::optional<RegisterImage>
+{
+  return pImpl->GetRegisterImage();
+}
+
+bool ImpulseCounter30::WriteCoil(uint16_t address, bool isOn)
+{
+  return pImpl->WriteCoil(address, isOn);
+}
+
+bool ImpulseCounter30::WriteHoldingRegisters(uint16_t address, std::vector<uint16_t> const& values)
+{
+  return pImpl->WriteHoldingRegisters(address, values);
+}
+
+auto ImpulseCounter30::LastExceptionCode() const -> uint8_t
+{
+  return pImpl->LastExceptionCode();
+}
+
+#if defined(OWEN_COROUTINES)
+auto ImpulseCounter30::SetCommunicationOptionsAsync(CommunicationOptions communicationOptions, bool readback) -> Task<bool>
+{
+   return pImpl->SetCommunicationOptionsAsync(communicationOptions, readback);
+}
+
+auto ImpulseCounter30::GetCommunicationOptionsAsync() -> Task<std::optional<CommunicationOptions>>
+{
+   return pImpl->GetCommunicationOptionsAsync();
+}
+
+auto ImpulseCounter30::SetCounterOptionsAsync(CounterOptions counterOptions, bool readback) -> Task<bool>
+{
+   return pImpl->SetCounterOptionsAsync(counterOptions, readback);
+}
+
+auto ImpulseCounter30::GetCounterOptionsAsync() -> Task<std::optional<CounterOptions>>
+{
+   return pImpl->GetCounterOptionsAsync();
+}
+
+auto ImpulseCounter30::GetCounterValueAsync() -> Task<std::optional<int32_t>>
+{
+   return pImpl->GetCounterValueAsync();
+}
+
+auto ImpulseCounter30::GetCounterEUAsync() -> Task<std::optional<int32_t>>
+{
+   return pImpl->GetCounterEUAsync();
+}
+
+auto ImpulseCounter30::GetSnapshotAsync() -> Task<std::optional<Snapshot>>
+{
+   return pImpl->GetSnapshotAsync();
+}
+
+auto ImpulseCounter30::GetStartStopModeAsync() -> Task<std::optional<bool>>
+{
+   return pImpl->GetStartStopModeAsync();
+}
+
+auto ImpulseCounter30::GetCurrentModeAsync() -> Task<std::optional<eCurrentMode>>
+{
+   return pImpl->GetCurrentModeAsync();
+}
+
+auto ImpulseCounter30::GetCodeErrNetAsync() -> Task<std::optional<uint8_t>>
+{
+   return pImpl->GetCodeErrNetAsync();
+}
+
+auto ImpulseCounter30::GetNameDeviceAsync() -> Task<std::optional<std::string>>
+{
+   return pImpl->GetNameDeviceAsync();
+}
+
+auto ImpulseCounter30::GetVersionAsync() -> Task<std::optional<std::string>>
+{
+   return pImpl->GetVersionAsync();
+}
+
+auto ImpulseCounter30::IsResetInputAsync() -> Task<std::optional<bool>>
+{
+   return pImpl->IsResetInputAsync();
+}
+
+auto ImpulseCounter30::IsLockInputAsync() -> Task<std::optional<bool>>
+{
+   return pImpl->IsLockInputAsync();
+}
+
+auto ImpulseCounter30::GetOutState1Async() -> Task<std::optional<bool>>
+{
+   return pImpl->GetOutState1Async();
+}
+
+auto ImpulseCounter30::GetOutState2Async() -> Task<std::optional<bool>>
+{
+   return pImpl->GetOutState2Async();
+}
+
+auto ImpulseCounter30::IsResetCountAsync() -> Task<std::optional<bool>>
+{
+   return pImpl->IsResetCountAsync();
+}
+
+auto ImpulseCounter30::ResetCountAsync() -> Task<bool>
+{
+   return pImpl->ResetCountAsync();
+}
+
+auto ImpulseCounter30::ControlCounterFromProgramAsync(bool isEnabled) -> Task<bool>
+{
+   return pImpl->ControlCounterFromProgramAsync(isEnabled);
+}
+
+auto ImpulseCounter30::StartCounterAsync(bool isStart) -> Task<bool>
+{
+   return pImpl->StartCounterAsync(isStart);
+}
+
+auto ImpulseCounter30::StopCounterAsync(bool isStop) -> Task<bool>
+{
+   return pImpl->StartCounterAsync(!isStop);
+}
+
+auto ImpulseCounter30::GetRegisterImageAsync() -> Task<std::optional<RegisterImage>>
+{
+   return pImpl->GetRegisterImageAsync();
+}
+
+auto ImpulseCounter30::WriteCoilAsync(uint16_t address, bool isOn) -> Task<bool>
+{
+   return pImpl->WriteCoilAsync(address, isOn);
+}
+
+auto ImpulseCounter30::WriteHoldingRegistersAsync(uint16_t address, std::vector<uint16_t> values) -> Task<bool>
+{
+   return pImpl->WriteHoldingRegistersAsync(address, std::move(values));
+}
+#endif
+
+auto ImpulseCounter30::GetMetrics() const -> std::vector<DeviceMetrics>
+{
+  return pImpl->GetMetrics();
+}
+
+void ImpulseCounter30::GetMetrics(std::vector<DeviceMetrics>& metrics) const
+{
+  pImpl->GetMetrics(metrics);
+}
+
 auto operator<<(std::ostream& out, OWEN::ImpulseCounter30::CommunicationOptions::eBaudrate const& baudrate) -> std::ostream&
 {
   using eBaudrate = OWEN::ImpulseCounter30::CommunicationOptions::eBaudrate;
@@ -0,0 +1,285 @@
+#include <OWEN/LinkTuner.hpp>
+
+#include "SerialLine.hpp"
+#include "TransportFactory.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/serial_port.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace OWEN {
+
+namespace {
+
+using CommunicationOptions = ImpulseCounter30::CommunicationOptions;
+
+constexpr uint32_t OPEN_ATTEMPTS = 3;
+/// A write is applied even if its reply is lost on the failing link, so it is repeated until the counter answers
+constexpr uint32_t ROLLBACK_ATTEMPTS = 10;
+
+auto Next(LinkTuner::eBaudrate baudrate) -> LinkTuner::eBaudrate
+{
+  return static_cast<LinkTuner::eBaudrate>(static_cast<uint32_t>(baudrate) + 1);
+}
+
+} /// end namespace anonymous
+
+LinkTuner::LinkTuner(CommunicationOptions const& communicationOptions, std::vector<uint8_t> addresses, Options options)
+  : _communicationOptions{communicationOptions}
+  , _addresses{std::move(addresses)}
+  , _options{options}
+{
+}
+
+void LinkTuner::OnProgress(tProgress progress)
+{
+  _progress = std::move(progress);
+}
+
+auto LinkTuner::Run() -> Result
+{
+  if (IsTransportUrl(_communicationOptions._portPath))
+  {
+    throw std::runtime_error("Link of " + _communicationOptions._portPath + " can not be tuned");
+  }
+  Result result;
+  result.baudrate = _communicationOptions._baudrate.value();
+  _baudrates = SupportedBaudrates();
+  tCounters counters;
+  for (auto const address : _addresses)
+  {
+    auto counter = Open(address, result.baudrate);
+    if (!counter)
+    {
+      throw std::runtime_error("Counter " + std::to_string(address) + " does not answer with the current options");
+    }
+    counters.emplace(address, std::move(counter));
+  }
+  counters = TuneBaudrate(std::move(counters), result);
+  for (auto& counter : counters)
+  {
+    TuneDelayAnswer(counter.first, *counter.second, result.baudrate, result);
+  }
+  return result;
+}
+
+auto LinkTuner::SupportedBaudrates() const -> std::vector<eBaudrate>
+{
+  std::vector<eBaudrate> baudrates;
+  boost::asio::io_service io;
+  for (auto baudrate = eBaudrate::_2400bps; baudrate <= eBaudrate::_115200bps; baudrate = Next(baudrate))
+  {
+    auto communicationOptions = _communicationOptions;
+    boost::asio::serial_port port{io};
+    try
+    {
+      SerialSettingsOf(communicationOptions.BaudeRate(baudrate)).Open(port, _communicationOptions._portPath);
+      baudrates.push_back(baudrate);
+    }
+    catch (boost::system::system_error const&)
+    {
+    }
+  }
+  return baudrates;
+}
+
+auto LinkTuner::Open(uint8_t address, eBaudrate baudrate) const -> std::unique_ptr<ImpulseCounter30>
+{
+  auto communicationOptions = _communicationOptions;
+  communicationOptions.BaudeRate(baudrate).BaseAddr(address);
+  for (uint32_t attempt = 0; attempt < OPEN_ATTEMPTS; ++attempt)
+  {
+    try
+    {
+      return std::make_unique<ImpulseCounter30>(communicationOptions);
+    }
+    catch (std::exception const&)
+    {
+    }
+  }
+  return nullptr;
+}
+
+void LinkTuner::Burst(ImpulseCounter30& counter, Step& step) const
+{
+  auto const allowed = static_cast<uint32_t>(_options.errorBudget * _options.burstReads);
+  uint32_t errors{};
+  for (uint32_t read = 0; (read < _options.burstReads) && (errors <= allowed); ++read)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    auto const value = counter.GetCounterValue();
+    auto const roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    ++step.reads;
+    if (!value.has_value())
+    {
+      ++errors;
+      ++step.errors;
+      continue;
+    }
+    auto const answered = static_cast<int64_t>(step.reads - step.errors);
+    step.meanRoundTrip += (roundTrip - step.meanRoundTrip) / answered;
+  }
+}
+
+bool LinkTuner::IsWithinBudget(Step const& step) const
+{
+  return (step.reads != 0) && (step.errors <= (_options.errorBudget * step.reads));
+}
+
+auto LinkTuner::TuneBaudrate(tCounters counters, Result& result) -> tCounters
+{
+  for (auto const candidate : _baudrates)
+  {
+    if ((candidate <= result.baudrate) || (candidate > _options.maxBaudrate))
+    {
+      continue;
+    }
+    // The reply comes with the old baudrate or is lost, the burst tells whether the counters switched
+    for (auto& counter : counters)
+    {
+      counter.second->SetCommunicationOptions(CommunicationOptions{}.BaudeRate(candidate));
+    }
+    counters.clear();
+
+    Step step;
+    step.baudrate = candidate;
+    tCounters probed;
+    for (auto const address : _addresses)
+    {
+      auto counter = Open(address, candidate);
+      if (!counter)
+      {
+        break;
+      }
+      Burst(*counter, step);
+      probed.emplace(address, std::move(counter));
+      if (!IsWithinBudget(step))
+      {
+        break;
+      }
+    }
+    step.accepted = (probed.size() == _addresses.size()) && IsWithinBudget(step);
+    Report(step, result);
+    if (!step.accepted)
+    {
+      probed.clear();
+      result.rolledBack = true;
+      return RollBackBaudrate(candidate, result.baudrate, result);
+    }
+    result.baudrate = candidate;
+    counters = std::move(probed);
+  }
+  return counters;
+}
+
+auto LinkTuner::RollBackBaudrate(eBaudrate failed, eBaudrate working, Result& result) -> tCounters
+{
+  // Only one counter is open at a time: the port keeps the baudrate it was opened with while any of them is open
+  auto const isBack = [&](uint8_t address) {
+    auto counter = Open(address, working);
+    for (uint32_t attempt = 0; counter && (attempt < OPEN_ATTEMPTS); ++attempt)
+    {
+      // A counter which applies options only after restart answers with the working baudrate but keeps the failed one
+      auto const options = counter->GetCommunicationOptions();
+      if (options.has_value() && (options->_baudrate == working))
+      {
+        return true;
+      }
+      counter->SetCommunicationOptions(CommunicationOptions{}.BaudeRate(working));
+    }
+    return false;
+  };
+  auto const writeBack = [&](uint8_t address, eBaudrate baudrate) {
+    if (auto stray = Open(address, baudrate))
+    {
+      stray->SetCommunicationOptions(CommunicationOptions{}.BaudeRate(working));
+    }
+    return isBack(address);
+  };
+  for (auto const address : _addresses)
+  {
+    auto isAddressBack = isBack(address);
+    for (uint32_t attempt = 0; (attempt < ROLLBACK_ATTEMPTS) && !isAddressBack; ++attempt)
+    {
+      isAddressBack = writeBack(address, failed);
+    }
+    // Discovery of the counter by its address, framing is never changed by tuning
+    for (size_t i = 0; !isAddressBack && (i < _baudrates.size()); ++i)
+    {
+      if ((_baudrates[i] != working) && (_baudrates[i] != failed))
+      {
+        isAddressBack = writeBack(address, _baudrates[i]);
+      }
+    }
+  }
+
+  tCounters counters;
+  for (auto const address : _addresses)
+  {
+    if (auto counter = Open(address, working))
+    {
+      counters.emplace(address, std::move(counter));
+    }
+    else
+    {
+      result.lost.push_back(address);
+    }
+  }
+  return counters;
+}
+
+void LinkTuner::TuneDelayAnswer(uint8_t address, ImpulseCounter30& counter, eBaudrate baudrate, Result& result)
+{
+  auto const current = counter.GetCommunicationOptions();
+  if (!current.has_value())
+  {
+    return;
+  }
+  auto working = current->_delayAnswerMs.value();
+  result.delayAnswerMs[address] = working;
+  while (working > _options.minDelayAnswerMs)
+  {
+    auto const candidate = std::max<uint8_t>(working / 2, _options.minDelayAnswerMs);
+    counter.SetCommunicationOptions(CommunicationOptions{}.DelayAnswer(candidate));
+    Step step;
+    step.baudrate = baudrate;
+    step.address = address;
+    step.delayAnswerMs = candidate;
+    Burst(counter, step);
+    step.accepted = IsWithinBudget(step);
+    Report(step, result);
+    if (!step.accepted)
+    {
+      result.rolledBack = true;
+      auto isBack = false;
+      for (uint32_t attempt = 0; (attempt < ROLLBACK_ATTEMPTS) && !isBack; ++attempt)
+      {
+        counter.SetCommunicationOptions(CommunicationOptions{}.DelayAnswer(working));
+        auto const readBack = counter.GetCommunicationOptions();
+        isBack = readBack.has_value() && (readBack->_delayAnswerMs == working);
+      }
+      if (!isBack)
+      {
+        result.delayAnswerMs.erase(address);
+        result.lost.push_back(address);
+      }
+      return;
+    }
+    working = candidate;
+    result.delayAnswerMs[address] = working;
+  }
+}
+
+void LinkTuner::Report(Step const& step, Result& result) const
+{
+  result.steps.push_back(step);
+  if (_progress)
+  {
+    _progress(step);
+  }
+}
+
+} /// end namespace OWEN
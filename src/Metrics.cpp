@@ -0,0 +1,51 @@
+#include <OWEN/Metrics.hpp>
+
+#include <algorithm>
+#include <iomanip>
+
+namespace OWEN {
+
+auto LatencyHistogram::Percentile(double percentile) const -> uint64_t
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+  auto const rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile * count + 0.5));
+  uint64_t accumulated{};
+  for (uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+  {
+    accumulated += counts[bucket];
+    if (accumulated >= rank)
+    {
+      auto const upperBound = (bucket + 1 < BUCKET_COUNT) ? (LowerBoundOf(bucket + 1) - 1) : maxUs;
+      return std::min(upperBound, maxUs);
+    }
+  }
+  return maxUs;
+}
+
+std::ostream& operator<<(std::ostream& out, OWEN::DeviceMetrics const& deviceMetrics)
+{
+  auto const flags = out.flags();
+  out << std::dec << "Device " << static_cast<uint32_t>(deviceMetrics.address) << ":";
+  for (auto const& functionMetrics : deviceMetrics.functions)
+  {
+    out << "\n  0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(functionMetrics.function)
+        << std::dec << std::setfill(' ')
+        << " requests " << functionMetrics.requests
+        << " timeouts " << functionMetrics.timeouts
+        << " bad frames " << functionMetrics.badFrames
+        << " exceptions " << functionMetrics.exceptions
+        << " sent " << functionMetrics.bytesSent << " B"
+        << " received " << functionMetrics.bytesReceived << " B"
+        << " latency us mean " << static_cast<uint64_t>(functionMetrics.latency.MeanUs())
+        << " p50 " << functionMetrics.latency.Percentile(0.5)
+        << " p99 " << functionMetrics.latency.Percentile(0.99)
+        << " max " << functionMetrics.latency.maxUs;
+  }
+  out.flags(flags);
+  return out;
+}
+
+} /// end namespace OWEN
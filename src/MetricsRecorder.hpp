@@ -0,0 +1,132 @@
+#pragma once
+
+#include <OWEN/Metrics.hpp>
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * Lock-free recorder of per-function transaction metrics of one device.
+ * Record() is called on the transaction path and only does relaxed atomic increments,
+ * Snapshot() can be called from any thread at any time.
+ */
+class MetricsRecorder
+{
+public:
+  enum class eOutcome
+  {
+    OK,
+    TIMEOUT,
+    BAD_FRAME,
+    EXCEPTION
+  };
+
+public:
+  void Record(uint8_t function, eOutcome outcome, size_t bytesSent, size_t bytesReceived, std::chrono::steady_clock::duration latency) noexcept
+  {
+    auto* counters = CountersOf(function);
+    if (counters == nullptr)
+    {
+      return;
+    }
+    auto const latencyUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    counters->requests.fetch_add(1, std::memory_order_relaxed);
+    switch (outcome)
+    {
+      case eOutcome::TIMEOUT:
+        counters->timeouts.fetch_add(1, std::memory_order_relaxed);
+        break;
+      case eOutcome::BAD_FRAME:
+        counters->badFrames.fetch_add(1, std::memory_order_relaxed);
+        break;
+      case eOutcome::EXCEPTION:
+        counters->exceptions.fetch_add(1, std::memory_order_relaxed);
+        break;
+      default:
+        break;
+    }
+    counters->bytesSent.fetch_add(bytesSent, std::memory_order_relaxed);
+    counters->bytesReceived.fetch_add(bytesReceived, std::memory_order_relaxed);
+    counters->buckets[OWEN::LatencyHistogram::BucketOf(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+    counters->sumUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    auto maxUs = counters->maxUs.load(std::memory_order_relaxed);
+    while ((latencyUs > maxUs) && !counters->maxUs.compare_exchange_weak(maxUs, latencyUs, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  auto Snapshot(uint8_t address) const -> OWEN::DeviceMetrics
+  {
+    OWEN::DeviceMetrics deviceMetrics{};
+    Snapshot(address, deviceMetrics);
+    return deviceMetrics;
+  }
+
+  /**
+   * Same as above, storage of deviceMetrics is reused, so it does not allocate once all used functions have been seen.
+   */
+  void Snapshot(uint8_t address, OWEN::DeviceMetrics& deviceMetrics) const
+  {
+    deviceMetrics.address = address;
+    deviceMetrics.functions.clear();
+    for (size_t i = 0; i < FUNCTION_COUNT; ++i)
+    {
+      auto const& counters = _counters[i];
+      if (counters.requests.load(std::memory_order_relaxed) == 0)
+      {
+        continue;
+      }
+      OWEN::FunctionMetrics functionMetrics{};
+      functionMetrics.function = FUNCTIONS[i];
+      functionMetrics.requests = counters.requests.load(std::memory_order_relaxed);
+      functionMetrics.timeouts = counters.timeouts.load(std::memory_order_relaxed);
+      functionMetrics.badFrames = counters.badFrames.load(std::memory_order_relaxed);
+      functionMetrics.exceptions = counters.exceptions.load(std::memory_order_relaxed);
+      functionMetrics.bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+      functionMetrics.bytesReceived = counters.bytesReceived.load(std::memory_order_relaxed);
+      for (size_t bucket = 0; bucket < OWEN::LatencyHistogram::BUCKET_COUNT; ++bucket)
+      {
+        functionMetrics.latency.counts[bucket] = counters.buckets[bucket].load(std::memory_order_relaxed);
+        functionMetrics.latency.count += functionMetrics.latency.counts[bucket];
+      }
+      functionMetrics.latency.sumUs = counters.sumUs.load(std::memory_order_relaxed);
+      functionMetrics.latency.maxUs = counters.maxUs.load(std::memory_order_relaxed);
+      deviceMetrics.functions.emplace_back(functionMetrics);
+    }
+  }
+
+private:
+  static constexpr size_t FUNCTION_COUNT = 8;
+  static constexpr uint8_t FUNCTIONS[FUNCTION_COUNT] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x10, 0x17};
+
+  struct Counters
+  {
+    std::atomic<uint64_t> requests{};
+    std::atomic<uint64_t> timeouts{};
+    std::atomic<uint64_t> badFrames{};
+    std::atomic<uint64_t> exceptions{};
+    std::atomic<uint64_t> bytesSent{};
+    std::atomic<uint64_t> bytesReceived{};
+    std::array<std::atomic<uint64_t>, OWEN::LatencyHistogram::BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> sumUs{};
+    std::atomic<uint64_t> maxUs{};
+  };
+
+  auto CountersOf(uint8_t function) noexcept -> Counters*
+  {
+    switch (function)
+    {
+      case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+        return &_counters[function - 1];
+      case 0x10:
+        return &_counters[6];
+      case 0x17:
+        return &_counters[7];
+      default:
+        return nullptr;
+    }
+  }
+
+private:
+  std::array<Counters, FUNCTION_COUNT> _counters{};
+};
@@ -1,350 +1,621 @@
 #include "ModBus.hpp"
 
-#include "SerialPort.hpp"
-#include "crc16.hpp"
+#include "FrameLogger.hpp"
+#include "ModBusCodec.hpp"
+#include "Transport.hpp"
 
-#ifndef DEBUG_INFO
-#define DEBUG_INFO 0
-#endif
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <thread>
 
-#if DEBUG_INFO
-#include <iostream>
+#if defined(OWEN_COROUTINES)
+#include <atomic>
+#include <coroutine>
+#include <utility>
 #endif
 
-ModBus::ModBus(SerialPort& serialPort, uint8_t deviceAddress)
-  : _deviceAddress{deviceAddress}
-  , _serialPort{serialPort}
+namespace {
+
+/**
+ * Response is complete when it has expected length or it is an exception response.
+ */
+auto ResponseOfLength(size_t length) -> Transport::tResponseComplete
 {
+  return [length](std::string const& response) {
+    return ModBusCodec::IsResponseComplete(response, length);
+  };
 }
 
-auto ModBus::ReadCoilStatus(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>
+#if defined(OWEN_COROUTINES)
+/**
+ * Awaitable exchange of the transport. The transport may complete it before AsyncSendCommand() returns (synchronous
+ * transports do) or later on another thread, whichever of the two comes second goes on with the coroutine.
+ */
+class Exchange
 {
-  // TODO: Same as 02 Should be moved to dedicated function
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x01,
-                      static_cast<char>(startRegisterAddress >> 8),
-                      static_cast<char>(startRegisterAddress & 0xFF),
-                      static_cast<char>(count >> 8),
-                      static_cast<char>(count & 0xFF)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+public:
+  Exchange(Transport& transport, std::string const& request, uint16_t timeoutMs, Transport::tResponseComplete isComplete)
+    : _transport{transport}
+    , _request{request}
+    , _timeoutMs{timeoutMs}
+    , _isComplete{std::move(isComplete)}
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
   }
-  std::cout << std::endl;
-#endif
 
-  std::vector<bool> requestedInputStatus{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    if (error ||
-        (response.size() < (5 + count/8)) ||
-        (response[0] != static_cast<char>(_deviceAddress)) ||
-        (response[1] != 0x01) ||
-        (response[2] != count/8) ||
-        (Crc16(reinterpret_cast<uint8_t const*>(response.data()), response.size() - 2) != ((((uint8_t)*std::prev(response.cend(), 2)) << 8) | ((uint8_t)response.back()))))
-    {
-      return;
-    }
-    requestedInputStatus.reserve(count);
-    auto currentRegIt = std::next(response.cbegin(), 3);
-    auto endRegIt = std::prev(response.cend(), 2);
-    while ((currentRegIt != endRegIt) && (count != 0))
-    {
-      auto bits = 0;
-      while ((count-- != 0) && (bits++ < 16))
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle)
+  {
+    _handle = handle;
+    _transport.AsyncSendCommand(_request, [this](std::string const& response, bool error) {
+      _response = response;
+      _error = error;
+      if (_completed.exchange(true))
       {
-        requestedInputStatus.emplace_back(*currentRegIt & (1 << bits));
+        _handle.resume();
       }
-      currentRegIt += 2;
-    }
-  }, timeoutMs);
-  return requestedInputStatus;
+    }, _timeoutMs, std::move(_isComplete));
+    return !_completed.exchange(true);
+  }
+
+  auto await_resume() -> std::pair<std::string, bool>
+  {
+    return {std::move(_response), _error};
+  }
+
+private:
+  Transport& _transport;
+  std::string const& _request;
+  uint16_t _timeoutMs{};
+  Transport::tResponseComplete _isComplete;
+  std::coroutine_handle<> _handle;
+  std::string _response;
+  bool _error{true};
+  std::atomic<bool> _completed{};
+};
+#endif
+
+} /// end namespace anonymous
+
+ModBus::ModBus(Transport& transport, uint8_t deviceAddress)
+  : _transport{transport}
+  , _deviceAddress{deviceAddress}
+  , _logChannel{FrameLogger::Instance().ChannelOf(transport.Path())}
+{
 }
 
-auto ModBus::ReadInputStatus(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>
+auto ModBus::Metrics() const -> OWEN::DeviceMetrics
 {
-  // TODO: Same as 01 Should be moved to dedicated function
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x02,
-                      static_cast<char>(startRegisterAddress >> 8),
-                      static_cast<char>(startRegisterAddress & 0xFF),
-                      static_cast<char>(count >> 8),
-                      static_cast<char>(count & 0xFF)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+  return _metrics.Snapshot(_deviceAddress);
+}
+
+void ModBus::Metrics(OWEN::DeviceMetrics& deviceMetrics) const
+{
+  _metrics.Snapshot(_deviceAddress, deviceMetrics);
+}
+
+bool ModBus::SendBroadcast(std::string const& request)
+{
+  auto const start = std::chrono::steady_clock::now();
+  auto const result = _transport.Send(request);
+  auto const outcome = result ? MetricsRecorder::eOutcome::OK : MetricsRecorder::eOutcome::TIMEOUT;
+  _metrics.Record(static_cast<uint8_t>(request[1]), outcome, request.size(), 0, std::chrono::steady_clock::now() - start);
+  auto& frameLogger = FrameLogger::Instance();
+  if (frameLogger.IsEnabled(!result))
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+    frameLogger.Push(_logChannel,
+                     FrameLogFormat::eDirection::TX,
+                     static_cast<FrameLogFormat::eOutcome>(outcome),
+                     std::chrono::system_clock::now(),
+                     request);
   }
-  std::cout << std::endl;
-#endif
+  std::this_thread::sleep_for(std::chrono::milliseconds(_broadcastTurnaroundMs));
+  return result;
+}
 
-  std::vector<bool> requestedInputStatus{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    if (error ||
-        (response.size() < (5 + count/8)) ||
-        (response[0] != static_cast<char>(_deviceAddress)) ||
-        (response[1] != 0x02) ||
-        (response[2] != count/8) ||
-        (Crc16(reinterpret_cast<uint8_t const*>(response.data()), response.size() - 2) != ((((uint8_t)*std::prev(response.cend(), 2)) << 8) | ((uint8_t)response.back()))))
-    {
-      return;
-    }
-    requestedInputStatus.reserve(count);
-    auto currentRegIt = std::next(response.cbegin(), 3);
-    auto endRegIt = std::prev(response.cend(), 2);
-    while ((currentRegIt != endRegIt) && (count != 0))
-    {
-      auto bits = 0;
-      while ((count-- != 0) && (bits++ < 16))
-      {
-        requestedInputStatus.emplace_back(*currentRegIt & (1 << bits));
-      }
-      currentRegIt += 2;
-    }
-  }, timeoutMs);
-  return requestedInputStatus;
+template <typename Validate>
+bool ModBus::Transact(uint8_t function, std::string const& request, size_t responseSize, uint16_t timeoutMs, Validate&& validate)
+{
+  _lastExceptionCode = 0;
+  auto outcome = MetricsRecorder::eOutcome::TIMEOUT;
+  auto const start = std::chrono::steady_clock::now();
+  _transport.SendCommand(request, [&](std::string const& response, bool error) {
+    outcome = Complete(function, request, response, error, start, validate);
+  }, timeoutMs, ResponseOfLength(responseSize));
+  return outcome == MetricsRecorder::eOutcome::OK;
 }
 
-auto ModBus::ReadHoldingRegisters(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>
+template <typename Validate>
+auto ModBus::Complete(uint8_t function,
+                      std::string const& request,
+                      std::string const& response,
+                      bool error,
+                      std::chrono::steady_clock::time_point start,
+                      Validate&& validate) -> MetricsRecorder::eOutcome
 {
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x03,
-                      static_cast<char>(startRegisterAddress >> 8),
-                      static_cast<char>(startRegisterAddress & 0xFF),
-                      static_cast<char>(count >> 8),
-                      static_cast<char>(count & 0xFF)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+  auto outcome = MetricsRecorder::eOutcome::OK;
+  if (error)
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+    outcome = response.empty() ? MetricsRecorder::eOutcome::TIMEOUT : MetricsRecorder::eOutcome::BAD_FRAME;
   }
-  std::cout << std::endl;
-#endif
+  else if (!validate(response))
+  {
+    _lastExceptionCode = ModBusCodec::ExceptionCode(response, _deviceAddress, function);
+    outcome = (_lastExceptionCode != 0) ? MetricsRecorder::eOutcome::EXCEPTION : MetricsRecorder::eOutcome::BAD_FRAME;
+  }
+  _metrics.Record(function, outcome, request.size(), response.size(), std::chrono::steady_clock::now() - start);
+  LogFrames(request, response, outcome, start);
+  return outcome;
+}
 
+void ModBus::LogFrames(std::string const& request,
+                       std::string const& response,
+                       MetricsRecorder::eOutcome outcome,
+                       std::chrono::steady_clock::time_point start)
+{
+  auto& frameLogger = FrameLogger::Instance();
+  if (!frameLogger.IsEnabled(outcome != MetricsRecorder::eOutcome::OK))
+  {
+    return;
+  }
+  using namespace std::chrono;
+  auto const received = system_clock::now();
+  auto const sent = received - duration_cast<system_clock::duration>(steady_clock::now() - start);
+  frameLogger.Push(_logChannel, FrameLogFormat::eDirection::TX, static_cast<FrameLogFormat::eOutcome>(outcome), sent, request);
+  frameLogger.Push(_logChannel, FrameLogFormat::eDirection::RX, static_cast<FrameLogFormat::eOutcome>(outcome), received, response);
+}
+
+auto ModBus::ReadBits(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>
+{
+  std::vector<bool> requestedBits{};
+  Transact(function,
+           ModBusCodec::ReadRequest(_deviceAddress, function, startRegisterAddress, count),
+           ModBusCodec::ResponseSize(function, count),
+           timeoutMs,
+           [&](std::string const& response) {
+             if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, function, count))
+             {
+               return false;
+             }
+             requestedBits = ModBusCodec::DecodeBits(response, count);
+             return true;
+           });
+  return requestedBits;
+}
+
+auto ModBus::ReadRegisters(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>
+{
   std::vector<uint16_t> requestedRegisters{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    auto const responseLen = response.size();
-    if (responseLen <= 2)
-    {
-        return;
-    }
-    auto const crc16calculated = Crc16(reinterpret_cast<uint8_t const*>(response.data()), responseLen - 2);
-    uint8_t const crc16hi = *std::prev(response.cend(), 2);
-    uint8_t const crc16lo = response.back();
-    auto const crc16response = crc16hi << 8 | crc16lo;
-    if (error ||
-        (responseLen < (3 + 2 + count*2)) ||
-        (response[0] != static_cast<char>(_deviceAddress)) ||
-        (response[1] != 0x03) ||
-        (response[2] != count*2) ||
-        (crc16calculated != crc16response))
-    {
-      return;
-    }
-    requestedRegisters.reserve(count);
-    auto currentRegIt = std::next(response.cbegin(), 3);
-    auto endRegIt = std::prev(response.cend(), 2);
-    while(currentRegIt != endRegIt)
-    {
-      requestedRegisters.emplace_back((*currentRegIt << 8) | *(currentRegIt + 1));
-      currentRegIt += 2;
-    }
-  }, timeoutMs);
+  Transact(function,
+           ModBusCodec::ReadRequest(_deviceAddress, function, startRegisterAddress, count),
+           ModBusCodec::ResponseSize(function, count),
+           timeoutMs,
+           [&](std::string const& response) {
+             if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, function, count))
+             {
+               return false;
+             }
+             requestedRegisters = ModBusCodec::DecodeRegisters(response, count);
+             return true;
+           });
   return requestedRegisters;
 }
 
-bool ModBus::ForceSingleCoil(uint16_t registerAddress, bool isOn, uint16_t timeoutMs)
+bool ModBus::WriteEchoed(std::string const& request, uint16_t timeoutMs)
 {
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x05,
-                      static_cast<char>(registerAddress >> 8),
-                      static_cast<char>(registerAddress & 0xFF),
-                      static_cast<char>(isOn ? 0xFF : 0x00),
-                      static_cast<char>(0x00)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+  _lastExceptionCode = 0;
+  if (_deviceAddress == BROADCAST_ADDRESS)
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+    return SendBroadcast(request);
   }
-  std::cout << std::endl;
-#endif
-  bool result{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    result = !error && (response == request);
-  }, timeoutMs);
-  return result;
+  auto const function = static_cast<uint8_t>(request[1]);
+  return Transact(function, request, ModBusCodec::ResponseSize(function, 0), timeoutMs, [&](std::string const& response) {
+    return response == request;
+  });
+}
+
+auto ModBus::ReadCoilStatus(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>
+{
+  return ReadBits(0x01, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ReadInputStatus(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>
+{
+  return ReadBits(0x02, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ReadHoldingRegisters(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>
+{
+  return ReadRegisters(0x03, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ReadInputRegisters(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>
+{
+  return ReadRegisters(0x04, startRegisterAddress, count, timeoutMs);
+}
+
+bool ModBus::ForceSingleCoil(uint16_t registerAddress, bool isOn, uint16_t timeoutMs)
+{
+  return WriteEchoed(ModBusCodec::ForceSingleCoilRequest(_deviceAddress, registerAddress, isOn), timeoutMs);
 }
 
 bool ModBus::WriteSingleHoldingRegister(uint16_t registerAddress, uint16_t value, uint16_t timeoutMs)
 {
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x06,
-                      static_cast<char>(registerAddress >> 8),
-                      static_cast<char>(registerAddress & 0xFF),
-                      static_cast<char>(value >> 8),
-                      static_cast<char>(value & 0xFF)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
-  {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-  }
-  std::cout << std::endl;
-#endif
-  bool result{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    result = !error && (response == request);
-  }, timeoutMs);
-  return result;
+  return WriteEchoed(ModBusCodec::WriteSingleHoldingRegisterRequest(_deviceAddress, registerAddress, value), timeoutMs);
 }
 
 bool ModBus::WriteMultipleHoldingRegister(uint16_t startRegisterAddress, std::vector<uint16_t> values, uint16_t timeoutMs)
 {
+  _lastExceptionCode = 0;
   if (values.empty())
   {
     return false;
   }
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x10,
-                      static_cast<char>(startRegisterAddress >> 8),
-                      static_cast<char>(startRegisterAddress & 0xFF),
-                      static_cast<char>(values.size() >> 8),
-                      static_cast<char>(values.size() & 0xFF),
-                      static_cast<char>(values.size() * 2)};
-  for (auto const& value : values) {
-    request += static_cast<char>(value >> 8);
-    request += static_cast<char>(value & 0xFF);
+  auto const request = ModBusCodec::WriteMultipleHoldingRegisterRequest(_deviceAddress, startRegisterAddress, values);
+  if (_deviceAddress == BROADCAST_ADDRESS)
+  {
+    return SendBroadcast(request);
   }
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+  return Transact(0x10, request, ModBusCodec::ResponseSize(0x10, 0), timeoutMs, [&](std::string const& response) {
+    return ModBusCodec::IsWriteMultipleResponseValid(response, _deviceAddress, startRegisterAddress, static_cast<uint16_t>(values.size()));
+  });
+}
+
+auto ModBus::ReadWriteMultipleRegisters(uint16_t readStartRegisterAddress,
+                                        uint16_t readCount,
+                                        uint16_t writeStartRegisterAddress,
+                                        std::vector<uint16_t> values,
+                                        uint16_t timeoutMs) -> std::vector<uint16_t>
+{
+  _lastExceptionCode = 0;
+  if (values.empty() || (readCount == 0))
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+    return {};
   }
-  std::cout << std::endl;
-#endif
-  bool result{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
+  std::vector<uint16_t> requestedRegisters{};
+  Transact(0x17,
+           ModBusCodec::ReadWriteMultipleRegistersRequest(_deviceAddress,
+                                                          readStartRegisterAddress,
+                                                          readCount,
+                                                          writeStartRegisterAddress,
+                                                          values),
+           ModBusCodec::ResponseSize(0x17, readCount),
+           timeoutMs,
+           [&](std::string const& response) {
+             if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, 0x17, readCount))
+             {
+               return false;
+             }
+             requestedRegisters = ModBusCodec::DecodeRegisters(response, readCount);
+             return true;
+           });
+  return requestedRegisters;
+}
+
+auto ModBus::PlanBatch(std::vector<ReadRequest> const& requests, LinkCostModel const& linkCostModel) -> std::vector<ReadRequest>
+{
+  // Request (address, function, start, count, crc) and response (address, function, byte count, crc) overhead
+  // plus 3.5 characters of silence after each of them.
+  constexpr uint32_t FRAME_OVERHEAD_BYTES = 8 + 5;
+  constexpr uint32_t FRAME_SILENCE_HALF_BYTES = 7 + 7;
+  auto const byteTimeNs = 1000000000ull * linkCostModel.bitsPerCharacter / std::max<uint32_t>(linkCostModel.baudrate, 1);
+  auto const frameCostNs = byteTimeNs * FRAME_OVERHEAD_BYTES + byteTimeNs * FRAME_SILENCE_HALF_BYTES / 2 +
+                           1000ull * linkCostModel.turnaroundUs;
+
+  auto const splitsOf = [&linkCostModel](uint8_t function) {
+    auto const it = linkCostModel.readSplits.find(function);
+    return (it != linkCostModel.readSplits.cend()) ? &it->second : nullptr;
+  };
+  auto const maxCountOf = [&linkCostModel](uint8_t function) -> uint32_t {
+    auto const isBits = (function == 0x01) || (function == 0x02);
+    return isBits ? linkCostModel.maxBitsPerFrame : linkCostModel.maxRegistersPerFrame;
+  };
+  // End of the frame which starts at the address: the first split after it or the frame size limit
+  auto const frameEndOf = [&](uint8_t function, uint32_t address, uint32_t end) {
+    end = std::min(end, address + std::max<uint32_t>(maxCountOf(function), 1));
+    if (auto const splits = splitsOf(function))
     {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+      for (auto const split : *splits)
+      {
+        if ((split > address) && (split < end))
+        {
+          end = split;
+        }
+      }
     }
-    std::cout << std::endl;
-#endif
-    if (error ||
-        (response.size() != 8) ||
-        (response[0] != static_cast<char>(_deviceAddress)) ||
-        (response[1] != 0x10) ||
-        (((response[2] << 8) | (response[3] & 0xFF)) != startRegisterAddress) ||
-        (((response[4] << 8) | (response[5] & 0xFF)) != values.size()) ||
-        (Crc16(reinterpret_cast<uint8_t const*>(response.data()), response.size() - 2) != ((((uint8_t)*std::prev(response.cend(), 2)) << 8) | ((uint8_t)response.back()))))
+    return end;
+  };
+
+  std::vector<ReadRequest> sorted;
+  sorted.reserve(requests.size());
+  for (auto const& request : requests)
+  {
+    auto const requestEnd = static_cast<uint32_t>(request.startRegisterAddress) + request.count;
+    for (uint32_t address = request.startRegisterAddress; address < requestEnd;)
     {
-      return;
+      auto const end = frameEndOf(request.function, address, requestEnd);
+      sorted.push_back(ReadRequest{request.function, static_cast<uint16_t>(address), static_cast<uint16_t>(end - address)});
+      address = end;
     }
-    result = true;
-  }, timeoutMs);
-  return result;
+  }
+  std::sort(sorted.begin(), sorted.end(), [](auto const& lhs, auto const& rhs) {
+    return (lhs.function != rhs.function) ? (lhs.function < rhs.function)
+                                          : (lhs.startRegisterAddress < rhs.startRegisterAddress);
+  });
+
+  std::vector<ReadRequest> frames;
+  for (auto const& request : sorted)
+  {
+    auto const isBits = (request.function == 0x01) || (request.function == 0x02);
+    auto const requestEnd = static_cast<uint32_t>(request.startRegisterAddress) + request.count;
+    if (!frames.empty() && (frames.back().function == request.function))
+    {
+      auto& frame = frames.back();
+      auto const frameEnd = static_cast<uint32_t>(frame.startRegisterAddress) + frame.count;
+      auto const mergedEnd = std::max(frameEnd, requestEnd);
+      auto const mergedCount = mergedEnd - frame.startRegisterAddress;
+      auto const extraBytes = isBits
+                              ? (static_cast<int64_t>(mergedCount + 7) / 8 - (frame.count + 7) / 8 - (request.count + 7) / 8)
+                              : 2 * (static_cast<int64_t>(request.startRegisterAddress) - frameEnd);
+      auto const gapCostNs = static_cast<int64_t>(byteTimeNs) * std::max<int64_t>(extraBytes, 0);
+      auto const isWithinFrame = frameEndOf(frame.function, frame.startRegisterAddress, mergedEnd) == mergedEnd;
+      if (isWithinFrame && (gapCostNs < static_cast<int64_t>(frameCostNs)))
+      {
+        frame.count = static_cast<uint16_t>(mergedCount);
+        continue;
+      }
+    }
+    frames.emplace_back(request);
+  }
+  return frames;
 }
 
-auto ModBus::ReadInputRegisters(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>
+auto ModBus::ReadBatch(std::vector<ReadRequest> const& requests, uint16_t timeoutMs) -> std::vector<std::vector<uint16_t>>
 {
-  std::string request{static_cast<char>(_deviceAddress),
-                      0x04,
-                      static_cast<char>(startRegisterAddress >> 8),
-                      static_cast<char>(startRegisterAddress & 0xFF),
-                      static_cast<char>(count >> 8),
-                      static_cast<char>(count & 0xFF)};
-  auto crc16 = Crc16(reinterpret_cast<uint8_t const*>(request.data()), request.size());
-  request += static_cast<char>(crc16 >> 8);
-  request += static_cast<char>(crc16 & 0xFF);
-#if DEBUG_INFO
-  for (auto byte : request)
+  _lastExceptionCode = 0;
+  auto const frames = BatchFrames(requests);
+  std::vector<std::string> frameRequests;
+  std::vector<Transport::tResponseComplete> frameCompletes;
+  frameRequests.reserve(frames.size());
+  frameCompletes.reserve(frames.size());
+  for (auto const& frame : frames)
   {
-    std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
+    frameRequests.emplace_back(ModBusCodec::ReadRequest(_deviceAddress, frame.function, frame.startRegisterAddress, frame.count));
+    frameCompletes.emplace_back(ResponseOfLength(ModBusCodec::ResponseSize(frame.function, frame.count)));
   }
-  std::cout << std::endl;
-#endif
 
-  std::vector<uint16_t> requestedRegisters{};
-  _serialPort.SendCommand(request, [&](std::string const& response, bool error) {
-#if DEBUG_INFO
-    for (auto byte : response)
-    {
-      std::cout << std::hex << " 0x" << static_cast<uint32_t>(byte);
-    }
-    std::cout << std::endl;
-#endif
-    if (error ||
-        (response.size() < (3 + 2 + count*2)) ||
-        (response[0] != static_cast<char>(_deviceAddress)) ||
-        (response[1] != 0x04) ||
-        (response[2] != count*2) ||
-        (Crc16(reinterpret_cast<uint8_t const*>(response.data()), response.size() - 2) != ((((uint8_t)*std::prev(response.cend(), 2)) << 8) | ((uint8_t)response.back()))))
+  std::vector<std::vector<uint16_t>> frameValues(frames.size());
+  _transport.SendCommands(frameRequests, [&](size_t index, std::string const& response, bool error,
+                                              std::chrono::steady_clock::time_point started) {
+    auto const& frame = frames[index];
+    Complete(frame.function, frameRequests[index], response, error, started, [&](std::string const& validResponse) {
+      return DecodeFrame(frame, validResponse, frameValues[index]);
+    });
+  }, timeoutMs, frameCompletes);
+  return ScatterBatch(requests, frames, frameValues);
+}
+
+auto ModBus::BatchFrames(std::vector<ReadRequest> const& requests) const -> std::vector<ReadRequest>
+{
+  auto frames = PlanBatch(requests, _linkCostModel);
+  frames.erase(std::remove_if(frames.begin(), frames.end(), [](auto const& frame) {
+    return (frame.function < 0x01) || (frame.function > 0x04);
+  }), frames.end());
+  return frames;
+}
+
+bool ModBus::DecodeFrame(ReadRequest const& frame, std::string const& response, std::vector<uint16_t>& values) const
+{
+  if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, frame.function, frame.count))
+  {
+    return false;
+  }
+  auto const isBits = (frame.function == 0x01) || (frame.function == 0x02);
+  if (isBits)
+  {
+    auto const bits = ModBusCodec::DecodeBits(response, frame.count);
+    values.assign(bits.cbegin(), bits.cend());
+  }
+  else
+  {
+    values = ModBusCodec::DecodeRegisters(response, frame.count);
+  }
+  return true;
+}
+
+auto ModBus::ScatterBatch(std::vector<ReadRequest> const& requests,
+                          std::vector<ReadRequest> const& frames,
+                          std::vector<std::vector<uint16_t>> const& frameValues) -> std::vector<std::vector<uint16_t>>
+{
+  std::vector<std::vector<uint16_t>> results(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i)
+  {
+    auto const& request = requests[i];
+    auto const requestEnd = static_cast<uint32_t>(request.startRegisterAddress) + request.count;
+    // A request split at read splits is put together from several frames, it fails if any of them failed
+    std::vector<uint16_t> values(request.count);
+    std::vector<bool> isRead(request.count);
+    for (size_t frameIndex = 0; frameIndex < frames.size(); ++frameIndex)
     {
-      return;
+      auto const& frame = frames[frameIndex];
+      auto const frameEnd = static_cast<uint32_t>(frame.startRegisterAddress) + frame.count;
+      if ((frame.function != request.function) || (frameValues[frameIndex].size() != frame.count))
+      {
+        continue;
+      }
+      auto const first = std::max<uint32_t>(frame.startRegisterAddress, request.startRegisterAddress);
+      auto const last = std::min(frameEnd, requestEnd);
+      for (auto address = first; address < last; ++address)
+      {
+        values[address - request.startRegisterAddress] = frameValues[frameIndex][address - frame.startRegisterAddress];
+        isRead[address - request.startRegisterAddress] = true;
+      }
     }
-    requestedRegisters.reserve(count);
-    auto currentRegIt = std::next(response.cbegin(), 3);
-    auto endRegIt = std::prev(response.cend(), 2);
-    while(currentRegIt != endRegIt)
+    if ((request.count != 0) && std::all_of(isRead.cbegin(), isRead.cend(), [](bool read) { return read; }))
     {
-      requestedRegisters.emplace_back((*currentRegIt << 8) | *(currentRegIt + 1));
-      currentRegIt += 2;
+      results[i] = std::move(values);
     }
-  }, timeoutMs);
-  return requestedRegisters;
+  }
+  return results;
+}
+
+#if defined(OWEN_COROUTINES)
+template <typename Validate>
+auto ModBus::TransactAsync(uint8_t function, std::string request, size_t responseSize, uint16_t timeoutMs, Validate validate) -> OWEN::Task<bool>
+{
+  _lastExceptionCode = 0;
+  auto const start = std::chrono::steady_clock::now();
+  auto const [response, error] = co_await Exchange{_transport, request, timeoutMs, ResponseOfLength(responseSize)};
+  co_return Complete(function, request, response, error, start, validate) == MetricsRecorder::eOutcome::OK;
+}
+
+auto ModBus::ReadBitsAsync(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<bool>>
+{
+  std::vector<bool> requestedBits{};
+  co_await TransactAsync(function,
+                         ModBusCodec::ReadRequest(_deviceAddress, function, startRegisterAddress, count),
+                         ModBusCodec::ResponseSize(function, count),
+                         timeoutMs,
+                         [&](std::string const& response) {
+                           if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, function, count))
+                           {
+                             return false;
+                           }
+                           requestedBits = ModBusCodec::DecodeBits(response, count);
+                           return true;
+                         });
+  co_return requestedBits;
+}
+
+auto ModBus::ReadRegistersAsync(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<uint16_t>>
+{
+  std::vector<uint16_t> requestedRegisters{};
+  co_await TransactAsync(function,
+                         ModBusCodec::ReadRequest(_deviceAddress, function, startRegisterAddress, count),
+                         ModBusCodec::ResponseSize(function, count),
+                         timeoutMs,
+                         [&](std::string const& response) {
+                           if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, function, count))
+                           {
+                             return false;
+                           }
+                           requestedRegisters = ModBusCodec::DecodeRegisters(response, count);
+                           return true;
+                         });
+  co_return requestedRegisters;
+}
+
+auto ModBus::WriteEchoedAsync(std::string request, uint16_t timeoutMs) -> OWEN::Task<bool>
+{
+  _lastExceptionCode = 0;
+  if (_deviceAddress == BROADCAST_ADDRESS)
+  {
+    co_return false;
+  }
+  auto const function = static_cast<uint8_t>(request[1]);
+  co_return co_await TransactAsync(function, request, ModBusCodec::ResponseSize(function, 0), timeoutMs, [&](std::string const& response) {
+    return response == request;
+  });
 }
 
+auto ModBus::ReadCoilStatusAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<bool>>
+{
+  return ReadBitsAsync(0x01, startRegisterAddress, count, timeoutMs);
+}
 
+auto ModBus::ReadInputStatusAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<bool>>
+{
+  return ReadBitsAsync(0x02, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ReadHoldingRegistersAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<uint16_t>>
+{
+  return ReadRegistersAsync(0x03, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ReadInputRegistersAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<uint16_t>>
+{
+  return ReadRegistersAsync(0x04, startRegisterAddress, count, timeoutMs);
+}
+
+auto ModBus::ForceSingleCoilAsync(uint16_t registerAddress, bool isOn, uint16_t timeoutMs) -> OWEN::Task<bool>
+{
+  return WriteEchoedAsync(ModBusCodec::ForceSingleCoilRequest(_deviceAddress, registerAddress, isOn), timeoutMs);
+}
+
+auto ModBus::WriteSingleHoldingRegisterAsync(uint16_t registerAddress, uint16_t value, uint16_t timeoutMs) -> OWEN::Task<bool>
+{
+  return WriteEchoedAsync(ModBusCodec::WriteSingleHoldingRegisterRequest(_deviceAddress, registerAddress, value), timeoutMs);
+}
+
+auto ModBus::WriteMultipleHoldingRegisterAsync(uint16_t startRegisterAddress,
+                                               std::vector<uint16_t> values,
+                                               uint16_t timeoutMs) -> OWEN::Task<bool>
+{
+  _lastExceptionCode = 0;
+  if (values.empty() || (_deviceAddress == BROADCAST_ADDRESS))
+  {
+    co_return false;
+  }
+  auto const request = ModBusCodec::WriteMultipleHoldingRegisterRequest(_deviceAddress, startRegisterAddress, values);
+  co_return co_await TransactAsync(0x10, request, ModBusCodec::ResponseSize(0x10, 0), timeoutMs, [&](std::string const& response) {
+    return ModBusCodec::IsWriteMultipleResponseValid(response, _deviceAddress, startRegisterAddress, static_cast<uint16_t>(values.size()));
+  });
+}
+
+auto ModBus::ReadWriteMultipleRegistersAsync(uint16_t readStartRegisterAddress,
+                                             uint16_t readCount,
+                                             uint16_t writeStartRegisterAddress,
+                                             std::vector<uint16_t> values,
+                                             uint16_t timeoutMs) -> OWEN::Task<std::vector<uint16_t>>
+{
+  _lastExceptionCode = 0;
+  if (values.empty() || (readCount == 0) || (_deviceAddress == BROADCAST_ADDRESS))
+  {
+    co_return std::vector<uint16_t>{};
+  }
+  std::vector<uint16_t> requestedRegisters{};
+  co_await TransactAsync(0x17,
+                         ModBusCodec::ReadWriteMultipleRegistersRequest(_deviceAddress,
+                                                                        readStartRegisterAddress,
+                                                                        readCount,
+                                                                        writeStartRegisterAddress,
+                                                                        values),
+                         ModBusCodec::ResponseSize(0x17, readCount),
+                         timeoutMs,
+                         [&](std::string const& response) {
+                           if (!ModBusCodec::IsReadResponseValid(response, _deviceAddress, 0x17, readCount))
+                           {
+                             return false;
+                           }
+                           requestedRegisters = ModBusCodec::DecodeRegisters(response, readCount);
+                           return true;
+                         });
+  co_return requestedRegisters;
+}
+
+auto ModBus::ReadBatchAsync(std::vector<ReadRequest> requests, uint16_t timeoutMs) -> OWEN::Task<std::vector<std::vector<uint16_t>>>
+{
+  _lastExceptionCode = 0;
+  if (_deviceAddress == BROADCAST_ADDRESS)
+  {
+    co_return std::vector<std::vector<uint16_t>>(requests.size());
+  }
+  auto const frames = BatchFrames(requests);
+  std::vector<std::vector<uint16_t>> frameValues(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i)
+  {
+    auto const& frame = frames[i];
+    co_await TransactAsync(frame.function,
+                           ModBusCodec::ReadRequest(_deviceAddress, frame.function, frame.startRegisterAddress, frame.count),
+                           ModBusCodec::ResponseSize(frame.function, frame.count),
+                           timeoutMs,
+                           [&](std::string const& response) { return DecodeFrame(frame, response, frameValues[i]); });
+  }
+  co_return ScatterBatch(requests, frames, frameValues);
+}
+#endif
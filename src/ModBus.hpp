@@ -1,15 +1,52 @@
 #pragma once
 
+#include "MetricsRecorder.hpp"
+
+#if defined(OWEN_COROUTINES)
+#include <OWEN/Task.hpp>
+#endif
+
 #include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 
-class SerialPort;
+class Transport;
 
 class ModBus
 {
 public:
-  ModBus(SerialPort& serialPort, uint8_t deviceAddress = 0x10);
+  static constexpr uint8_t BROADCAST_ADDRESS = 0x00;
+
+  /**
+   * Read request for batch: function 0x01, 0x02, 0x03 or 0x04 with its register (or bit) range.
+   */
+  struct ReadRequest
+  {
+    uint8_t function{};
+    uint16_t startRegisterAddress{};
+    uint16_t count{};
+  };
+
+  /**
+   * Link parameters used by the batch planner to decide whether reading a gap is cheaper than a new frame,
+   * and limits of the frames the device answers.
+   */
+  struct LinkCostModel
+  {
+    uint32_t baudrate{9600};
+    uint8_t bitsPerCharacter{10};     ///< start + data + parity + stop bits
+    uint32_t turnaroundUs{1000};      ///< device answer delay and processing time between request and response
+    uint16_t maxRegistersPerFrame{125};
+    uint16_t maxBitsPerFrame{2000};
+    std::map<uint8_t, std::vector<uint16_t>> readSplits;   ///< per function: addresses no frame crosses
+  };
+
+  /**
+   * @param deviceAddress BROADCAST_ADDRESS makes functions 0x05, 0x06 and 0x10 broadcast:
+   *                      no reply is expected, after sending the bus is kept silent for broadcast turnaround delay.
+   */
+  ModBus(Transport& transport, uint8_t deviceAddress = 0x10);
 
   auto Function_0x01(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs = 1000) -> std::vector<bool>
   {
@@ -59,7 +96,182 @@ public:
   }
 
   bool WriteMultipleHoldingRegister(uint16_t startRegisterAddress, std::vector<uint16_t> values, uint16_t timeoutMs = 1000);
+
+  auto Function_0x17(uint16_t readStartRegisterAddress,
+                     uint16_t readCount,
+                     uint16_t writeStartRegisterAddress,
+                     std::vector<uint16_t> values,
+                     uint16_t timeoutMs = 1000) -> std::vector<uint16_t>
+  {
+    return ReadWriteMultipleRegisters(readStartRegisterAddress, readCount, writeStartRegisterAddress, values, timeoutMs);
+  }
+
+  /**
+   * Write values and read registers back in one transaction. Write is performed by the device before read.
+   * @return read registers or empty vector on any failure, see LastExceptionCode() for device rejections.
+   */
+  auto ReadWriteMultipleRegisters(uint16_t readStartRegisterAddress,
+                                  uint16_t readCount,
+                                  uint16_t writeStartRegisterAddress,
+                                  std::vector<uint16_t> values,
+                                  uint16_t timeoutMs = 1000) -> std::vector<uint16_t>;
+
+  /**
+   * Exception code from the last exception response (0x01 - illegal function, 0x02 - illegal data address, ...).
+   * @return 0 if the last transaction did not get an exception response.
+   */
+  auto LastExceptionCode() const -> uint8_t
+  {
+    return _lastExceptionCode;
+  }
+
+  /**
+   * Set delay after broadcast request during which slaves process it and no other request is sent.
+   * @param delayMs turnaround delay in milliseconds.
+   */
+  void BroadcastTurnaround(uint16_t delayMs)
+  {
+    _broadcastTurnaroundMs = delayMs;
+  }
+
+  /**
+   * Set link parameters for batch planner.
+   */
+  void LinkCost(LinkCostModel const& linkCostModel)
+  {
+    _linkCostModel = linkCostModel;
+  }
+
+  /**
+   * Merge requests of the same function into the minimal set of frames.
+   * Ranges are merged when reading the gap between them costs less wire time than a separate transaction.
+   * Requests are split into several frames at the read splits and the frame size limit.
+   * @return frames to be sent, sorted by function and address.
+   */
+  static auto PlanBatch(std::vector<ReadRequest> const& requests, LinkCostModel const& linkCostModel) -> std::vector<ReadRequest>;
+
+  /**
+   * Read all requests with the minimal set of transactions (see PlanBatch).
+   * Transports which support several outstanding transactions get all frames at once.
+   * @return results in order of requests, bits are returned as 0/1 values. Empty vector for failed request.
+   */
+  auto ReadBatch(std::vector<ReadRequest> const& requests, uint16_t timeoutMs = 1000) -> std::vector<std::vector<uint16_t>>;
+
+#if defined(OWEN_COROUTINES)
+  /**
+   * Awaitable versions of the functions above, exchanges go through Transport::AsyncSendCommand(). Frames of a batch
+   * are sent one by one. Not for BROADCAST_ADDRESS (false or empty result), a task of one ModBus at a time.
+   */
+  auto ReadCoilStatusAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<bool>>;
+
+  auto ReadInputStatusAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<bool>>;
+
+  auto ReadHoldingRegistersAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<uint16_t>>;
+
+  auto ReadInputRegistersAsync(uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<uint16_t>>;
+
+  auto ForceSingleCoilAsync(uint16_t registerAddress, bool isOn, uint16_t timeoutMs = 1000) -> OWEN::Task<bool>;
+
+  auto WriteSingleHoldingRegisterAsync(uint16_t registerAddress, uint16_t value, uint16_t timeoutMs = 1000) -> OWEN::Task<bool>;
+
+  auto WriteMultipleHoldingRegisterAsync(uint16_t startRegisterAddress,
+                                         std::vector<uint16_t> values,
+                                         uint16_t timeoutMs = 1000) -> OWEN::Task<bool>;
+
+  auto ReadWriteMultipleRegistersAsync(uint16_t readStartRegisterAddress,
+                                       uint16_t readCount,
+                                       uint16_t writeStartRegisterAddress,
+                                       std::vector<uint16_t> values,
+                                       uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<uint16_t>>;
+
+  auto ReadBatchAsync(std::vector<ReadRequest> requests, uint16_t timeoutMs = 1000) -> OWEN::Task<std::vector<std::vector<uint16_t>>>;
+#endif
+
+  /**
+   * Snapshot of transaction counters and latency histograms of this device, safe to call from any thread.
+   */
+  auto Metrics() const -> OWEN::DeviceMetrics;
+
+  /**
+   * Same as above, storage of deviceMetrics is reused.
+   */
+  void Metrics(OWEN::DeviceMetrics& deviceMetrics) const;
+
+private:
+  bool SendBroadcast(std::string const& request);
+
+  /**
+   * Send request and wait for response of responseSize (or exception response), record outcome to metrics.
+   * @param validate checks and decodes response, returns false if it is not a valid reply to the request.
+   * @return true if valid response was received.
+   */
+  template <typename Validate>
+  bool Transact(uint8_t function, std::string const& request, size_t responseSize, uint16_t timeoutMs, Validate&& validate);
+
+  /**
+   * Classify received response, update LastExceptionCode(), metrics and frame log.
+   * @param start time when request was sent.
+   */
+  template <typename Validate>
+  auto Complete(uint8_t function,
+                std::string const& request,
+                std::string const& response,
+                bool error,
+                std::chrono::steady_clock::time_point start,
+                Validate&& validate) -> MetricsRecorder::eOutcome;
+
+  /**
+   * Put request and response to the frame log if its level requires.
+   * @param start time when request was sent.
+   */
+  void LogFrames(std::string const& request,
+                 std::string const& response,
+                 MetricsRecorder::eOutcome outcome,
+                 std::chrono::steady_clock::time_point start);
+
+  auto ReadBits(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<bool>;
+
+  auto ReadRegisters(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> std::vector<uint16_t>;
+
+  /**
+   * Send write request which is echoed by the device (functions 0x05 and 0x06).
+   */
+  bool WriteEchoed(std::string const& request, uint16_t timeoutMs);
+
+  /**
+   * Frames of the batch, see PlanBatch (only read functions).
+   */
+  auto BatchFrames(std::vector<ReadRequest> const& requests) const -> std::vector<ReadRequest>;
+
+  /**
+   * Check and decode response to a frame of the batch, bits are decoded as 0/1 values.
+   */
+  bool DecodeFrame(ReadRequest const& frame, std::string const& response, std::vector<uint16_t>& values) const;
+
+  /**
+   * Results of the batch requests from values of its frames.
+   */
+  static auto ScatterBatch(std::vector<ReadRequest> const& requests,
+                           std::vector<ReadRequest> const& frames,
+                           std::vector<std::vector<uint16_t>> const& frameValues) -> std::vector<std::vector<uint16_t>>;
+
+#if defined(OWEN_COROUTINES)
+  template <typename Validate>
+  auto TransactAsync(uint8_t function, std::string request, size_t responseSize, uint16_t timeoutMs, Validate validate) -> OWEN::Task<bool>;
+
+  auto ReadBitsAsync(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<bool>>;
+
+  auto ReadRegistersAsync(uint8_t function, uint16_t startRegisterAddress, uint16_t count, uint16_t timeoutMs) -> OWEN::Task<std::vector<uint16_t>>;
+
+  auto WriteEchoedAsync(std::string request, uint16_t timeoutMs) -> OWEN::Task<bool>;
+#endif
+
 private:
-  SerialPort& _serialPort;
+  Transport& _transport;
   uint8_t _deviceAddress{};
+  uint8_t _lastExceptionCode{};
+  uint16_t _broadcastTurnaroundMs{100};
+  LinkCostModel _linkCostModel{};
+  MetricsRecorder _metrics;
+  uint16_t _logChannel{};
 };
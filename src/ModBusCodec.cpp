@@ -0,0 +1,201 @@
+#include "ModBusCodec.hpp"
+
+#include "crc16.hpp"
+
+namespace ModBusCodec {
+
+namespace {
+
+constexpr size_t CRC_SIZE = 2;
+
+void Append16(std::string& frame, uint16_t value)
+{
+  frame += static_cast<char>(value >> 8);
+  frame += static_cast<char>(value & 0xFF);
+}
+
+void AppendCrc(std::string& frame)
+{
+  Append16(frame, Crc16(reinterpret_cast<uint8_t const*>(frame.data()), frame.size()));
+}
+
+auto Get16(std::string const& frame, size_t offset) -> uint16_t
+{
+  return static_cast<uint16_t>((static_cast<uint8_t>(frame[offset]) << 8) | static_cast<uint8_t>(frame[offset + 1]));
+}
+
+auto RequestHeader(uint8_t deviceAddress, uint8_t function, size_t frameSize) -> std::string
+{
+  std::string request;
+  request.reserve(frameSize);
+  request += static_cast<char>(deviceAddress);
+  request += static_cast<char>(function);
+  return request;
+}
+
+} /// end namespace anonymous
+
+auto ReadRequest(uint8_t deviceAddress, uint8_t function, uint16_t startRegisterAddress, uint16_t count) -> std::string
+{
+  auto request = RequestHeader(deviceAddress, function, 8);
+  Append16(request, startRegisterAddress);
+  Append16(request, count);
+  AppendCrc(request);
+  return request;
+}
+
+auto ForceSingleCoilRequest(uint8_t deviceAddress, uint16_t registerAddress, bool isOn) -> std::string
+{
+  auto request = RequestHeader(deviceAddress, 0x05, 8);
+  Append16(request, registerAddress);
+  Append16(request, isOn ? 0xFF00 : 0x0000);
+  AppendCrc(request);
+  return request;
+}
+
+auto WriteSingleHoldingRegisterRequest(uint8_t deviceAddress, uint16_t registerAddress, uint16_t value) -> std::string
+{
+  auto request = RequestHeader(deviceAddress, 0x06, 8);
+  Append16(request, registerAddress);
+  Append16(request, value);
+  AppendCrc(request);
+  return request;
+}
+
+auto WriteMultipleHoldingRegisterRequest(uint8_t deviceAddress,
+                                         uint16_t startRegisterAddress,
+                                         std::vector<uint16_t> const& values) -> std::string
+{
+  auto request = RequestHeader(deviceAddress, 0x10, 9 + values.size() * 2);
+  Append16(request, startRegisterAddress);
+  Append16(request, static_cast<uint16_t>(values.size()));
+  request += static_cast<char>(values.size() * 2);
+  for (auto const& value : values)
+  {
+    Append16(request, value);
+  }
+  AppendCrc(request);
+  return request;
+}
+
+auto ReadWriteMultipleRegistersRequest(uint8_t deviceAddress,
+                                       uint16_t readStartRegisterAddress,
+                                       uint16_t readCount,
+                                       uint16_t writeStartRegisterAddress,
+                                       std::vector<uint16_t> const& values) -> std::string
+{
+  auto request = RequestHeader(deviceAddress, 0x17, 13 + values.size() * 2);
+  Append16(request, readStartRegisterAddress);
+  Append16(request, readCount);
+  Append16(request, writeStartRegisterAddress);
+  Append16(request, static_cast<uint16_t>(values.size()));
+  request += static_cast<char>(values.size() * 2);
+  for (auto const& value : values)
+  {
+    Append16(request, value);
+  }
+  AppendCrc(request);
+  return request;
+}
+
+auto ResponseSize(uint8_t function, uint16_t count) -> size_t
+{
+  switch (function)
+  {
+    case 0x01:
+    case 0x02:
+      return 3 + (count + 7) / 8 + CRC_SIZE;
+    case 0x03:
+    case 0x04:
+    case 0x17:
+      return 3 + count * 2 + CRC_SIZE;
+    default:
+      return 6 + CRC_SIZE;
+  }
+}
+
+auto ResponseSizeOf(std::string const& request) -> size_t
+{
+  if (request.size() < 6)
+  {
+    return 0;
+  }
+  return ResponseSize(static_cast<uint8_t>(request[1]), Get16(request, 4));
+}
+
+bool IsResponseComplete(std::string const& response, size_t responseSize)
+{
+  return (response.size() >= responseSize) ||
+         ((response.size() >= (3 + CRC_SIZE)) && ((static_cast<uint8_t>(response[1]) & EXCEPTION_FLAG) != 0));
+}
+
+bool IsCrcValid(std::string const& frame)
+{
+  if (frame.size() <= CRC_SIZE)
+  {
+    return false;
+  }
+  return Crc16(reinterpret_cast<uint8_t const*>(frame.data()), frame.size() - CRC_SIZE) == Get16(frame, frame.size() - CRC_SIZE);
+}
+
+auto ExceptionCode(std::string const& response, uint8_t deviceAddress, uint8_t function) -> uint8_t
+{
+  if ((response.size() != (3 + CRC_SIZE)) ||
+      (static_cast<uint8_t>(response[0]) != deviceAddress) ||
+      (static_cast<uint8_t>(response[1]) != (function | EXCEPTION_FLAG)) ||
+      !IsCrcValid(response))
+  {
+    return 0;
+  }
+  return static_cast<uint8_t>(response[2]);
+}
+
+bool IsReadResponseValid(std::string const& response, uint8_t deviceAddress, uint8_t function, uint16_t count)
+{
+  auto const size = ResponseSize(function, count);
+  return (response.size() == size) &&
+         (static_cast<uint8_t>(response[0]) == deviceAddress) &&
+         (static_cast<uint8_t>(response[1]) == function) &&
+         (static_cast<uint8_t>(response[2]) == (size - 3 - CRC_SIZE)) &&
+         IsCrcValid(response);
+}
+
+bool IsWriteMultipleResponseValid(std::string const& response,
+                                  uint8_t deviceAddress,
+                                  uint16_t startRegisterAddress,
+                                  uint16_t count)
+{
+  return (response.size() == ResponseSize(0x10, count)) &&
+         (static_cast<uint8_t>(response[0]) == deviceAddress) &&
+         (static_cast<uint8_t>(response[1]) == 0x10) &&
+         (Get16(response, 2) == startRegisterAddress) &&
+         (Get16(response, 4) == count) &&
+         IsCrcValid(response);
+}
+
+auto Word(std::string const& frame, size_t offset) -> uint16_t
+{
+  return Get16(frame, offset);
+}
+
+auto DecodeBits(std::string const& response, uint16_t count) -> std::vector<bool>
+{
+  std::vector<bool> bits(count);
+  for (uint16_t bit = 0; bit < count; ++bit)
+  {
+    bits[bit] = (static_cast<uint8_t>(response[3 + bit / 8]) & (1 << (bit % 8))) != 0;
+  }
+  return bits;
+}
+
+auto DecodeRegisters(std::string const& response, uint16_t count) -> std::vector<uint16_t>
+{
+  std::vector<uint16_t> registers(count);
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    registers[i] = Get16(response, 3 + i * 2);
+  }
+  return registers;
+}
+
+} /// end namespace ModBusCodec
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Building of ModBus RTU request frames and validation/decoding of response frames, no I/O.
+ */
+namespace ModBusCodec {
+
+constexpr uint8_t EXCEPTION_FLAG = 0x80;
+
+auto ReadRequest(uint8_t deviceAddress, uint8_t function, uint16_t startRegisterAddress, uint16_t count) -> std::string;
+
+auto ForceSingleCoilRequest(uint8_t deviceAddress, uint16_t registerAddress, bool isOn) -> std::string;
+
+auto WriteSingleHoldingRegisterRequest(uint8_t deviceAddress, uint16_t registerAddress, uint16_t value) -> std::string;
+
+auto WriteMultipleHoldingRegisterRequest(uint8_t deviceAddress,
+                                         uint16_t startRegisterAddress,
+                                         std::vector<uint16_t> const& values) -> std::string;
+
+auto ReadWriteMultipleRegistersRequest(uint8_t deviceAddress,
+                                       uint16_t readStartRegisterAddress,
+                                       uint16_t readCount,
+                                       uint16_t writeStartRegisterAddress,
+                                       std::vector<uint16_t> const& values) -> std::string;
+
+/**
+ * Size of a normal (not exception) response.
+ * @param count count of bits or registers for read functions, ignored for write functions.
+ */
+auto ResponseSize(uint8_t function, uint16_t count) -> size_t;
+
+/**
+ * Size of a normal response to the request frame, taken from its function and count.
+ */
+auto ResponseSizeOf(std::string const& request) -> size_t;
+
+/**
+ * Response is complete when it has the expected size or it is an exception response.
+ */
+bool IsResponseComplete(std::string const& response, size_t responseSize);
+
+bool IsCrcValid(std::string const& frame);
+
+/**
+ * @return exception code if response is a valid exception response to the function, 0 otherwise.
+ */
+auto ExceptionCode(std::string const& response, uint8_t deviceAddress, uint8_t function) -> uint8_t;
+
+/**
+ * Validate response to read function 0x01, 0x02, 0x03, 0x04 or 0x17: size, address, function, byte count and crc.
+ */
+bool IsReadResponseValid(std::string const& response, uint8_t deviceAddress, uint8_t function, uint16_t count);
+
+/**
+ * Validate response to function 0x10: size, address, function, echoed address and count, crc.
+ */
+bool IsWriteMultipleResponseValid(std::string const& response,
+                                  uint8_t deviceAddress,
+                                  uint16_t startRegisterAddress,
+                                  uint16_t count);
+
+/**
+ * Big-endian 16-bit field of the frame at offset (address, count or register value).
+ */
+auto Word(std::string const& frame, size_t offset) -> uint16_t;
+
+/**
+ * Decode bits of validated response to function 0x01 or 0x02.
+ */
+auto DecodeBits(std::string const& response, uint16_t count) -> std::vector<bool>;
+
+/**
+ * Decode registers of validated response to function 0x03, 0x04 or 0x17.
+ */
+auto DecodeRegisters(std::string const& response, uint16_t count) -> std::vector<uint16_t>;
+
+} /// end namespace ModBusCodec
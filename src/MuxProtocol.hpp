@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Protocol between MuxServer and MuxTransport over a Unix domain socket (little endian).
+ * Every message is a header followed by payload:
+ *   uint8 type, uint32 id, uint16 value, uint16 payload length.
+ * Client messages (value is response timeout in ms):
+ *   ATTACH    payload is the port path, all next requests of the connection go to this port;
+ *   TRANSACT  payload is an RTU request frame, the response is awaited;
+ *   SEND      payload is an RTU broadcast frame, no response is awaited.
+ * Server replies with REPLY of the same id, value is eStatus, payload is the received response (possibly partial).
+ * Requests of a connection are served in order, a client can send several before reading replies.
+ */
+namespace MuxProtocol {
+
+enum class eType : uint8_t
+{
+  ATTACH = 1,
+  TRANSACT = 2,
+  SEND = 3,
+  REPLY = 0x80
+};
+
+enum class eStatus : uint16_t
+{
+  OK,
+  NO_RESPONSE,     ///< timeout or incomplete response, payload has received bytes
+  UNKNOWN_PORT,    ///< port is not served or connection is not attached
+  BAD_REQUEST
+};
+
+constexpr size_t HEADER_SIZE = 9;
+constexpr size_t MAX_PAYLOAD_SIZE = 1024;
+
+struct Header
+{
+  eType type{};
+  uint32_t id{};
+  uint16_t value{};
+  uint16_t length{};
+};
+
+inline auto Encode(Header const& header, std::string const& payload) -> std::string
+{
+  std::string message;
+  message.reserve(HEADER_SIZE + payload.size());
+  message += static_cast<char>(header.type);
+  for (auto shift = 0; shift < 32; shift += 8)
+  {
+    message += static_cast<char>((header.id >> shift) & 0xFF);
+  }
+  message += static_cast<char>(header.value & 0xFF);
+  message += static_cast<char>(header.value >> 8);
+  message += static_cast<char>(payload.size() & 0xFF);
+  message += static_cast<char>(payload.size() >> 8);
+  message += payload;
+  return message;
+}
+
+inline auto DecodeHeader(char const* data) -> Header
+{
+  auto const byte = [data](size_t offset) { return static_cast<uint32_t>(static_cast<uint8_t>(data[offset])); };
+  return Header{static_cast<eType>(byte(0)),
+                byte(1) | (byte(2) << 8) | (byte(3) << 16) | (byte(4) << 24),
+                static_cast<uint16_t>(byte(5) | (byte(6) << 8)),
+                static_cast<uint16_t>(byte(7) | (byte(8) << 8))};
+}
+
+} /// end namespace MuxProtocol
@@ -0,0 +1,448 @@
+#include <OWEN/MuxServer.hpp>
+
+#include "ModBusCodec.hpp"
+#include "MuxProtocol.hpp"
+#include "TransportFactory.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h>
+
+namespace OWEN {
+
+namespace {
+
+constexpr size_t MAX_FRAME_SIZE = 256;
+
+bool IsRead(std::string const& request)
+{
+  auto const function = static_cast<uint8_t>(request[1]);
+  return (function >= 0x01) && (function <= 0x04);
+}
+
+} /// end namespace anonymous
+
+class MuxServer::Impl
+{
+public:
+  Impl(std::string const& socketPath, std::vector<ImpulseCounter30::CommunicationOptions> const& ports)
+    : _socketPath{socketPath}
+  {
+    for (auto const& communicationOptions : ports)
+    {
+      _ports.emplace(communicationOptions._portPath, std::make_unique<Port>(*this, CreateTransport(communicationOptions)));
+    }
+    ::unlink(socketPath.c_str());
+    _acceptor.open();
+    _acceptor.bind(boost::asio::local::stream_protocol::endpoint(socketPath));
+    _acceptor.listen();
+    Accept();
+    _thread = std::thread([this] { _io.run(); });
+  }
+
+  ~Impl()
+  {
+    // Sessions refer to the ports, so the io thread is stopped first
+    _io.stop();
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+    _ports.clear();
+    ::unlink(_socketPath.c_str());
+  }
+
+  auto GetCounters() const -> Counters
+  {
+    return Counters{_requests.load(std::memory_order_relaxed),
+                    _transactions.load(std::memory_order_relaxed),
+                    _coalesced.load(std::memory_order_relaxed),
+                    _connections.load(std::memory_order_relaxed)};
+  }
+
+private:
+  class Session;
+
+  struct Waiter
+  {
+    std::shared_ptr<Session> session;
+    uint32_t id{};
+  };
+
+  /**
+   * One bus transaction (or broadcast) and all requests it serves.
+   */
+  struct Flight
+  {
+    MuxProtocol::eType type{};
+    std::string request;
+    uint16_t timeoutMs{};
+    uint64_t sequence{};
+    std::vector<Waiter> waiters;
+  };
+
+  class Port
+  {
+  public:
+    Port(Impl& server, std::unique_ptr<Transport> transport)
+      : _server{server}
+      , _transport{std::move(transport)}
+    {
+      // Ports driven by the shared reactor need no thread, their exchanges are started by completions
+      if (!_transport->IsAsync())
+      {
+        _thread = std::thread{[this] { Run(); }};
+      }
+    }
+
+    ~Port()
+    {
+      {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _running = false;
+        _idle.wait(lock, [this] { return !_busy; });
+      }
+      _wakeUp.notify_one();
+      if (_thread.joinable())
+      {
+        _thread.join();
+      }
+    }
+
+    /**
+     * Queue request or join an identical queued read.
+     * @param after sequence of the previous request of the client, reads queued before it are not joined.
+     * @return sequence of the flight serving the request.
+     */
+    auto Submit(Waiter waiter, MuxProtocol::eType type, uint16_t timeoutMs, std::string const& request, uint64_t after) -> uint64_t
+    {
+      std::unique_lock<std::mutex> lock{_mutex};
+      auto const isRead = (type == MuxProtocol::eType::TRANSACT) && IsRead(request);
+      if (isRead)
+      {
+        auto const it = _reads.find(request);
+        if ((it != _reads.cend()) && (it->second->sequence > after))
+        {
+          it->second->waiters.emplace_back(std::move(waiter));
+          ++_server._coalesced;
+          return it->second->sequence;
+        }
+      }
+      auto const sequence = ++_sequence;
+      auto flight = std::make_shared<Flight>(Flight{type, request, timeoutMs, sequence, {std::move(waiter)}});
+      if (isRead)
+      {
+        _reads[request] = flight;
+      }
+      _queue.emplace_back(std::move(flight));
+      if (_thread.joinable())
+      {
+        lock.unlock();
+        _wakeUp.notify_one();
+      }
+      else if (!_busy)
+      {
+        _busy = true;
+        auto next = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+        Start(std::move(next));
+      }
+      return sequence;
+    }
+
+  private:
+    void Run()
+    {
+      std::unique_lock<std::mutex> lock{_mutex};
+      while (true)
+      {
+        _wakeUp.wait(lock, [this] { return !_running || !_queue.empty(); });
+        if (!_running)
+        {
+          return;
+        }
+        auto flight = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+
+        auto status = MuxProtocol::eStatus::OK;
+        std::string response;
+        if (flight->type == MuxProtocol::eType::SEND)
+        {
+          status = _transport->Send(flight->request) ? MuxProtocol::eStatus::OK : MuxProtocol::eStatus::NO_RESPONSE;
+        }
+        else
+        {
+          auto const responseSize = ModBusCodec::ResponseSizeOf(flight->request);
+          _transport->SendCommand(flight->request, [&](std::string const& data, bool error) {
+            response = data;
+            status = error ? MuxProtocol::eStatus::NO_RESPONSE : MuxProtocol::eStatus::OK;
+          }, flight->timeoutMs, [responseSize](std::string const& data) {
+            return ModBusCodec::IsResponseComplete(data, responseSize);
+          });
+        }
+        ++_server._transactions;
+
+        lock.lock();
+        auto waiters = Land(*flight);
+        lock.unlock();
+        _server.Reply(std::move(waiters), status, response);
+        lock.lock();
+      }
+    }
+
+    /**
+     * Start exchange of an asynchronous transport, called with the port busy.
+     */
+    void Start(std::shared_ptr<Flight> flight)
+    {
+      if (flight->type == MuxProtocol::eType::SEND)
+      {
+        _transport->AsyncSend(flight->request, [this, flight](bool sent) {
+          Complete(flight, sent ? MuxProtocol::eStatus::OK : MuxProtocol::eStatus::NO_RESPONSE, {});
+        });
+        return;
+      }
+      auto const responseSize = ModBusCodec::ResponseSizeOf(flight->request);
+      _transport->AsyncSendCommand(flight->request, [this, flight](std::string const& data, bool error) {
+        Complete(flight, error ? MuxProtocol::eStatus::NO_RESPONSE : MuxProtocol::eStatus::OK, data);
+      }, flight->timeoutMs, [responseSize](std::string const& data) {
+        return ModBusCodec::IsResponseComplete(data, responseSize);
+      });
+    }
+
+    /**
+     * Called by the reactor thread when exchange of an asynchronous transport is done, the next one is started.
+     */
+    void Complete(std::shared_ptr<Flight> const& flight, MuxProtocol::eStatus status, std::string const& response)
+    {
+      // Port can be destroyed as soon as it is not busy
+      auto& server = _server;
+      ++server._transactions;
+      std::unique_lock<std::mutex> lock{_mutex};
+      auto waiters = Land(*flight);
+      std::shared_ptr<Flight> next;
+      if (_running && !_queue.empty())
+      {
+        next = std::move(_queue.front());
+        _queue.pop_front();
+      }
+      else
+      {
+        _busy = false;
+        _idle.notify_all();
+      }
+      lock.unlock();
+      server.Reply(std::move(waiters), status, response);
+      if (next)
+      {
+        Start(std::move(next));
+      }
+    }
+
+    /**
+     * Requests coming from now on need a new transaction, called with mutex locked.
+     * @return waiters of the flight.
+     */
+    auto Land(Flight& flight) -> std::vector<Waiter>
+    {
+      auto const it = _reads.find(flight.request);
+      if ((it != _reads.cend()) && (it->second.get() == &flight))
+      {
+        _reads.erase(it);
+      }
+      return std::move(flight.waiters);
+    }
+
+  private:
+    Impl& _server;
+    std::unique_ptr<Transport> _transport;
+    std::mutex _mutex;                  ///< guards queue, reads, busy flag and waiters of queued flights
+    std::condition_variable _wakeUp;
+    std::condition_variable _idle;
+    std::deque<std::shared_ptr<Flight>> _queue;
+    std::map<std::string, std::shared_ptr<Flight>> _reads;   ///< queued and in flight reads by request
+    uint64_t _sequence{};
+    bool _running{true};
+    bool _busy{};                       ///< exchange of an asynchronous transport is in progress
+    std::thread _thread;                ///< synchronous transports only
+  };
+
+  class Session : public std::enable_shared_from_this<Session>
+  {
+  public:
+    Session(Impl& server, boost::asio::local::stream_protocol::socket socket)
+      : _server{server}
+      , _socket{std::move(socket)}
+    {
+    }
+
+    void ReadHeader()
+    {
+      auto self = shared_from_this();
+      boost::asio::async_read(_socket, boost::asio::buffer(_header), [self](boost::system::error_code const& error, size_t) {
+        if (error)
+        {
+          return;
+        }
+        auto const header = MuxProtocol::DecodeHeader(self->_header.data());
+        if (header.length > MuxProtocol::MAX_PAYLOAD_SIZE)
+        {
+          // Not a client of this protocol, connection is closed
+          return;
+        }
+        self->_payload.resize(header.length);
+        if (header.length == 0)
+        {
+          self->Handle(header);
+          return;
+        }
+        boost::asio::async_read(self->_socket, boost::asio::buffer(&self->_payload[0], self->_payload.size()),
+                                [self, header](boost::system::error_code const& error, size_t) {
+          if (!error)
+          {
+            self->Handle(header);
+          }
+        });
+      });
+    }
+
+    /**
+     * Called on the io thread only.
+     */
+    void Reply(uint32_t id, MuxProtocol::eStatus status, std::string const& payload)
+    {
+      _outgoing.emplace_back(MuxProtocol::Encode({MuxProtocol::eType::REPLY, id, static_cast<uint16_t>(status), 0}, payload));
+      if (_outgoing.size() == 1)
+      {
+        WriteNext();
+      }
+    }
+
+  private:
+    void Handle(MuxProtocol::Header const& header)
+    {
+      switch (header.type)
+      {
+        case MuxProtocol::eType::ATTACH:
+        {
+          auto const it = _server._ports.find(_payload);
+          _port = (it != _server._ports.cend()) ? it->second.get() : nullptr;
+          Reply(header.id, _port ? MuxProtocol::eStatus::OK : MuxProtocol::eStatus::UNKNOWN_PORT, {});
+          break;
+        }
+        case MuxProtocol::eType::TRANSACT:
+        case MuxProtocol::eType::SEND:
+          ++_server._requests;
+          if (!_port)
+          {
+            Reply(header.id, MuxProtocol::eStatus::UNKNOWN_PORT, {});
+          }
+          else if ((_payload.size() < 4) || (_payload.size() > MAX_FRAME_SIZE))
+          {
+            Reply(header.id, MuxProtocol::eStatus::BAD_REQUEST, {});
+          }
+          else
+          {
+            _lastSequence = _port->Submit({shared_from_this(), header.id}, header.type, header.value, _payload, _lastSequence);
+          }
+          break;
+        default:
+          Reply(header.id, MuxProtocol::eStatus::BAD_REQUEST, {});
+          break;
+      }
+      ReadHeader();
+    }
+
+    void WriteNext()
+    {
+      auto self = shared_from_this();
+      boost::asio::async_write(_socket, boost::asio::buffer(_outgoing.front()), [self](boost::system::error_code const& error, size_t) {
+        if (error)
+        {
+          return;
+        }
+        self->_outgoing.pop_front();
+        if (!self->_outgoing.empty())
+        {
+          self->WriteNext();
+        }
+      });
+    }
+
+  private:
+    Impl& _server;
+    boost::asio::local::stream_protocol::socket _socket;
+    std::array<char, MuxProtocol::HEADER_SIZE> _header{};
+    std::string _payload;
+    std::deque<std::string> _outgoing;
+    Port* _port{};
+    uint64_t _lastSequence{};
+  };
+
+private:
+  void Accept()
+  {
+    _acceptor.async_accept(_socket, [this](boost::system::error_code const& error) {
+      if (error)
+      {
+        return;
+      }
+      ++_connections;
+      std::make_shared<Session>(*this, std::move(_socket))->ReadHeader();
+      _socket = boost::asio::local::stream_protocol::socket{_io};
+      Accept();
+    });
+  }
+
+  /**
+   * Called by port threads, replies are written by the io thread.
+   */
+  void Reply(std::vector<Waiter> waiters, MuxProtocol::eStatus status, std::string const& response)
+  {
+    _io.post([waiters = std::move(waiters), status, response] {
+      for (auto const& waiter : waiters)
+      {
+        waiter.session->Reply(waiter.id, status, response);
+      }
+    });
+  }
+
+private:
+  std::string _socketPath;
+  boost::asio::io_service _io;
+  boost::asio::local::stream_protocol::acceptor _acceptor{_io};
+  boost::asio::local::stream_protocol::socket _socket{_io};
+  std::map<std::string, std::unique_ptr<Port>> _ports;   ///< not changed after construction
+  std::thread _thread;
+  std::atomic<uint64_t> _requests{};
+  std::atomic<uint64_t> _transactions{};
+  std::atomic<uint64_t> _coalesced{};
+  std::atomic<uint64_t> _connections{};
+};
+
+MuxServer::MuxServer(std::string const& socketPath, std::vector<ImpulseCounter30::CommunicationOptions> const& ports)
+  : pImpl{std::make_unique<Impl>(socketPath, ports)}
+{
+}
+
+MuxServer::~MuxServer() = default;
+
+auto MuxServer::GetCounters() const -> Counters
+{
+  return pImpl->GetCounters();
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,183 @@
+#include "MuxTransport.hpp"
+
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace {
+
+constexpr char const* MUX_SCHEME = "mux://";
+/// Wait for a reply beyond the timeout of its request, the daemon serves requests queued by other clients before it
+constexpr size_t REPLY_ALLOWANCE_MS = 10000;
+
+} /// end namespace anonymous
+
+MuxTransport::MuxTransport(std::string const& url)
+  : _url{url}
+  , _io{}
+  , _socket{_io}
+  , _timer{_io}
+{
+  auto const separator = url.find('#');
+  if (!IsUrl(url) || (separator == std::string::npos) || (separator == std::string{MUX_SCHEME}.size()) || (separator + 1 == url.size()))
+  {
+    throw std::runtime_error("Socket and port paths are expected in " + url);
+  }
+  _socketPath = url.substr(std::string{MUX_SCHEME}.size(), separator - std::string{MUX_SCHEME}.size());
+  _portPath = url.substr(separator + 1);
+  _socket.connect(boost::asio::local::stream_protocol::endpoint(_socketPath));
+  if (!Attach())
+  {
+    throw std::runtime_error("Port is not served by " + _socketPath);
+  }
+}
+
+bool MuxTransport::IsUrl(std::string const& path)
+{
+  return path.compare(0, std::string{MUX_SCHEME}.size(), MUX_SCHEME) == 0;
+}
+
+void MuxTransport::Capture(std::string const& capturePath)
+{
+  _capture = std::make_unique<CaptureWriter>(capturePath, _url);
+}
+
+bool MuxTransport::Attach()
+{
+  MuxProtocol::Header header;
+  std::string payload;
+  auto const id = Write(MuxProtocol::eType::ATTACH, 0, _portPath);
+  return (id != 0) &&
+         ReadReply(header, payload, 0) &&
+         (header.id == id) &&
+         (header.value == static_cast<uint16_t>(MuxProtocol::eStatus::OK));
+}
+
+bool MuxTransport::Reconnect()
+{
+  boost::system::error_code errorCode;
+  _socket.close(errorCode);
+  _socket.connect(boost::asio::local::stream_protocol::endpoint(_socketPath), errorCode);
+  if (errorCode || !Attach())
+  {
+    _socket.close(errorCode);
+    return false;
+  }
+  return true;
+}
+
+auto MuxTransport::Write(MuxProtocol::eType type, size_t timeoutMs, std::string const& payload) -> uint32_t
+{
+  auto const id = ++_id;
+  auto const message = MuxProtocol::Encode({type, id, static_cast<uint16_t>(std::min<size_t>(timeoutMs, UINT16_MAX)), 0}, payload);
+  boost::system::error_code errorCode;
+  boost::asio::write(_socket, boost::asio::buffer(message), errorCode);
+  return errorCode ? 0 : id;
+}
+
+bool MuxTransport::ReadReply(MuxProtocol::Header& header, std::string& payload, size_t timeoutMs)
+{
+  bool readError{true};
+  std::array<char, MuxProtocol::HEADER_SIZE> headerData{};
+  boost::asio::async_read(_socket, boost::asio::buffer(headerData), [&](boost::system::error_code const& error, size_t) {
+    if (error)
+    {
+      _timer.cancel();
+      return;
+    }
+    header = MuxProtocol::DecodeHeader(headerData.data());
+    payload.resize(header.length);
+    boost::asio::async_read(_socket, boost::asio::buffer(&payload[0], payload.size()), [&](boost::system::error_code const& error, size_t) {
+      readError = static_cast<bool>(error);
+      _timer.cancel();
+    });
+  });
+  _timer.expires_from_now(boost::posix_time::milliseconds(timeoutMs + REPLY_ALLOWANCE_MS));
+  _timer.async_wait([&](const boost::system::error_code& error) {
+    if (!error)
+    {
+      _socket.cancel();
+    }
+  });
+  _io.run();
+  _io.reset();
+  return !readError && (header.type == MuxProtocol::eType::REPLY);
+}
+
+void MuxTransport::Record(std::string const& request, std::string const& response, bool complete)
+{
+  if (!_capture)
+  {
+    return;
+  }
+  _capture->Request(request.data(), request.size());
+  if (!response.empty())
+  {
+    _capture->Chunk(response.data(), response.size());
+  }
+  _capture->End(complete);
+}
+
+void MuxTransport::SendCommand(std::string const& data,
+                               tResponseCallback&& response,
+                               size_t timeoutResponseMs,
+                               tResponseComplete const&)
+{
+  SendCommands({data}, [&](size_t, std::string const& responseData, bool error, std::chrono::steady_clock::time_point) {
+    response(responseData, error);
+  }, timeoutResponseMs, {});
+}
+
+void MuxTransport::SendCommands(std::vector<std::string> const& requests,
+                                tIndexedResponseCallback const& response,
+                                size_t timeoutResponseMs,
+                                std::vector<tResponseComplete> const&)
+{
+  auto connected = _socket.is_open() || Reconnect();
+  auto started = std::chrono::steady_clock::now();
+  std::vector<uint32_t> ids(requests.size());
+  for (size_t i = 0; connected && (i < requests.size()); ++i)
+  {
+    ids[i] = Write(MuxProtocol::eType::TRANSACT, timeoutResponseMs, requests[i]);
+  }
+  // Replies of a connection come in order of requests
+  for (size_t i = 0; i < requests.size(); ++i)
+  {
+    MuxProtocol::Header header;
+    std::string payload;
+    connected = connected && (ids[i] != 0) && ReadReply(header, payload, timeoutResponseMs) && (header.id == ids[i]);
+    auto const ok = connected && (header.value == static_cast<uint16_t>(MuxProtocol::eStatus::OK));
+    if (!connected)
+    {
+      payload.clear();
+    }
+    Record(requests[i], payload, ok);
+    response(i, payload, !ok, started);
+    // The daemon transacts the requests of a connection on the port one by one, the next one starts after this reply
+    started = std::max(started, std::chrono::steady_clock::now());
+  }
+  if (!connected)
+  {
+    // Replies still to come would be taken for the ones of the next requests
+    boost::system::error_code errorCode;
+    _socket.close(errorCode);
+  }
+}
+
+bool MuxTransport::Send(std::string const& data)
+{
+  MuxProtocol::Header header;
+  std::string payload;
+  auto const id = (_socket.is_open() || Reconnect()) ? Write(MuxProtocol::eType::SEND, 0, data) : 0;
+  auto const connected = (id != 0) && ReadReply(header, payload, 0) && (header.id == id);
+  if (!connected)
+  {
+    boost::system::error_code errorCode;
+    _socket.close(errorCode);
+  }
+  Record(data, {}, true);
+  return connected && (header.value == static_cast<uint16_t>(MuxProtocol::eStatus::OK));
+}
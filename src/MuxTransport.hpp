@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CaptureWriter.hpp"
+#include "MuxProtocol.hpp"
+#include "Transport.hpp"
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+#include <memory>
+
+/**
+ * Client of the multiplexing daemon (muxd_OWEN_ImpulseCounter30) which owns the port, so several processes
+ * can share it: mux://SOCKET_PATH#PORT_PATH. Completion of responses is decided by the daemon from the request
+ * (expected size or exception response), isComplete predicates are not used.
+ * A reply which does not come in time or out of order closes the connection, stale replies can not be taken for
+ * the ones of later requests then, it is connected and attached again on the next request.
+ */
+class MuxTransport : public Transport
+{
+public:
+  /**
+   * Connect to the daemon and attach to the port.
+   * @throw std::runtime_error if URL is malformed or the daemon does not serve the port,
+   *        boost::system::system_error if the daemon is not running.
+   */
+  explicit MuxTransport(std::string const& url);
+
+  static bool IsUrl(std::string const& path);
+
+  void SendCommand(std::string const& data,
+                   tResponseCallback && response = [](std::string const&, bool error){},
+                   size_t timeoutResponseMs = 0,
+                   tResponseComplete const& isComplete = {}) override;
+
+  /**
+   * All requests are sent before the first reply is read, so the daemon queues them without client round trips.
+   */
+  void SendCommands(std::vector<std::string> const& requests,
+                    tIndexedResponseCallback const& response,
+                    size_t timeoutResponseMs,
+                    std::vector<tResponseComplete> const& isComplete) override;
+
+  bool Send(std::string const& data) override;
+
+  auto Path() const -> std::string const& override
+  {
+    return _url;
+  }
+
+  void Capture(std::string const& capturePath) override;
+
+private:
+  /**
+   * Attach the connected socket to the port.
+   * @return false if the daemon does not serve the port or does not reply.
+   */
+  bool Attach();
+
+  /**
+   * Connect again after the connection was closed.
+   * @return false if the daemon is not running or does not serve the port.
+   */
+  bool Reconnect();
+
+  /**
+   * @return id of the sent message, 0 if the connection is broken.
+   */
+  auto Write(MuxProtocol::eType type, size_t timeoutMs, std::string const& payload) -> uint32_t;
+
+  /**
+   * Read of the next reply, the daemon may serve requests of other clients first.
+   * @param timeoutMs timeout of the request on the port, the reply is waited for a queueing allowance longer.
+   * @return false if the connection is broken or the reply did not come in time.
+   */
+  bool ReadReply(MuxProtocol::Header& header, std::string& payload, size_t timeoutMs);
+
+  void Record(std::string const& request, std::string const& response, bool complete);
+
+private:
+  std::string _url;
+  std::string _socketPath;
+  std::string _portPath;
+  boost::asio::io_service _io;
+  boost::asio::local::stream_protocol::socket _socket;
+  boost::asio::deadline_timer _timer;
+  uint32_t _id{};
+  std::unique_ptr<CaptureWriter> _capture;
+};
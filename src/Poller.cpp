@@ -0,0 +1,242 @@
+#include <OWEN/Poller.hpp>
+
+#include "SI30RegisterMap.hpp"
+#include "SnapshotPublisher.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace OWEN {
+
+Poller::Poller(std::chrono::milliseconds period)
+  : _period{period}
+{
+}
+
+Poller::~Poller()
+{
+  Stop();
+}
+
+void Poller::Add(uint8_t unit, ImpulseCounter30 counter)
+{
+  if (_running)
+  {
+    throw std::runtime_error("Counters can not be added to running poller");
+  }
+  if (!_devices.emplace(unit, Device{std::move(counter), {}}).second)
+  {
+    throw std::runtime_error("Unit " + std::to_string(unit) + " is already polled");
+  }
+}
+
+void Poller::Publish(std::string const& shmName)
+{
+  if (_running)
+  {
+    throw std::runtime_error("Publishing can not be started on running poller");
+  }
+  _publisher = SnapshotPublisher::Open(shmName);
+}
+
+void Poller::Start()
+{
+  if (_running.exchange(true))
+  {
+    return;
+  }
+  _thread = std::thread([this] { Run(); });
+}
+
+void Poller::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _running = false;
+  }
+  _wakeUp.notify_all();
+  if (_thread.joinable())
+  {
+    _thread.join();
+  }
+  std::deque<PendingWrite> writes;
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    writes.swap(_writes);
+  }
+  for (auto const& write : writes)
+  {
+    write.done(false, 0);
+  }
+}
+
+auto Poller::Units() const -> std::vector<uint8_t>
+{
+  std::vector<uint8_t> units;
+  for (auto const& device : _devices)
+  {
+    units.emplace_back(device.first);
+  }
+  return units;
+}
+
+auto Poller::Image(uint8_t unit) const -> std::shared_ptr<Cached const>
+{
+  auto const it = _devices.find(unit);
+  if (it == _devices.cend())
+  {
+    return {};
+  }
+  std::lock_guard<std::mutex> lock{_mutex};
+  return it->second.cached;
+}
+
+bool Poller::Write(uint8_t unit, WriteRequest request, tWriteDone done)
+{
+  if (_devices.count(unit) == 0)
+  {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!_running)
+    {
+      return false;
+    }
+    _writes.emplace_back(PendingWrite{unit, std::move(request), std::move(done)});
+  }
+  _wakeUp.notify_one();
+  return true;
+}
+
+auto Poller::GetMetrics() const -> std::vector<DeviceMetrics>
+{
+  std::vector<DeviceMetrics> metrics;
+  for (auto const& device : _devices)
+  {
+    auto deviceMetrics = device.second.counter.GetMetrics();
+    std::move(deviceMetrics.begin(), deviceMetrics.end(), std::back_inserter(metrics));
+  }
+  return metrics;
+}
+
+bool Poller::GetMetrics(uint8_t unit, std::vector<DeviceMetrics>& metrics) const
+{
+  auto const it = _devices.find(unit);
+  if (it == _devices.cend())
+  {
+    return false;
+  }
+  it->second.counter.GetMetrics(metrics);
+  return true;
+}
+
+void Poller::Run()
+{
+  using namespace std::chrono;
+  auto nextPoll = steady_clock::now();
+  std::unique_lock<std::mutex> lock{_mutex};
+  while (_running)
+  {
+    _wakeUp.wait_until(lock, nextPoll, [this] { return !_running || !_writes.empty(); });
+    if (!_running)
+    {
+      break;
+    }
+    lock.unlock();
+    ExecuteWrites();
+    if (steady_clock::now() >= nextPoll)
+    {
+      // Writes are checked between devices, so a write waits for one transaction at most, not for a whole cycle
+      for (auto& device : _devices)
+      {
+        Poll(device.first, device.second);
+        ExecuteWrites();
+      }
+      // A slow bus does not accumulate a backlog of polls
+      nextPoll = std::max(nextPoll + _period, steady_clock::now());
+    }
+    lock.lock();
+  }
+}
+
+void Poller::Poll(uint8_t unit, Device& device)
+{
+  auto image = device.counter.GetRegisterImage();
+  if (!image.has_value())
+  {
+    // Consumers see the age of the last good image
+    return;
+  }
+  if (_publisher)
+  {
+    using namespace SI30;
+    auto const* input = image->inputRegisters.data();
+    SnapshotShm::Snapshot snapshot{};
+    snapshot.counterValue = CounterValue::Decode(input + CounterValue::address);
+    snapshot.counterEU = CounterEU::Decode(input + CounterEU::address);
+    snapshot.startStopMode = StartStopMode::Decode(input + StartStopMode::address);
+    snapshot.currentMode = static_cast<uint8_t>(CurrentMode::Decode(input + CurrentMode::address));
+    snapshot.codeErrNet = CodeErrNet::Decode(input + CodeErrNet::address);
+    snapshot.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    _publisher->Publish(unit, snapshot);
+  }
+  auto cached = std::make_shared<Cached const>(Cached{std::move(image.value()), std::chrono::steady_clock::now()});
+  std::lock_guard<std::mutex> lock{_mutex};
+  device.cached = std::move(cached);
+}
+
+void Poller::ExecuteWrites()
+{
+  while (true)
+  {
+    PendingWrite write;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      if (_writes.empty() || !_running)
+      {
+        return;
+      }
+      write = std::move(_writes.front());
+      _writes.pop_front();
+    }
+    auto& device = _devices.at(write.unit);
+    auto const& request = write.request;
+    auto const written = (request.kind == WriteRequest::eKind::COIL)
+                         ? device.counter.WriteCoil(request.address, !request.values.empty() && (request.values[0] != 0))
+                         : device.counter.WriteHoldingRegisters(request.address, request.values);
+    if (written)
+    {
+      Apply(device, request);
+    }
+    write.done(written, written ? uint8_t{} : device.counter.LastExceptionCode());
+  }
+}
+
+void Poller::Apply(Device& device, WriteRequest const& request)
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  if (!device.cached)
+  {
+    return;
+  }
+  auto cached = std::make_shared<Cached>(*device.cached);
+  auto& image = cached->image;
+  for (size_t i = 0; i < request.values.size(); ++i)
+  {
+    auto const address = request.address + i;
+    if ((request.kind == WriteRequest::eKind::COIL) && (address < image.coils.size()))
+    {
+      image.coils[address] = (request.values[i] != 0);
+    }
+    else if ((request.kind == WriteRequest::eKind::HOLDING_REGISTERS) && (address < image.holdingRegisters.size()))
+    {
+      image.holdingRegisters[address] = request.values[i];
+    }
+  }
+  device.cached = std::move(cached);
+}
+
+} /// end namespace OWEN
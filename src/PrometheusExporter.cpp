@@ -0,0 +1,427 @@
+#include <OWEN/PrometheusExporter.hpp>
+
+#include "SI30RegisterMap.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace OWEN {
+
+namespace {
+
+constexpr size_t MAX_REQUEST_SIZE = 4096;
+constexpr auto REQUEST_TIMEOUT = std::chrono::seconds{5};
+constexpr auto WATCHDOG_PERIOD = std::chrono::seconds{1};
+
+constexpr std::string_view PROMETHEUS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+constexpr std::string_view OPENMETRICS_CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+/// Histogram bounds are powers of two in us, these are exact bucket edges of LatencyHistogram
+constexpr uint32_t FIRST_BOUND_BITS = 8;
+constexpr uint32_t LAST_BOUND_BITS = 24;
+
+struct CounterFamily
+{
+  std::string_view name;
+  std::string_view help;
+  uint64_t FunctionMetrics::* value;
+};
+
+constexpr CounterFamily COUNTER_FAMILIES[] = {
+  {"owen_modbus_requests", "Modbus transactions and broadcasts sent.", &FunctionMetrics::requests},
+  {"owen_modbus_timeouts", "Transactions without reply in time.", &FunctionMetrics::timeouts},
+  {"owen_modbus_bad_frames", "Transactions with incomplete or corrupted reply.", &FunctionMetrics::badFrames},
+  {"owen_modbus_exceptions", "Transactions rejected by the device.", &FunctionMetrics::exceptions},
+  {"owen_modbus_sent_bytes", "Bytes of requests sent.", &FunctionMetrics::bytesSent},
+  {"owen_modbus_received_bytes", "Bytes of replies received.", &FunctionMetrics::bytesReceived}
+};
+
+template <typename T>
+void AppendNumber(std::string& out, T value)
+{
+  std::array<char, 32> buffer;
+  auto const result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  out.append(buffer.data(), result.ptr);
+}
+
+void AppendHex(std::string& out, uint8_t value)
+{
+  constexpr char digits[] = "0123456789abcdef";
+  out += "0x";
+  out += digits[value >> 4];
+  out += digits[value & 0x0F];
+}
+
+} /// end namespace anonymous
+
+class PrometheusExporter::Impl
+{
+public:
+  Impl(std::vector<std::reference_wrapper<Poller>> const& pollers, uint16_t port, std::string const& address)
+    : _acceptor{_io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(address), port)}
+  {
+    std::set<uint8_t> units;
+    for (auto& poller : pollers)
+    {
+      for (auto const unit : poller.get().Units())
+      {
+        if (!units.insert(unit).second)
+        {
+          throw std::runtime_error("Unit " + std::to_string(unit) + " is polled by several pollers");
+        }
+        _units.emplace_back(Unit{unit, &poller.get(), {}, {}});
+      }
+    }
+    Accept();
+    Watch();
+    _thread = std::thread([this] { _io.run(); });
+  }
+
+  ~Impl()
+  {
+    _io.stop();
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+  }
+
+  auto Port() const -> uint16_t
+  {
+    return _acceptor.local_endpoint().port();
+  }
+
+private:
+  struct Unit
+  {
+    uint8_t unit{};
+    Poller* poller{};
+    std::shared_ptr<Poller::Cached const> cached;   ///< held while rendering only
+    std::vector<DeviceMetrics> metrics;             ///< kept between scrapes
+  };
+
+private:
+  void Accept()
+  {
+    _acceptor.async_accept(_socket, [this](boost::system::error_code const& error) {
+      if (error)
+      {
+        return;
+      }
+      _received = 0;
+      _accepted = std::chrono::steady_clock::now();
+      _connected = true;
+      Read();
+    });
+  }
+
+  void Read()
+  {
+    _socket.async_read_some(boost::asio::buffer(_request.data() + _received, _request.size() - _received),
+                            [this](boost::system::error_code const& error, size_t size) {
+      if (error)
+      {
+        Finish();
+        return;
+      }
+      _received += size;
+      std::string_view const request{_request.data(), _received};
+      if (request.find("\r\n\r\n") != std::string_view::npos)
+      {
+        Respond(request);
+      }
+      else if (_received < _request.size())
+      {
+        Read();
+      }
+      else
+      {
+        Finish();
+      }
+    });
+  }
+
+  void Respond(std::string_view request)
+  {
+    auto const methodEnd = request.find(' ');
+    auto const targetEnd = request.find_first_of(" ?", methodEnd + 1);
+    auto const method = request.substr(0, methodEnd);
+    auto const path = (methodEnd != std::string_view::npos) ? request.substr(methodEnd + 1, targetEnd - methodEnd - 1) : std::string_view{};
+    auto const openMetrics = request.find("application/openmetrics-text") != std::string_view::npos;
+
+    std::string_view status = "200 OK";
+    std::string_view contentType = openMetrics ? OPENMETRICS_CONTENT_TYPE : PROMETHEUS_CONTENT_TYPE;
+    _body.clear();
+    if (method != "GET")
+    {
+      status = "405 Method Not Allowed";
+      contentType = "text/plain";
+    }
+    else if (path != "/metrics")
+    {
+      status = "404 Not Found";
+      contentType = "text/plain";
+      _body += "Metrics are served at /metrics\n";
+    }
+    else
+    {
+      Render(openMetrics);
+    }
+
+    _header.clear();
+    _header += "HTTP/1.1 ";
+    _header += status;
+    _header += "\r\nContent-Type: ";
+    _header += contentType;
+    _header += "\r\nContent-Length: ";
+    AppendNumber(_header, _body.size());
+    _header += "\r\nConnection: close\r\n\r\n";
+    std::array<boost::asio::const_buffer, 2> const buffers{boost::asio::buffer(_header), boost::asio::buffer(_body)};
+    boost::asio::async_write(_socket, buffers, [this](boost::system::error_code const&, size_t) {
+      Finish();
+    });
+  }
+
+  /**
+   * A timer armed per connection would allocate its handler every scrape, so one timer keeps ticking instead.
+   */
+  void Watch()
+  {
+    _watchdog.expires_from_now(WATCHDOG_PERIOD);
+    _watchdog.async_wait([this](boost::system::error_code const& error) {
+      if (error)
+      {
+        return;
+      }
+      if (_connected && ((std::chrono::steady_clock::now() - _accepted) > REQUEST_TIMEOUT))
+      {
+        // A slow client is dropped, its pending operation completes with an error
+        boost::system::error_code ignored;
+        _socket.close(ignored);
+      }
+      Watch();
+    });
+  }
+
+  void Finish()
+  {
+    _connected = false;
+    boost::system::error_code ignored;
+    _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+    _socket.close(ignored);
+    Accept();
+  }
+
+  /**
+   * Families are rendered one by one, every one with samples of all units.
+   */
+  void Render(bool openMetrics)
+  {
+    using namespace SI30;
+    auto const now = std::chrono::steady_clock::now();
+    for (auto& unit : _units)
+    {
+      unit.cached = unit.poller->Image(unit.unit);
+      unit.poller->GetMetrics(unit.unit, unit.metrics);
+    }
+
+    auto const renderGauge = [&](std::string_view name, std::string_view help, auto value) {
+      Family(name, "gauge", help, openMetrics);
+      for (auto const& unit : _units)
+      {
+        if (unit.cached)
+        {
+          BeginSample(name, {}, unit.unit);
+          _body += "} ";
+          AppendNumber(_body, value(*unit.cached));
+          _body += '\n';
+        }
+      }
+    };
+    auto const input = [](Poller::Cached const& cached) { return cached.image.inputRegisters.data(); };
+    renderGauge("owen_si30_counter_value", "Counter value.", [&](Poller::Cached const& cached) {
+      return CounterValue::Decode(input(cached) + CounterValue::address);
+    });
+    renderGauge("owen_si30_counter_eu", "Counter value in engineering units (raw, decimal point is not applied).", [&](Poller::Cached const& cached) {
+      return CounterEU::Decode(input(cached) + CounterEU::address);
+    });
+    renderGauge("owen_si30_counting", "1 if counting is started.", [&](Poller::Cached const& cached) {
+      return static_cast<int32_t>(StartStopMode::Decode(input(cached) + StartStopMode::address));
+    });
+    renderGauge("owen_si30_current_mode", "Current mode of the device (ImpulseCounter30::eCurrentMode).", [&](Poller::Cached const& cached) {
+      return static_cast<int32_t>(CurrentMode::Decode(input(cached) + CurrentMode::address));
+    });
+    renderGauge("owen_si30_code_err_net", "Code of the last network error reported by the device (GetCodeErrNet).", [&](Poller::Cached const& cached) {
+      return static_cast<int32_t>(CodeErrNet::Decode(input(cached) + CodeErrNet::address));
+    });
+    renderGauge("owen_si30_image_age_seconds", "Time since the last successful poll of the device.", [&](Poller::Cached const& cached) {
+      return std::chrono::duration<double>(now - cached.time).count();
+    });
+
+    Family("owen_si30_output_state", "gauge", "1 if the output is on.", openMetrics);
+    for (auto const& unit : _units)
+    {
+      if (!unit.cached)
+      {
+        continue;
+      }
+      auto const& coils = unit.cached->image.coils;
+      for (auto const address : {OutState1::address, OutState2::address})
+      {
+        BeginSample("owen_si30_output_state", {}, unit.unit);
+        _body += ",output=\"";
+        AppendNumber(_body, address + 1);
+        _body += "\"} ";
+        _body += ((address < coils.size()) && coils[address]) ? '1' : '0';
+        _body += '\n';
+      }
+    }
+
+    for (auto const& family : COUNTER_FAMILIES)
+    {
+      Family(family.name, "counter", family.help, openMetrics);
+      ForEachFunction([&](Unit const& unit, DeviceMetrics const& deviceMetrics, FunctionMetrics const& functionMetrics) {
+        BeginFunctionSample(family.name, "_total", unit, deviceMetrics, functionMetrics);
+        _body += "} ";
+        AppendNumber(_body, functionMetrics.*family.value);
+        _body += '\n';
+      });
+    }
+
+    constexpr std::string_view latency = "owen_modbus_latency_seconds";
+    Family(latency, "histogram", "Time from request sent to reply received or timeout.", openMetrics);
+    ForEachFunction([&](Unit const& unit, DeviceMetrics const& deviceMetrics, FunctionMetrics const& functionMetrics) {
+      auto const& histogram = functionMetrics.latency;
+      uint64_t cumulative{};
+      uint32_t bucket{};
+      for (auto bits = FIRST_BOUND_BITS; bits <= LAST_BOUND_BITS; ++bits)
+      {
+        auto const boundUs = uint64_t{1} << bits;
+        while (((bucket + 1) < LatencyHistogram::BUCKET_COUNT) && (LatencyHistogram::LowerBoundOf(bucket + 1) <= boundUs))
+        {
+          cumulative += histogram.counts[bucket++];
+        }
+        BeginFunctionSample(latency, "_bucket", unit, deviceMetrics, functionMetrics);
+        _body += ",le=\"";
+        AppendNumber(_body, static_cast<double>(boundUs) / 1e6);
+        _body += "\"} ";
+        AppendNumber(_body, cumulative);
+        _body += '\n';
+      }
+      BeginFunctionSample(latency, "_bucket", unit, deviceMetrics, functionMetrics);
+      _body += ",le=\"+Inf\"} ";
+      AppendNumber(_body, histogram.count);
+      _body += '\n';
+      BeginFunctionSample(latency, "_sum", unit, deviceMetrics, functionMetrics);
+      _body += "} ";
+      AppendNumber(_body, static_cast<double>(histogram.sumUs) / 1e6);
+      _body += '\n';
+      BeginFunctionSample(latency, "_count", unit, deviceMetrics, functionMetrics);
+      _body += "} ";
+      AppendNumber(_body, histogram.count);
+      _body += '\n';
+    });
+
+    if (openMetrics)
+    {
+      _body += "# EOF\n";
+    }
+    for (auto& unit : _units)
+    {
+      unit.cached.reset();
+    }
+  }
+
+  /**
+   * In the Prometheus text format the type of a counter is given for its sample name (with _total suffix).
+   */
+  void Family(std::string_view name, std::string_view type, std::string_view help, bool openMetrics)
+  {
+    auto const total = !openMetrics && (type == "counter");
+    _body += "# HELP ";
+    _body += name;
+    _body += total ? "_total " : " ";
+    _body += help;
+    _body += "\n# TYPE ";
+    _body += name;
+    _body += total ? "_total " : " ";
+    _body += type;
+    _body += '\n';
+  }
+
+  /**
+   * Sample name and unit label, caller adds other labels and closes them.
+   */
+  void BeginSample(std::string_view name, std::string_view suffix, uint8_t unit)
+  {
+    _body += name;
+    _body += suffix;
+    _body += "{unit=\"";
+    AppendNumber(_body, unit);
+    _body += '"';
+  }
+
+  void BeginFunctionSample(std::string_view name, std::string_view suffix, Unit const& unit,
+                           DeviceMetrics const& deviceMetrics, FunctionMetrics const& functionMetrics)
+  {
+    BeginSample(name, suffix, unit.unit);
+    _body += ",address=\"";
+    AppendNumber(_body, deviceMetrics.address);
+    _body += "\",function=\"";
+    AppendHex(_body, functionMetrics.function);
+    _body += '"';
+  }
+
+  template <typename F>
+  void ForEachFunction(F&& render)
+  {
+    for (auto const& unit : _units)
+    {
+      for (auto const& deviceMetrics : unit.metrics)
+      {
+        for (auto const& functionMetrics : deviceMetrics.functions)
+        {
+          render(unit, deviceMetrics, functionMetrics);
+        }
+      }
+    }
+  }
+
+private:
+  std::vector<Unit> _units;
+  boost::asio::io_service _io;
+  boost::asio::ip::tcp::acceptor _acceptor;
+  boost::asio::ip::tcp::socket _socket{_io};   ///< the only connection, scrapes are served one by one
+  boost::asio::steady_timer _watchdog{_io};
+  std::chrono::steady_clock::time_point _accepted;
+  bool _connected{};
+  std::array<char, MAX_REQUEST_SIZE> _request{};
+  size_t _received{};
+  std::string _header;
+  std::string _body;
+  std::thread _thread;
+};
+
+PrometheusExporter::PrometheusExporter(std::vector<std::reference_wrapper<Poller>> const& pollers, uint16_t port, std::string const& address)
+  : pImpl{std::make_unique<Impl>(pollers, port, address)}
+{
+}
+
+PrometheusExporter::~PrometheusExporter() = default;
+
+auto PrometheusExporter::Port() const -> uint16_t
+{
+  return pImpl->Port();
+}
+
+} /// end namespace OWEN
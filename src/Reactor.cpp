@@ -0,0 +1,23 @@
+#include "Reactor.hpp"
+
+auto Reactor::Shared() -> Reactor&
+{
+  static Reactor reactor;
+  return reactor;
+}
+
+Reactor::Reactor()
+  : _work{std::make_unique<boost::asio::io_service::work>(_io)}
+  , _thread{[this] { _io.run(); }}
+{
+}
+
+Reactor::~Reactor()
+{
+  _work.reset();
+  _io.stop();
+  if (_thread.joinable())
+  {
+    _thread.join();
+  }
+}
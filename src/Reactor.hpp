@@ -0,0 +1,45 @@
+#pragma once
+
+#include <boost/asio/io_service.hpp>
+
+#include <memory>
+#include <thread>
+
+/**
+ * Event loop shared by reactor driven transports (see CommunicationOptions::SharedReactor). A single thread waits
+ * for events of all their ports, so a port costs nothing while its line is idle and hundreds of ports do not need
+ * hundreds of threads.
+ */
+class Reactor
+{
+public:
+  /**
+   * Reactor of the process, started on first use.
+   */
+  static auto Shared() -> Reactor&;
+
+  ~Reactor();
+  Reactor(Reactor const&) = delete;
+  Reactor& operator=(Reactor const&) = delete;
+
+  auto Io() -> boost::asio::io_service&
+  {
+    return _io;
+  }
+
+  /**
+   * True if called from the reactor thread, where waiting for the reactor would never end.
+   */
+  bool IsReactorThread() const
+  {
+    return std::this_thread::get_id() == _thread.get_id();
+  }
+
+private:
+  Reactor();
+
+private:
+  boost::asio::io_service _io;
+  std::unique_ptr<boost::asio::io_service::work> _work;
+  std::thread _thread;
+};
@@ -0,0 +1,322 @@
+#include "ReactorSerialPort.hpp"
+
+#include "CaptureWriter.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <termios.h>
+#endif
+
+/**
+ * Port state machine, all its state is touched on the reactor thread only.
+ */
+class ReactorSerialPort::Line : public std::enable_shared_from_this<Line>
+{
+public:
+  struct Exchange
+  {
+    std::string request;
+    bool broadcast{};                          ///< no response is awaited
+    size_t timeoutMs{};
+    tResponseComplete isComplete;
+    tResponseCallback response;                ///< not broadcasts only
+    std::function<void(bool sent)> sent;       ///< broadcasts only
+  };
+
+public:
+  /**
+   * @throw boost::system::system_error if port could not be opened or configured.
+   */
+  Line(boost::asio::io_service& io, std::string const& portPath, SerialLineSettings const& settings)
+    : _io{io}
+    , _port{io}
+    , _timer{io}
+    , _portPath{portPath}
+    , _settings{settings}
+  {
+    _settings.Open(_port, _portPath);
+  }
+
+  /**
+   * Can be called from any thread.
+   */
+  void Submit(Exchange exchange)
+  {
+    auto self = shared_from_this();
+    _io.post([self, exchange = std::move(exchange)]() mutable {
+      if (self->_closed)
+      {
+        return;
+      }
+      self->_queue.emplace_back(std::move(exchange));
+      if (!self->_busy)
+      {
+        self->Next();
+      }
+    });
+  }
+
+  void SetCapture(std::unique_ptr<CaptureWriter> capture)
+  {
+    auto self = shared_from_this();
+    std::shared_ptr<CaptureWriter> shared{std::move(capture)};
+    _io.post([self, shared] { self->_capture = shared; });
+  }
+
+  /**
+   * Called on the reactor thread.
+   */
+  void Close()
+  {
+    _closed = true;
+    _queue.clear();
+    boost::system::error_code ignored;
+    _timer.cancel(ignored);
+    _port.close(ignored);
+  }
+
+private:
+  void Next()
+  {
+    // Lost port fails exchanges at once until it is reopened
+    while (!_queue.empty() && !_reconnect.Reopen(_port, _portPath, _settings))
+    {
+      auto exchange = std::move(_queue.front());
+      _queue.pop_front();
+      if (exchange.broadcast)
+      {
+        exchange.sent(false);
+      }
+      else
+      {
+        exchange.response({}, true);
+      }
+    }
+    if (_queue.empty())
+    {
+      _busy = false;
+      return;
+    }
+    _busy = true;
+    _current = std::move(_queue.front());
+    _queue.pop_front();
+    _response.clear();
+    ++_generation;
+    // Bytes of a reply which came after previous timeout would be taken as the beginning of this reply
+#if defined(_WIN32)
+    ::PurgeComm(_port.native_handle(), PURGE_RXCLEAR);
+#else
+    ::tcflush(_port.native_handle(), TCIFLUSH);
+#endif
+    if (_capture)
+    {
+      _capture->Request(_current.request.data(), _current.request.size());
+    }
+    auto self = shared_from_this();
+    boost::asio::async_write(_port, boost::asio::buffer(_current.request), [self](boost::system::error_code const& error, size_t) {
+      self->OnWritten(error);
+    });
+  }
+
+  void OnWritten(boost::system::error_code const& error)
+  {
+    if (_closed)
+    {
+      return;
+    }
+    if (_current.broadcast)
+    {
+      if (_capture)
+      {
+        _capture->End(true);
+      }
+      if (error)
+      {
+        _reconnect.Lost(_port);
+      }
+      auto sent = std::move(_current.sent);
+      sent(!error);
+      Next();
+      return;
+    }
+    if (error)
+    {
+      _reconnect.Lost(_port);
+      Finish(true);
+      return;
+    }
+    auto self = shared_from_this();
+    _timer.expires_from_now(std::chrono::milliseconds(_current.timeoutMs));
+    _timer.async_wait([self, generation = _generation](boost::system::error_code const& error) {
+      // Timer of a finished exchange can not cancel the read of the next one
+      if (!error && (generation == self->_generation) && !self->_closed)
+      {
+        boost::system::error_code ignored;
+        self->_port.cancel(ignored);
+      }
+    });
+    Read();
+  }
+
+  void Read()
+  {
+    auto self = shared_from_this();
+    _port.async_read_some(boost::asio::buffer(_chunk), [self](boost::system::error_code const& error, size_t size) {
+      self->OnRead(error, size);
+    });
+  }
+
+  void OnRead(boost::system::error_code const& error, size_t size)
+  {
+    if (_closed)
+    {
+      return;
+    }
+    if (error || (size == 0))
+    {
+      if (SerialReconnect::IsPortLost(error))
+      {
+        _reconnect.Lost(_port);
+      }
+      else
+      {
+        _reconnect.Exchanged(_port, _current.request, true);
+      }
+      Finish(true);
+      return;
+    }
+    _response.append(_chunk.data(), size);
+    if (_capture)
+    {
+      _capture->Chunk(_chunk.data(), size);
+    }
+    if (_current.isComplete && !_current.isComplete(_response))
+    {
+      Read();
+      return;
+    }
+    boost::system::error_code ignored;
+    _timer.cancel(ignored);
+    _reconnect.Exchanged(_port, _current.request, false);
+    Finish(false);
+  }
+
+  void Finish(bool error)
+  {
+    if (_capture)
+    {
+      _capture->End(!error);
+    }
+    auto response = std::move(_current.response);
+    response(_response, error);
+    Next();
+  }
+
+private:
+  boost::asio::io_service& _io;
+  boost::asio::serial_port _port;
+  boost::asio::steady_timer _timer;
+  std::string _portPath;
+  SerialLineSettings _settings;
+  SerialReconnect _reconnect;
+  std::shared_ptr<CaptureWriter> _capture;
+  std::deque<Exchange> _queue;
+  Exchange _current;
+  std::string _response;
+  std::array<char, 256> _chunk{};
+  uint64_t _generation{};
+  bool _busy{};
+  bool _closed{};
+};
+
+ReactorSerialPort::ReactorSerialPort(Reactor& reactor,
+                                     std::string const& portPath,
+                                     uint32_t baudrate,
+                                     eParity parity,
+                                     eStopBits stopBits,
+                                     uint8_t characterSize)
+  : _reactor{reactor}
+  , _portPath{portPath}
+  , _line{std::make_shared<Line>(reactor.Io(), portPath, SerialLineSettings{baudrate, parity, stopBits, characterSize})}
+{
+}
+
+ReactorSerialPort::~ReactorSerialPort()
+{
+  if (_reactor.IsReactorThread())
+  {
+    _line->Close();
+    return;
+  }
+  std::promise<void> closed;
+  auto future = closed.get_future();
+  _reactor.Io().post([line = _line, &closed] {
+    line->Close();
+    closed.set_value();
+  });
+  future.wait();
+}
+
+void ReactorSerialPort::SendCommand(std::string const& data,
+                                    tResponseCallback&& response,
+                                    size_t timeoutResponseMs,
+                                    tResponseComplete const& isComplete)
+{
+  CheckNotReactorThread();
+  std::string responseData;
+  bool readError{true};
+  std::promise<void> done;
+  auto future = done.get_future();
+  AsyncSendCommand(data, [&](std::string const& received, bool error) {
+    responseData = received;
+    readError = error;
+    done.set_value();
+  }, timeoutResponseMs, isComplete);
+  future.wait();
+  response(responseData, readError);
+}
+
+bool ReactorSerialPort::Send(std::string const& data)
+{
+  CheckNotReactorThread();
+  std::promise<bool> done;
+  auto future = done.get_future();
+  AsyncSend(data, [&done](bool sent) { done.set_value(sent); });
+  return future.get();
+}
+
+void ReactorSerialPort::AsyncSendCommand(std::string const& data,
+                                         tResponseCallback done,
+                                         size_t timeoutResponseMs,
+                                         tResponseComplete isComplete)
+{
+  _line->Submit(Line::Exchange{data, false, timeoutResponseMs, std::move(isComplete), std::move(done), {}});
+}
+
+void ReactorSerialPort::AsyncSend(std::string const& data, std::function<void(bool sent)> done)
+{
+  _line->Submit(Line::Exchange{data, true, 0, {}, {}, std::move(done)});
+}
+
+void ReactorSerialPort::Capture(std::string const& capturePath)
+{
+  _line->SetCapture(std::make_unique<CaptureWriter>(capturePath, _portPath));
+}
+
+void ReactorSerialPort::CheckNotReactorThread() const
+{
+  if (_reactor.IsReactorThread())
+  {
+    throw std::logic_error("Synchronous call of " + _portPath + " from the reactor thread would never complete");
+  }
+}
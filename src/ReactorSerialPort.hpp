@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Reactor.hpp"
+#include "SerialLine.hpp"
+#include "Transport.hpp"
+
+#include <memory>
+
+/**
+ * Modbus RTU over a serial port driven by the shared reactor. Every exchange is a step of the port state machine
+ * (write request, read chunks until the response is complete or timeout), exchanges requested from any thread are
+ * queued and run one by one as the line is half-duplex. Synchronous calls wait for the reactor, so they must not be
+ * made from the reactor thread (from completion callbacks). A lost port is reopened like SerialPort does.
+ */
+class ReactorSerialPort : public Transport
+{
+public:
+  using eParity = SerialLineSettings::eParity;
+  using eStopBits = SerialLineSettings::eStopBits;
+
+public:
+  /**
+   * @throw boost::system::system_error if port could not be opened or configured.
+   */
+  ReactorSerialPort(Reactor& reactor,
+                    std::string const& portPath,
+                    uint32_t baudrate,
+                    eParity parity = eParity::none,
+                    eStopBits = eStopBits::one,
+                    uint8_t characterSize = 8);
+
+  /**
+   * Close the port, queued exchanges are dropped and no callback is called after it returns.
+   */
+  ~ReactorSerialPort() override;
+
+  ReactorSerialPort(ReactorSerialPort const&) = delete;
+  ReactorSerialPort& operator=(ReactorSerialPort const&) = delete;
+
+  /**
+   * @throw std::logic_error if called from the reactor thread.
+   */
+  void SendCommand(std::string const& data,
+                   tResponseCallback && response = [](std::string const&, bool error){},
+                   size_t timeoutResponseMs = 0,
+                   tResponseComplete const& isComplete = {}) override;
+
+  /**
+   * @throw std::logic_error if called from the reactor thread.
+   */
+  bool Send(std::string const& data) override;
+
+  bool IsAsync() const override
+  {
+    return true;
+  }
+
+  void AsyncSendCommand(std::string const& data,
+                        tResponseCallback done,
+                        size_t timeoutResponseMs,
+                        tResponseComplete isComplete) override;
+
+  void AsyncSend(std::string const& data, std::function<void(bool sent)> done) override;
+
+  auto Path() const -> std::string const& override
+  {
+    return _portPath;
+  }
+
+  void Capture(std::string const& capturePath) override;
+
+private:
+  class Line;
+
+  /**
+   * @throw std::logic_error if called from the reactor thread.
+   */
+  void CheckNotReactorThread() const;
+
+private:
+  Reactor& _reactor;
+  std::string _portPath;
+  std::shared_ptr<Line> _line;   ///< kept alive by pending handlers after the port is destroyed
+};
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include "ModBus.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace OWEN {
+namespace SI30 {
+
+enum class eTable : uint8_t
+{
+  COIL = 0x01,
+  DISCRETE_INPUT = 0x02,
+  HOLDING = 0x03,
+  INPUT = 0x04
+};
+
+namespace detail {
+
+template <typename T, bool = std::is_enum_v<T>>
+struct RawType
+{
+  using type = T;
+};
+
+template <typename T>
+struct RawType<T, true>
+{
+  using type = std::underlying_type_t<T>;
+};
+
+} /// end namespace detail
+
+/**
+ * Register descriptor.
+ * @tparam Width count of 16 bit registers, 32 bit values are stored high word first.
+ * @tparam Min, Max valid range of the raw value.
+ */
+template <eTable Table, uint16_t Address, uint8_t Width, typename T, int64_t Min = 0, int64_t Max = 0xFFFF>
+struct Register
+{
+  static_assert((Width == 1) || (Width == 2), "Only 16 and 32 bit registers are supported");
+
+  using type = T;
+  using tRaw = typename detail::RawType<T>::type;
+
+  static constexpr eTable table = Table;
+  static constexpr uint16_t address = Address;
+  static constexpr uint8_t width = Width;
+  static constexpr bool isSigned = std::is_signed_v<tRaw>;
+  static constexpr int64_t min = Min;
+  static constexpr int64_t max = Max;
+
+  static constexpr auto Decode(uint16_t const* registers) -> T
+  {
+    if constexpr (Width == 2)
+    {
+      return static_cast<T>(static_cast<tRaw>((static_cast<uint32_t>(registers[0]) << 16) | registers[1]));
+    }
+    else
+    {
+      return static_cast<T>(static_cast<tRaw>(registers[0]));
+    }
+  }
+
+  static constexpr void Encode(T value, uint16_t* registers)
+  {
+    auto const raw = static_cast<uint32_t>(static_cast<tRaw>(value));
+    if constexpr (Width == 2)
+    {
+      registers[0] = static_cast<uint16_t>(raw >> 16);
+      registers[1] = static_cast<uint16_t>(raw & 0xFFFF);
+    }
+    else
+    {
+      registers[0] = static_cast<uint16_t>(raw & 0xFFFF);
+    }
+  }
+
+  static constexpr bool IsValid(T value)
+  {
+    auto const raw = static_cast<int64_t>(static_cast<tRaw>(value));
+    return (raw >= Min) && (raw <= Max);
+  }
+};
+
+using CO = ImpulseCounter30::CommunicationOptions;
+using CNO = ImpulseCounter30::CounterOptions;
+
+/// Holding registers: communication options
+using BaudRate = Register<eTable::HOLDING, 0x0000, 1, CO::eBaudrate, 0, 8>;
+using DataBits = Register<eTable::HOLDING, 0x0001, 1, bool, 0, 1>;
+using Parity = Register<eTable::HOLDING, 0x0002, 1, CO::eParity, 0, 2>;
+using StopBits = Register<eTable::HOLDING, 0x0003, 1, bool, 0, 1>;
+using LengthAddr = Register<eTable::HOLDING, 0x0004, 1, bool, 0, 1>;
+using BaseAddr = Register<eTable::HOLDING, 0x0005, 1, uint16_t, 1, 2047>;
+using DelayAnswer = Register<eTable::HOLDING, 0x0006, 1, uint8_t, 0, 45>;
+
+/// Holding registers: counter options
+using DecPoint = Register<eTable::HOLDING, 0x0007, 1, CNO::eDecPoint, 0, 4>;
+using InputMode = Register<eTable::HOLDING, 0x0008, 1, CNO::eInputMode, 0, 5>;
+using OutputMode = Register<eTable::HOLDING, 0x0009, 1, CNO::eOutputMode, 0, 3>;
+using PointMode = Register<eTable::HOLDING, 0x000A, 1, CNO::ePointMode, 0, 2>;
+using ResetType = Register<eTable::HOLDING, 0x000B, 1, CNO::eResetType, 0, 3>;
+using SetPoint1 = Register<eTable::HOLDING, 0x000C, 2, int32_t, -99999, 999999>;
+using SetPoint2 = Register<eTable::HOLDING, 0x000E, 2, int32_t, -99999, 999999>;
+using TimeOUT1 = Register<eTable::HOLDING, 0x0010, 2, uint32_t, 0, 999990>;
+using TimeOUT2 = Register<eTable::HOLDING, 0x0012, 2, uint32_t, 0, 999990>;
+using DecPointMult = Register<eTable::HOLDING, 0x0014, 1, uint8_t, 0, 5>;
+using Multiplexer = Register<eTable::HOLDING, 0x0015, 2, uint32_t, 1, 999999>;
+using MaxFreq = Register<eTable::HOLDING, 0x0017, 1, uint16_t, 1, 50000>;
+using MinControl = Register<eTable::HOLDING, 0x0018, 2, uint32_t, 1, 999999>;
+using LockKBD = Register<eTable::HOLDING, 0x001A, 1, CNO::eLockKBD, 0, 3>;
+using ShowSetPoint = Register<eTable::HOLDING, 0x001B, 1, CNO::eShowSetPoint, 0, 1>;
+using Brightness = Register<eTable::HOLDING, 0x001C, 1, uint8_t, 1, 3>;
+using InputType = Register<eTable::HOLDING, 0x001D, 1, CNO::eInputType, 0, 1>;
+using Password = Register<eTable::HOLDING, 0x001E, 1, uint16_t, 0, 9999>;
+
+/// Input registers
+using CounterValue = Register<eTable::INPUT, 0x0000, 2, int32_t, INT32_MIN, INT32_MAX>;
+using CounterEU = Register<eTable::INPUT, 0x0002, 2, int32_t, INT32_MIN, INT32_MAX>;
+using StartStopMode = Register<eTable::INPUT, 0x0004, 1, bool, 0, 1>;
+using CurrentMode = Register<eTable::INPUT, 0x0005, 1, ImpulseCounter30::eCurrentMode, 0, 3>;
+using CodeErrNet = Register<eTable::INPUT, 0x0006, 1, uint8_t, 0, 0xFF>;
+using NameDevice = Register<eTable::INPUT, 0x0007, 2, uint32_t, 0, UINT32_MAX>;
+using Version = Register<eTable::INPUT, 0x0009, 2, uint32_t, 0, UINT32_MAX>;
+
+/// Coils
+using OutState1 = Register<eTable::COIL, 0x0000, 1, bool, 0, 1>;
+using OutState2 = Register<eTable::COIL, 0x0001, 1, bool, 0, 1>;
+using ResetCount = Register<eTable::COIL, 0x0002, 1, bool, 0, 1>;
+using ControlFromProgram = Register<eTable::COIL, 0x0003, 1, bool, 0, 1>;
+using StartCounter = Register<eTable::COIL, 0x0004, 1, bool, 0, 1>;
+
+/// Discrete inputs
+using ResetInput = Register<eTable::DISCRETE_INPUT, 0x0000, 1, bool, 0, 1>;
+using LockInput = Register<eTable::DISCRETE_INPUT, 0x0001, 1, bool, 0, 1>;
+
+/**
+ * Device quirk: reads across these addresses are not answered reliably, so no read frame crosses them. Communication
+ * and counter options are read by 7, 13 and 11 registers, CounterEU by single registers.
+ */
+constexpr std::array<uint16_t, 2> HOLDING_READ_SPLITS{DecPoint::address, DecPoint::address + 13};
+constexpr std::array<uint16_t, 3> INPUT_READ_SPLITS{CounterEU::address, CounterEU::address + 1, CounterEU::address + 2};
+
+namespace detail {
+
+/// Reading up to this count of unused registers is cheaper than a new frame (8 + 5 bytes of overhead and 2 * 3.5 silence)
+constexpr uint16_t MAX_READ_GAP = 8;
+constexpr uint16_t MAX_SPAN = 125;
+
+struct Span
+{
+  uint16_t address{};
+  uint16_t count{};
+};
+
+/// A span is cut at most by every read split of its table
+constexpr size_t MAX_READ_SPLITS = 3;
+static_assert((HOLDING_READ_SPLITS.size() <= MAX_READ_SPLITS) && (INPUT_READ_SPLITS.size() <= MAX_READ_SPLITS));
+
+/**
+ * Read frames of one span.
+ */
+struct Frames
+{
+  std::array<Span, MAX_READ_SPLITS + 1> frames{};
+  size_t frameCount{};
+
+  constexpr auto cbegin() const
+  {
+    return frames.cbegin();
+  }
+
+  constexpr auto cend() const
+  {
+    return frames.cbegin() + frameCount;
+  }
+};
+
+template <size_t N>
+struct Plan
+{
+  std::array<Span, N> spans{};
+  size_t spanCount{};
+  std::array<size_t, N> spanOf{};
+  std::array<uint16_t, N> offsetOf{};
+  /// Read plans only: frames the spans are read by (a split cuts one span at most), in order of spans
+  std::array<Span, N + MAX_READ_SPLITS> frames{};
+  size_t frameCount{};
+  std::array<size_t, N + MAX_READ_SPLITS> spanOfFrame{};
+};
+
+template <size_t N>
+constexpr auto MakePlan(std::array<uint16_t, N> const& addresses,
+                        std::array<uint8_t, N> const& widths,
+                        uint16_t maxGap) -> Plan<N>
+{
+  std::array<size_t, N> order{};
+  for (size_t i = 0; i < N; ++i)
+  {
+    order[i] = i;
+  }
+  for (size_t i = 1; i < N; ++i)
+  {
+    for (size_t j = i; (j > 0) && (addresses[order[j]] < addresses[order[j - 1]]); --j)
+    {
+      auto const tmp = order[j];
+      order[j] = order[j - 1];
+      order[j - 1] = tmp;
+    }
+  }
+  Plan<N> plan{};
+  for (size_t k = 0; k < N; ++k)
+  {
+    auto const i = order[k];
+    auto const end = static_cast<uint32_t>(addresses[i]) + widths[i];
+    if (plan.spanCount != 0)
+    {
+      auto& span = plan.spans[plan.spanCount - 1];
+      auto const spanEnd = static_cast<uint32_t>(span.address) + span.count;
+      auto const mergedEnd = (end > spanEnd) ? end : spanEnd;
+      if ((addresses[i] <= (spanEnd + maxGap)) && ((mergedEnd - span.address) <= MAX_SPAN))
+      {
+        span.count = static_cast<uint16_t>(mergedEnd - span.address);
+        plan.spanOf[i] = plan.spanCount - 1;
+        plan.offsetOf[i] = static_cast<uint16_t>(addresses[i] - span.address);
+        continue;
+      }
+    }
+    plan.spans[plan.spanCount] = Span{addresses[i], widths[i]};
+    plan.spanOf[i] = plan.spanCount;
+    plan.offsetOf[i] = 0;
+    ++plan.spanCount;
+  }
+  return plan;
+}
+
+/**
+ * Read frames of the span, it is split at the read splits of its table.
+ */
+constexpr auto SplitSpan(eTable table, Span const& span) -> Frames
+{
+  Frames frames{};
+  frames.frames[0] = span;
+  frames.frameCount = 1;
+  auto const split = [&frames](auto const& splits) {
+    for (auto const address : splits)
+    {
+      auto& last = frames.frames[frames.frameCount - 1];
+      if ((address > last.address) && (address < (static_cast<uint32_t>(last.address) + last.count)))
+      {
+        auto const count = static_cast<uint16_t>(address - last.address);
+        frames.frames[frames.frameCount] = Span{address, static_cast<uint16_t>(last.count - count)};
+        last.count = count;
+        ++frames.frameCount;
+      }
+    }
+  };
+  if (table == eTable::HOLDING)
+  {
+    split(HOLDING_READ_SPLITS);
+  }
+  else if (table == eTable::INPUT)
+  {
+    split(INPUT_READ_SPLITS);
+  }
+  return frames;
+}
+
+/**
+ * Read plan: spans as MakePlan() merges them and the frames the device answers, so reads are not split at run time.
+ */
+template <size_t N>
+constexpr auto MakeReadPlan(eTable table,
+                            std::array<uint16_t, N> const& addresses,
+                            std::array<uint8_t, N> const& widths) -> Plan<N>
+{
+  auto plan = MakePlan<N>(addresses, widths, MAX_READ_GAP);
+  for (size_t i = 0; i < plan.spanCount; ++i)
+  {
+    auto const frames = SplitSpan(table, plan.spans[i]);
+    for (auto frame = frames.cbegin(); frame != frames.cend(); ++frame)
+    {
+      plan.frames[plan.frameCount] = *frame;
+      plan.spanOfFrame[plan.frameCount] = i;
+      ++plan.frameCount;
+    }
+  }
+  return plan;
+}
+
+inline auto ReadFrame(ModBus& modBus, eTable table, Span const& span, uint16_t timeoutMs) -> std::vector<uint16_t>
+{
+  switch (table)
+  {
+    case eTable::COIL:
+    case eTable::DISCRETE_INPUT:
+    {
+      auto const bits = (table == eTable::COIL)
+                        ? modBus.ReadCoilStatus(span.address, span.count, timeoutMs)
+                        : modBus.ReadInputStatus(span.address, span.count, timeoutMs);
+      return std::vector<uint16_t>(bits.cbegin(), bits.cend());
+    }
+    case eTable::HOLDING:
+      return modBus.ReadHoldingRegisters(span.address, span.count, timeoutMs);
+    case eTable::INPUT:
+      return modBus.ReadInputRegisters(span.address, span.count, timeoutMs);
+  }
+  return {};
+}
+
+#if defined(OWEN_COROUTINES)
+inline auto ReadFrameAsync(ModBus& modBus, eTable table, Span span, uint16_t timeoutMs) -> Task<std::vector<uint16_t>>
+{
+  switch (table)
+  {
+    case eTable::COIL:
+    case eTable::DISCRETE_INPUT:
+    {
+      auto const bits = (table == eTable::COIL)
+                        ? co_await modBus.ReadCoilStatusAsync(span.address, span.count, timeoutMs)
+                        : co_await modBus.ReadInputStatusAsync(span.address, span.count, timeoutMs);
+      co_return std::vector<uint16_t>(bits.cbegin(), bits.cend());
+    }
+    case eTable::HOLDING:
+      co_return co_await modBus.ReadHoldingRegistersAsync(span.address, span.count, timeoutMs);
+    case eTable::INPUT:
+      co_return co_await modBus.ReadInputRegistersAsync(span.address, span.count, timeoutMs);
+  }
+  co_return std::vector<uint16_t>{};
+}
+
+inline auto WriteSpanAsync(ModBus& modBus, eTable table, Span span, std::vector<uint16_t> values, uint16_t timeoutMs) -> Task<bool>
+{
+  if (table == eTable::COIL)
+  {
+    bool result{true};
+    for (uint16_t i = 0; i < span.count; ++i)
+    {
+      result &= co_await modBus.ForceSingleCoilAsync(span.address + i, values[i] != 0, timeoutMs);
+    }
+    co_return result;
+  }
+  co_return (span.count == 1)
+            ? co_await modBus.WriteSingleHoldingRegisterAsync(span.address, values[0], timeoutMs)
+            : co_await modBus.WriteMultipleHoldingRegisterAsync(span.address, std::move(values), timeoutMs);
+}
+#endif
+
+inline bool WriteSpan(ModBus& modBus, eTable table, Span const& span, uint16_t const* values, uint16_t timeoutMs)
+{
+  if (table == eTable::COIL)
+  {
+    bool result{true};
+    for (uint16_t i = 0; i < span.count; ++i)
+    {
+      result &= modBus.ForceSingleCoil(span.address + i, values[i] != 0, timeoutMs);
+    }
+    return result;
+  }
+  return (span.count == 1)
+         ? modBus.WriteSingleHoldingRegister(span.address, values[0], timeoutMs)
+         : modBus.WriteMultipleHoldingRegister(span.address, std::vector<uint16_t>(values, values + span.count), timeoutMs);
+}
+
+/**
+ * Compile time layout of a set of registers from the same table: read spans (small gaps are read through),
+ * write spans (only exactly contiguous registers) and position of every register inside its span.
+ */
+template <typename First, typename... Rest>
+struct Fields
+{
+  static_assert(((Rest::table == First::table) && ...), "All registers should belong to the same table");
+
+  static constexpr eTable table = First::table;
+  static constexpr size_t N = 1 + sizeof...(Rest);
+  static constexpr std::array<uint16_t, N> addresses{First::address, Rest::address...};
+  static constexpr std::array<uint8_t, N> widths{First::width, Rest::width...};
+  static constexpr auto readPlan = MakeReadPlan<N>(table, addresses, widths);
+  static constexpr auto writePlan = MakePlan<N>(addresses, widths, 0);
+
+  using tValues = std::tuple<typename First::type, typename Rest::type...>;
+
+  template <size_t... I>
+  static auto Decode(std::array<std::vector<uint16_t>, readPlan.spanCount> const& data, std::index_sequence<I...>) -> tValues
+  {
+    using tRegisters = std::tuple<First, Rest...>;
+    return tValues{std::tuple_element_t<I, tRegisters>::Decode(data[readPlan.spanOf[I]].data() + readPlan.offsetOf[I])...};
+  }
+
+  template <size_t... I>
+  static void Encode(tValues const& values, std::array<std::array<uint16_t, 2 * N>, writePlan.spanCount>& data, std::index_sequence<I...>)
+  {
+    using tRegisters = std::tuple<First, Rest...>;
+    (std::tuple_element_t<I, tRegisters>::Encode(std::get<I>(values), data[writePlan.spanOf[I]].data() + writePlan.offsetOf[I]), ...);
+  }
+
+  template <size_t... I>
+  static bool IsValid(tValues const& values, std::index_sequence<I...>)
+  {
+    using tRegisters = std::tuple<First, Rest...>;
+    return (std::tuple_element_t<I, tRegisters>::IsValid(std::get<I>(values)) && ...);
+  }
+};
+
+} /// end namespace detail
+
+/**
+ * Read registers with the minimal count of transactions calculated at compile time, split at the device read splits.
+ * @return values in order of template arguments or nullopt if any transaction failed.
+ */
+template <typename... Regs>
+auto Read(ModBus& modBus, uint16_t timeoutMs = 1000) -> std::optional<std::tuple<typename Regs::type...>>
+{
+  using tFields = detail::Fields<Regs...>;
+  constexpr auto const& plan = tFields::readPlan;
+  std::array<std::vector<uint16_t>, plan.spanCount> data;
+  for (size_t i = 0; i < plan.frameCount; ++i)
+  {
+    auto values = detail::ReadFrame(modBus, tFields::table, plan.frames[i], timeoutMs);
+    if (values.size() != plan.frames[i].count)
+    {
+      return {};
+    }
+    auto& span = data[plan.spanOfFrame[i]];
+    if (span.empty())
+    {
+      span = std::move(values);
+    }
+    else
+    {
+      span.insert(span.end(), values.cbegin(), values.cend());
+    }
+  }
+  return tFields::Decode(data, std::index_sequence_for<Regs...>{});
+}
+
+/**
+ * Write registers, contiguous registers are written by one transaction.
+ * Throws std::runtime_error if any value is out of its register range.
+ * @return true if all transactions succeeded.
+ */
+template <typename... Regs>
+bool Write(ModBus& modBus, std::tuple<typename Regs::type...> const& values, uint16_t timeoutMs = 1000)
+{
+  using tFields = detail::Fields<Regs...>;
+  static_assert((tFields::table == eTable::HOLDING) || (tFields::table == eTable::COIL), "Only holding registers and coils are writable");
+  constexpr auto const& plan = tFields::writePlan;
+  if (!tFields::IsValid(values, std::index_sequence_for<Regs...>{}))
+  {
+    throw std::runtime_error("Value is out of register range.");
+  }
+  std::array<std::array<uint16_t, 2 * tFields::N>, plan.spanCount> data{};
+  tFields::Encode(values, data, std::index_sequence_for<Regs...>{});
+  bool result{true};
+  for (size_t i = 0; i < plan.spanCount; ++i)
+  {
+    result &= detail::WriteSpan(modBus, tFields::table, plan.spans[i], data[i].data(), timeoutMs);
+  }
+  return result;
+}
+
+/**
+ * Read single register.
+ */
+template <typename Reg>
+auto ReadValue(ModBus& modBus, uint16_t timeoutMs = 1000) -> std::optional<typename Reg::type>
+{
+  auto const values = Read<Reg>(modBus, timeoutMs);
+  return values.has_value() ? std::optional<typename Reg::type>{std::get<0>(values.value())} : std::nullopt;
+}
+
+/**
+ * Write single register.
+ */
+template <typename Reg>
+bool WriteValue(ModBus& modBus, typename Reg::type value, uint16_t timeoutMs = 1000)
+{
+  return Write<Reg>(modBus, std::tuple<typename Reg::type>{value}, timeoutMs);
+}
+
+#if defined(OWEN_COROUTINES)
+/**
+ * Awaitable versions of the functions above.
+ */
+template <typename... Regs>
+auto ReadAsync(ModBus& modBus, uint16_t timeoutMs = 1000) -> Task<std::optional<std::tuple<typename Regs::type...>>>
+{
+  using tFields = detail::Fields<Regs...>;
+  constexpr auto const& plan = tFields::readPlan;
+  std::array<std::vector<uint16_t>, plan.spanCount> data;
+  for (size_t i = 0; i < plan.frameCount; ++i)
+  {
+    auto values = co_await detail::ReadFrameAsync(modBus, tFields::table, plan.frames[i], timeoutMs);
+    if (values.size() != plan.frames[i].count)
+    {
+      co_return std::nullopt;
+    }
+    auto& span = data[plan.spanOfFrame[i]];
+    if (span.empty())
+    {
+      span = std::move(values);
+    }
+    else
+    {
+      span.insert(span.end(), values.cbegin(), values.cend());
+    }
+  }
+  co_return tFields::Decode(data, std::index_sequence_for<Regs...>{});
+}
+
+template <typename... Regs>
+auto WriteAsync(ModBus& modBus, std::tuple<typename Regs::type...> values, uint16_t timeoutMs = 1000) -> Task<bool>
+{
+  using tFields = detail::Fields<Regs...>;
+  static_assert((tFields::table == eTable::HOLDING) || (tFields::table == eTable::COIL), "Only holding registers and coils are writable");
+  constexpr auto const& plan = tFields::writePlan;
+  if (!tFields::IsValid(values, std::index_sequence_for<Regs...>{}))
+  {
+    throw std::runtime_error("Value is out of register range.");
+  }
+  std::array<std::array<uint16_t, 2 * tFields::N>, plan.spanCount> data{};
+  tFields::Encode(values, data, std::index_sequence_for<Regs...>{});
+  bool result{true};
+  for (size_t i = 0; i < plan.spanCount; ++i)
+  {
+    std::vector<uint16_t> span(data[i].cbegin(), std::next(data[i].cbegin(), plan.spans[i].count));
+    result &= co_await detail::WriteSpanAsync(modBus, tFields::table, plan.spans[i], std::move(span), timeoutMs);
+  }
+  co_return result;
+}
+
+template <typename Reg>
+auto ReadValueAsync(ModBus& modBus, uint16_t timeoutMs = 1000) -> Task<std::optional<typename Reg::type>>
+{
+  auto const values = co_await ReadAsync<Reg>(modBus, timeoutMs);
+  co_return values.has_value() ? std::optional<typename Reg::type>{std::get<0>(values.value())} : std::nullopt;
+}
+
+template <typename Reg>
+auto WriteValueAsync(ModBus& modBus, typename Reg::type value, uint16_t timeoutMs = 1000) -> Task<bool>
+{
+  co_return co_await WriteAsync<Reg>(modBus, std::tuple<typename Reg::type>{value}, timeoutMs);
+}
+#endif
+
+} /// end namespace SI30
+} /// end namespace OWEN
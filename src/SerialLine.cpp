@@ -0,0 +1,127 @@
+#include "SerialLine.hpp"
+
+#include <boost/asio/error.hpp>
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * Open the device for reading only and make it raw as serial_port::open() does, which always opens for reading and
+ * writing.
+ */
+void OpenReadOnly(boost::asio::serial_port& port, std::string const& portPath)
+{
+  auto const fd = ::open(portPath.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0)
+  {
+    throw boost::system::system_error(errno, boost::system::system_category(), portPath);
+  }
+  termios ios{};
+  if (::tcgetattr(fd, &ios) != 0)
+  {
+    auto const error = errno;
+    ::close(fd);
+    throw boost::system::system_error(error, boost::system::system_category(), portPath);
+  }
+  ::cfmakeraw(&ios);
+  ios.c_cflag |= CREAD | CLOCAL;
+  ::tcsetattr(fd, TCSANOW, &ios);
+  boost::system::error_code error;
+  port.assign(fd, error);
+  if (error)
+  {
+    ::close(fd);
+    throw boost::system::system_error(error, portPath);
+  }
+}
+
+} /// end namespace anonymous
+
+void SerialLineSettings::Open(boost::asio::serial_port& port, std::string const& portPath) const
+{
+  using namespace boost::asio;
+  if (isReadOnly)
+  {
+    OpenReadOnly(port, portPath);
+  }
+  else
+  {
+    port.open(portPath);
+  }
+  port.set_option(serial_port_base::baud_rate(baudrate));
+  port.set_option(serial_port_base::stop_bits(stopBits));
+  port.set_option(serial_port_base::parity(parity));
+  port.set_option(serial_port_base::character_size(characterSize));
+}
+
+bool SerialReconnect::IsPortLost(boost::system::error_code const& error)
+{
+  return error && (error != boost::asio::error::operation_aborted);
+}
+
+void SerialReconnect::Lost(boost::asio::serial_port& port)
+{
+  if (_lost)
+  {
+    return;
+  }
+  boost::system::error_code ignored;
+  port.close(ignored);
+  _lost = true;
+  _timeouts = 0;
+  _silent.reset();
+  _backoff = {};
+  _nextAttempt = std::chrono::steady_clock::now();
+}
+
+void SerialReconnect::Exchanged(boost::asio::serial_port& port, std::string const& request, bool isTimeout)
+{
+  auto const address = request.empty() ? 0 : static_cast<uint8_t>(request.front());
+  if (!isTimeout)
+  {
+    _answering.set(address);
+    _silent.reset();
+    _timeouts = 0;
+    return;
+  }
+  if (_answering.test(address))
+  {
+    _silent.set(address);
+  }
+  if ((++_timeouts >= TIMEOUTS_TO_REOPEN) && (_silent == _answering))
+  {
+    Lost(port);
+  }
+}
+
+bool SerialReconnect::Reopen(boost::asio::serial_port& port, std::string const& portPath, SerialLineSettings const& settings)
+{
+  if (!_lost)
+  {
+    return true;
+  }
+  auto const now = std::chrono::steady_clock::now();
+  if (now < _nextAttempt)
+  {
+    return false;
+  }
+  try
+  {
+    settings.Open(port, portPath);
+  }
+  catch (boost::system::system_error const&)
+  {
+    boost::system::error_code ignored;
+    port.close(ignored);
+    _backoff = std::clamp<std::chrono::steady_clock::duration>(_backoff * 2, MIN_BACKOFF, MAX_BACKOFF);
+    _nextAttempt = now + _backoff;
+    return false;
+  }
+  _lost = false;
+  return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <boost/asio/serial_port.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <bitset>
+#include <chrono>
+#include <string>
+
+/**
+ * Line settings of a serial port, kept to configure the port again when it is reopened.
+ */
+struct SerialLineSettings
+{
+  using eParity = boost::asio::serial_port_base::parity::type;
+  using eStopBits = boost::asio::serial_port_base::stop_bits::type;
+
+  uint32_t baudrate{};
+  eParity parity{eParity::none};
+  eStopBits stopBits{eStopBits::one};
+  uint8_t characterSize{8};
+  bool isReadOnly{};   ///< opened with O_RDONLY (listening to a bus), the port can not drive the line then
+
+  /**
+   * @throw boost::system::system_error if port could not be opened or configured.
+   */
+  void Open(boost::asio::serial_port& port, std::string const& portPath) const;
+};
+
+/**
+ * Reconnection of a serial port which was lost (USB adapter unplugged or re-enumerated): the port is reopened by
+ * its path when an exchange is requested, attempts which fail are repeated with bounded exponential backoff and
+ * exchanges fail at once in between, so callers are not blocked while the port is away.
+ */
+class SerialReconnect
+{
+public:
+  static constexpr auto MIN_BACKOFF = std::chrono::milliseconds{100};
+  static constexpr auto MAX_BACKOFF = std::chrono::seconds{5};
+  /**
+   * Responses stop coming from a port which was re-enumerated under the same path without errors too. A silent slave
+   * does not make the port lost for the others on the bus: the timeouts in a row have to include every slave which
+   * has answered on the port.
+   */
+  static constexpr uint32_t TIMEOUTS_TO_REOPEN = 5;
+
+public:
+  /**
+   * True if the error of an exchange means that the port is gone (EIO, ENODEV, end of file...), a timeout or
+   * cancellation does not.
+   */
+  static bool IsPortLost(boost::system::error_code const& error);
+
+  bool IsLost() const
+  {
+    return _lost;
+  }
+
+  /**
+   * Close the port at once (an open descriptor of an unplugged USB adapter may make the system give it another name
+   * when it comes back), it is reopened before the next exchange.
+   */
+  void Lost(boost::asio::serial_port& port);
+
+  /**
+   * Count exchange result, enough consecutive timeouts of all answering slaves mean that the port is lost.
+   * @param request RTU frame of the exchange, its first byte is the slave address.
+   */
+  void Exchanged(boost::asio::serial_port& port, std::string const& request, bool isTimeout);
+
+  /**
+   * Reopen lost port if the attempt is due.
+   * @return true if port is open.
+   */
+  bool Reopen(boost::asio::serial_port& port, std::string const& portPath, SerialLineSettings const& settings);
+
+private:
+  bool _lost{};
+  uint32_t _timeouts{};
+  std::bitset<256> _answering;   ///< slaves which answered on the port
+  std::bitset<256> _silent;      ///< answering slaves which timed out since the last response
+  std::chrono::steady_clock::duration _backoff{};
+  std::chrono::steady_clock::time_point _nextAttempt;
+};
@@ -1,52 +1,139 @@
 #include "SerialPort.hpp"
 
-#include <iostream>
+#include <boost/asio/write.hpp>
+
+#include <array>
 #include <string>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <termios.h>
+#endif
+
 SerialPort::SerialPort(std::string const& portPath,
                        uint32_t baudrate,
                        eParity parity,
                        eStopBits stopBits,
                        uint8_t characterSize)
-  : _io{}
+  : _portPath{portPath}
+  , _settings{baudrate, parity, stopBits, characterSize}
+  , _io{}
   , _port{_io}
   , _timer{_io}
 {
-   using namespace boost::asio;
-  _port.open(portPath);
-  _port.set_option(serial_port_base::baud_rate(baudrate));
-  _port.set_option(serial_port_base::stop_bits(stopBits));
-  _port.set_option(serial_port_base::parity(parity));
-  _port.set_option(serial_port_base::character_size(characterSize));
+  _settings.Open(_port, portPath);
 }
 
-void SerialPort::SendCommand(std::string const& data, SerialPort::tResponseCallback&& response, size_t timeoutResponseMs)
+void SerialPort::SendCommand(std::string const& data,
+                             SerialPort::tResponseCallback&& response,
+                             size_t timeoutResponseMs,
+                             tResponseComplete const& isComplete)
 {
+  if (!_reconnect.Reopen(_port, _portPath, _settings))
+  {
+    response({}, true);
+    return;
+  }
   boost::system::error_code errorCode;
   bool readError{true};
-  std::string responseData(256, '\0');
-  _port.async_read_some(boost::asio::buffer(responseData.data(), responseData.size()), [&](boost::system::error_code const& error, size_t bytes_transferred) {
-    readError = (error || (bytes_transferred == 0));
+  bool portLost{};
+  std::string responseData;
+  std::array<char, 256> chunk{};
+  // Bytes of a reply which came after previous timeout would be taken as the beginning of this reply
+#if defined(_WIN32)
+  ::PurgeComm(_port.native_handle(), PURGE_RXCLEAR);
+#else
+  ::tcflush(_port.native_handle(), TCIFLUSH);
+#endif
+  std::function<void(boost::system::error_code const&, size_t)> onRead = [&](boost::system::error_code const& error, size_t bytes_transferred) {
+    if (error || (bytes_transferred == 0))
+    {
+      portLost = SerialReconnect::IsPortLost(error);
+      _timer.cancel();
+      return;
+    }
+    responseData.append(chunk.data(), bytes_transferred);
+    if (_capture)
+    {
+      _capture->Chunk(chunk.data(), bytes_transferred);
+    }
+    if (isComplete && !isComplete(responseData))
+    {
+      _port.async_read_some(boost::asio::buffer(chunk), onRead);
+      return;
+    }
+    readError = false;
     _timer.cancel();
-    responseData.resize(bytes_transferred);
-  });
+  };
+  _port.async_read_some(boost::asio::buffer(chunk), onRead);
   _timer.expires_from_now(boost::posix_time::milliseconds(timeoutResponseMs));
   _timer.async_wait([&](const boost::system::error_code& error) {
-    if (error)
+    if (!error)
     {
-      std::cout << error.message() << std::endl;
-      return;
+      _port.cancel();
     }
-    _port.cancel();
   });
+  if (_capture)
+  {
+    _capture->Request(data.data(), data.size());
+  }
   auto bytesTranfered = _port.write_some(boost::asio::buffer(data), errorCode);
   if (errorCode || (bytesTranfered != data.size()))
   {
+    _port.cancel();
+    _timer.cancel();
+    _io.run();
     _io.reset();
+    _reconnect.Lost(_port);
+    if (_capture)
+    {
+      _capture->End(false);
+    }
     response({}, true);
     return;
   }
   _io.run();
+  if (portLost)
+  {
+    _reconnect.Lost(_port);
+  }
+  else
+  {
+    _reconnect.Exchanged(_port, data, readError);
+  }
+  if (_capture)
+  {
+    _capture->End(!readError);
+  }
   response(responseData, readError);
   _io.reset();
 }
+
+bool SerialPort::Send(std::string const& data)
+{
+  if (!_reconnect.Reopen(_port, _portPath, _settings))
+  {
+    return false;
+  }
+  boost::system::error_code errorCode;
+  if (_capture)
+  {
+    _capture->Request(data.data(), data.size());
+  }
+  auto bytesTranfered = boost::asio::write(_port, boost::asio::buffer(data), errorCode);
+  if (_capture)
+  {
+    _capture->End(true);
+  }
+  if (errorCode)
+  {
+    _reconnect.Lost(_port);
+  }
+  return !errorCode && (bytesTranfered == data.size());
+}
+
+void SerialPort::Capture(std::string const& capturePath)
+{
+  _capture = std::make_unique<CaptureWriter>(capturePath, _portPath);
+}
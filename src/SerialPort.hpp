@@ -1,17 +1,29 @@
 #pragma once
 
+#include "CaptureWriter.hpp"
+#include "SerialLine.hpp"
+#include "Transport.hpp"
+
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/serial_port.hpp>
 #include <boost/asio/deadline_timer.hpp>
 
-class SerialPort
+#include <memory>
+
+/**
+ * Modbus RTU over a serial port. A lost port is reopened with the same line settings (see SerialReconnect), users of
+ * the transport keep their state and only see failed exchanges while it is away.
+ */
+class SerialPort : public Transport
 {
 public:
-  using tResponseCallback = std::function<void(std::string const&, bool error)>;
-  using eParity = boost::asio::serial_port_base::parity::type;
-  using eStopBits = boost::asio::serial_port_base::stop_bits::type;
+  using eParity = SerialLineSettings::eParity;
+  using eStopBits = SerialLineSettings::eStopBits;
 
 public:
+  /**
+   * @throw boost::system::system_error if port could not be opened or configured.
+   */
   SerialPort(std::string const& portPath,
              uint32_t baudrate,
              eParity parity = eParity::none,
@@ -29,10 +41,24 @@ public:
 
   void SendCommand(std::string const& data,
                    tResponseCallback && response = [](std::string const&, bool error){},
-                   size_t timeoutResponseMs = 0);
+                   size_t timeoutResponseMs = 0,
+                   tResponseComplete const& isComplete = {}) override;
+
+  bool Send(std::string const& data) override;
+
+  auto Path() const -> std::string const& override
+  {
+    return _portPath;
+  }
+
+  void Capture(std::string const& capturePath) override;
 
 private:
+  std::string _portPath;
+  SerialLineSettings _settings;
+  SerialReconnect _reconnect;
   boost::asio::io_service _io;
   boost::asio::serial_port _port;
   boost::asio::deadline_timer _timer;
+  std::unique_ptr<CaptureWriter> _capture;
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "SharedTransport.hpp"
+
+#include "TransportFactory.hpp"
+
+#include <map>
+
+namespace OWEN {
+
+auto SharedTransport::Acquire(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<SharedTransport>
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<Port>> ports;
+  std::lock_guard<std::mutex> lock{mutex};
+  auto port = ports[communicationOptions._portPath].lock();
+  if (!port)
+  {
+    port = std::make_shared<Port>();
+    port->transport = CreateTransport(communicationOptions);
+    ports[communicationOptions._portPath] = port;
+  }
+  return std::unique_ptr<SharedTransport>{new SharedTransport{std::move(port)}};
+}
+
+SharedTransport::SharedTransport(std::shared_ptr<Port> port)
+  : _port{std::move(port)}
+{
+}
+
+void SharedTransport::SendCommand(std::string const& data,
+                                  tResponseCallback&& response,
+                                  size_t timeoutResponseMs,
+                                  tResponseComplete const& isComplete)
+{
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  _port->transport->SendCommand(data, std::move(response), timeoutResponseMs, isComplete);
+}
+
+void SharedTransport::SendCommands(std::vector<std::string> const& requests,
+                                   tIndexedResponseCallback const& response,
+                                   size_t timeoutResponseMs,
+                                   std::vector<tResponseComplete> const& isComplete)
+{
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  _port->transport->SendCommands(requests, response, timeoutResponseMs, isComplete);
+}
+
+bool SharedTransport::Send(std::string const& data)
+{
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  return _port->transport->Send(data);
+}
+
+bool SharedTransport::IsAsync() const
+{
+  return _port->transport->IsAsync();
+}
+
+void SharedTransport::AsyncSendCommand(std::string const& data,
+                                       tResponseCallback done,
+                                       size_t timeoutResponseMs,
+                                       tResponseComplete isComplete)
+{
+  if (_port->transport->IsAsync())
+  {
+    _port->transport->AsyncSendCommand(data, std::move(done), timeoutResponseMs, std::move(isComplete));
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  _port->transport->AsyncSendCommand(data, std::move(done), timeoutResponseMs, std::move(isComplete));
+}
+
+void SharedTransport::AsyncSend(std::string const& data, std::function<void(bool sent)> done)
+{
+  if (_port->transport->IsAsync())
+  {
+    _port->transport->AsyncSend(data, std::move(done));
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  _port->transport->AsyncSend(data, std::move(done));
+}
+
+auto SharedTransport::Path() const -> std::string const&
+{
+  return _port->transport->Path();
+}
+
+void SharedTransport::Capture(std::string const& capturePath)
+{
+  std::lock_guard<std::recursive_mutex> lock{_port->mutex};
+  _port->transport->Capture(capturePath);
+}
+
+} /// end namespace OWEN
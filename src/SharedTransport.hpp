@@ -0,0 +1,68 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include "Transport.hpp"
+
+#include <memory>
+#include <mutex>
+
+namespace OWEN {
+
+/**
+ * Lease of the transport of a port path, all counters of the same port share one open port. Exchanges of all leases
+ * are serialized by the port mutex, so counters of one bus can be used from different threads without interleaving
+ * their frames. The port is closed with the last lease.
+ */
+class SharedTransport : public Transport
+{
+public:
+  /**
+   * Lease the open transport of the port path or open it with these options (later options of the same port
+   * path are not applied).
+   * @throw see CreateTransport.
+   */
+  static auto Acquire(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<SharedTransport>;
+
+  void SendCommand(std::string const& data,
+                   tResponseCallback && response = [](std::string const&, bool error){},
+                   size_t timeoutResponseMs = 0,
+                   tResponseComplete const& isComplete = {}) override;
+
+  void SendCommands(std::vector<std::string> const& requests,
+                    tIndexedResponseCallback const& response,
+                    size_t timeoutResponseMs,
+                    std::vector<tResponseComplete> const& isComplete) override;
+
+  bool Send(std::string const& data) override;
+
+  bool IsAsync() const override;
+
+  /**
+   * Asynchronous transports queue exchanges themselves, synchronous ones complete under the port mutex.
+   */
+  void AsyncSendCommand(std::string const& data,
+                        tResponseCallback done,
+                        size_t timeoutResponseMs,
+                        tResponseComplete isComplete) override;
+
+  void AsyncSend(std::string const& data, std::function<void(bool sent)> done) override;
+
+  auto Path() const -> std::string const& override;
+
+  void Capture(std::string const& capturePath) override;
+
+private:
+  struct Port
+  {
+    std::unique_ptr<Transport> transport;
+    std::recursive_mutex mutex;   ///< recursive as callbacks of an exchange may start another one
+  };
+
+  explicit SharedTransport(std::shared_ptr<Port> port);
+
+private:
+  std::shared_ptr<Port> _port;
+};
+
+} /// end namespace OWEN
@@ -0,0 +1,61 @@
+#include "SnapshotPublisher.hpp"
+
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace OWEN {
+
+auto SnapshotPublisher::Open(std::string const& name) -> std::shared_ptr<SnapshotPublisher>
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<SnapshotPublisher>> publishers;
+  std::lock_guard<std::mutex> lock{mutex};
+  auto publisher = publishers[name].lock();
+  if (!publisher)
+  {
+    publisher = std::make_shared<SnapshotPublisher>(name);
+    publishers[name] = publisher;
+  }
+  return publisher;
+}
+
+SnapshotPublisher::SnapshotPublisher(std::string const& name)
+  : _name{name}
+{
+  // Readers of a previous segment keep it, new readers get the new one
+  ::shm_unlink(name.c_str());
+  auto const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Could not create shared memory " + name);
+  }
+  auto* memory = (::ftruncate(fd, sizeof(SnapshotShm::Segment)) == 0)
+                 ? ::mmap(nullptr, sizeof(SnapshotShm::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                 : MAP_FAILED;
+  ::close(fd);
+  if (memory == MAP_FAILED)
+  {
+    ::shm_unlink(name.c_str());
+    throw std::runtime_error("Could not map shared memory " + name);
+  }
+  // New object is zero filled: every sequence is 0 (never written)
+  _segment = new (memory) SnapshotShm::Segment;
+  _segment->version = SnapshotShm::VERSION;
+  _segment->slotCount = SnapshotShm::SLOT_COUNT;
+  _segment->magic.store(SnapshotShm::MAGIC, std::memory_order_release);
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+  ::munmap(_segment, sizeof(SnapshotShm::Segment));
+  ::shm_unlink(_name.c_str());
+}
+
+void SnapshotPublisher::Publish(uint8_t unit, SnapshotShm::Snapshot snapshot)
+{
+  snapshot.updates = ++_updates[unit];
+  SnapshotShm::Write(_segment->slots[unit], snapshot);
+}
+
+} /// end namespace OWEN
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <OWEN/SnapshotShm.hpp>
+
+#include <memory>
+#include <string>
+
+namespace OWEN {
+
+/**
+ * Writer side of the snapshot segment, see SnapshotShm. Segment is removed when the publisher is destroyed,
+ * readers which have mapped it keep their mapping.
+ */
+class SnapshotPublisher
+{
+public:
+  /**
+   * Publisher of the segment shared by all pollers of the process which publish to the same name
+   * (they poll different units, so they write different slots).
+   * @throw std::runtime_error if segment could not be created.
+   */
+  static auto Open(std::string const& name) -> std::shared_ptr<SnapshotPublisher>;
+
+  /**
+   * Create (or recreate) the segment.
+   * @throw std::runtime_error if segment could not be created.
+   */
+  explicit SnapshotPublisher(std::string const& name);
+  ~SnapshotPublisher();
+
+  SnapshotPublisher(SnapshotPublisher const&) = delete;
+  SnapshotPublisher& operator=(SnapshotPublisher const&) = delete;
+
+  /**
+   * Publish snapshot of the unit, updates count is maintained by the publisher. Units can be published
+   * from different threads, a unit is published from one thread only.
+   */
+  void Publish(uint8_t unit, SnapshotShm::Snapshot snapshot);
+
+private:
+  std::string _name;
+  SnapshotShm::Segment* _segment{};
+  uint32_t _updates[SnapshotShm::SLOT_COUNT]{};
+};
+
+} /// end namespace OWEN
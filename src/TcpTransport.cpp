@@ -0,0 +1,297 @@
+#include "TcpTransport.hpp"
+
+#include "crc16.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <map>
+
+namespace {
+
+constexpr char const* MODBUS_TCP_SCHEME = "tcp://";
+constexpr char const* RTU_OVER_TCP_SCHEME = "rtutcp://";
+constexpr size_t MBAP_HEADER_SIZE = 7;   ///< transaction id, protocol id, length, unit id
+
+bool StartsWith(std::string const& value, std::string const& prefix)
+{
+  return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+auto Get16(std::string const& frame, size_t offset) -> uint16_t
+{
+  return static_cast<uint16_t>((static_cast<uint8_t>(frame[offset]) << 8) | static_cast<uint8_t>(frame[offset + 1]));
+}
+
+void Put16(std::string& frame, uint16_t value)
+{
+  frame += static_cast<char>(value >> 8);
+  frame += static_cast<char>(value & 0xFF);
+}
+
+/**
+ * MBAP frame (from unit id) to RTU frame, so responses are validated by the same codec as serial ones.
+ */
+auto ToRtu(std::string const& mbap) -> std::string
+{
+  auto rtu = mbap.substr(MBAP_HEADER_SIZE - 1);
+  auto const crc16 = Crc16(reinterpret_cast<uint8_t const*>(rtu.data()), static_cast<uint16_t>(rtu.size()));
+  Put16(rtu, crc16);
+  return rtu;
+}
+
+} /// end namespace anonymous
+
+TcpTransport::TcpTransport(std::string const& url)
+  : _url{url}
+  , _io{}
+  , _socket{_io}
+  , _timer{_io}
+{
+  using namespace boost::asio;
+  auto const isModbusTcp = StartsWith(url, MODBUS_TCP_SCHEME);
+  if (!isModbusTcp && !StartsWith(url, RTU_OVER_TCP_SCHEME))
+  {
+    throw std::runtime_error("Unknown transport URL " + url);
+  }
+  _framing = isModbusTcp ? eFraming::MODBUS_TCP : eFraming::RTU_OVER_TCP;
+  auto const address = url.substr(std::string{isModbusTcp ? MODBUS_TCP_SCHEME : RTU_OVER_TCP_SCHEME}.size());
+  auto const separator = address.rfind(':');
+  auto const host = address.substr(0, separator);
+  auto const port = (separator != std::string::npos) ? address.substr(separator + 1) : std::string{};
+  if (host.empty() || (port.empty() && !isModbusTcp))
+  {
+    throw std::runtime_error("Host and port are expected in " + url);
+  }
+  ip::tcp::resolver resolver{_io};
+  connect(_socket, resolver.resolve(ip::tcp::resolver::query(host, port.empty() ? std::to_string(MODBUS_TCP_PORT) : port)));
+  _socket.set_option(ip::tcp::no_delay(true));
+}
+
+bool TcpTransport::IsUrl(std::string const& path)
+{
+  return StartsWith(path, MODBUS_TCP_SCHEME) || StartsWith(path, RTU_OVER_TCP_SCHEME);
+}
+
+void TcpTransport::Capture(std::string const& capturePath)
+{
+  _capture = std::make_unique<CaptureWriter>(capturePath, _url);
+}
+
+void TcpTransport::DiscardStale()
+{
+  boost::system::error_code errorCode;
+  std::array<char, 256> chunk{};
+  while (_socket.available(errorCode) > 0)
+  {
+    _socket.read_some(boost::asio::buffer(chunk), errorCode);
+    if (errorCode)
+    {
+      return;
+    }
+  }
+}
+
+auto TcpTransport::ToMbap(std::string const& rtu, uint16_t transactionId) const -> std::string
+{
+  // Unit id and PDU, without CRC
+  auto const unitSize = static_cast<uint16_t>(rtu.size() - 2);
+  std::string mbap;
+  mbap.reserve(MBAP_HEADER_SIZE - 1 + unitSize);
+  Put16(mbap, transactionId);
+  Put16(mbap, 0);
+  Put16(mbap, unitSize);
+  mbap.append(rtu, 0, unitSize);
+  return mbap;
+}
+
+void TcpTransport::SendCommand(std::string const& data,
+                               tResponseCallback&& response,
+                               size_t timeoutResponseMs,
+                               tResponseComplete const& isComplete)
+{
+  if (_framing == eFraming::RTU_OVER_TCP)
+  {
+    SendRtu(data, response, timeoutResponseMs, isComplete);
+    return;
+  }
+  SendCommands({data}, [&](size_t, std::string const& responseData, bool error, std::chrono::steady_clock::time_point) {
+    response(responseData, error);
+  }, timeoutResponseMs, {isComplete});
+}
+
+void TcpTransport::SendRtu(std::string const& data,
+                           tResponseCallback const& response,
+                           size_t timeoutResponseMs,
+                           tResponseComplete const& isComplete)
+{
+  boost::system::error_code errorCode;
+  bool readError{true};
+  std::string responseData;
+  std::array<char, 256> chunk{};
+  DiscardStale();
+  std::function<void(boost::system::error_code const&, size_t)> onRead = [&](boost::system::error_code const& error, size_t bytes_transferred) {
+    if (error || (bytes_transferred == 0))
+    {
+      _timer.cancel();
+      return;
+    }
+    responseData.append(chunk.data(), bytes_transferred);
+    if (_capture)
+    {
+      _capture->Chunk(chunk.data(), bytes_transferred);
+    }
+    if (isComplete && !isComplete(responseData))
+    {
+      _socket.async_read_some(boost::asio::buffer(chunk), onRead);
+      return;
+    }
+    readError = false;
+    _timer.cancel();
+  };
+  _socket.async_read_some(boost::asio::buffer(chunk), onRead);
+  _timer.expires_from_now(boost::posix_time::milliseconds(timeoutResponseMs));
+  _timer.async_wait([&](const boost::system::error_code& error) {
+    if (!error)
+    {
+      _socket.cancel();
+    }
+  });
+  if (_capture)
+  {
+    _capture->Request(data.data(), data.size());
+  }
+  boost::asio::write(_socket, boost::asio::buffer(data), errorCode);
+  if (errorCode)
+  {
+    _socket.cancel();
+    _timer.cancel();
+  }
+  _io.run();
+  _io.reset();
+  if (_capture)
+  {
+    _capture->End(!errorCode && !readError);
+  }
+  response(errorCode ? std::string{} : responseData, errorCode || readError);
+}
+
+void TcpTransport::SendCommands(std::vector<std::string> const& requests,
+                                tIndexedResponseCallback const& response,
+                                size_t timeoutResponseMs,
+                                std::vector<tResponseComplete> const& isComplete)
+{
+  if (_framing == eFraming::RTU_OVER_TCP)
+  {
+    // Gateway forwards frames to the bus one by one and RTU frames have no identifiers to match replies
+    Transport::SendCommands(requests, response, timeoutResponseMs, isComplete);
+    return;
+  }
+  if (requests.empty())
+  {
+    return;
+  }
+  DiscardStale();
+  // All requests are outstanding at once, each one is timed from their write
+  auto const started = std::chrono::steady_clock::now();
+  std::map<uint16_t, size_t> outstanding;
+  std::string frames;
+  for (size_t i = 0; i < requests.size(); ++i)
+  {
+    auto const transactionId = ++_transactionId;
+    outstanding.emplace(transactionId, i);
+    frames += ToMbap(requests[i], transactionId);
+  }
+
+  std::string received;
+  std::array<char, 512> chunk{};
+  std::function<void(boost::system::error_code const&, size_t)> onRead = [&](boost::system::error_code const& error, size_t bytes_transferred) {
+    if (error || (bytes_transferred == 0))
+    {
+      _timer.cancel();
+      return;
+    }
+    received.append(chunk.data(), bytes_transferred);
+    while (received.size() >= MBAP_HEADER_SIZE)
+    {
+      auto const length = Get16(received, 4);
+      if ((Get16(received, 2) != 0) || (length < 2) || (length > 254))
+      {
+        // Tail of a reply which came after previous timeout, stream can not be resynchronized within this data
+        received.clear();
+        break;
+      }
+      auto const frameSize = MBAP_HEADER_SIZE - 1 + length;
+      if (received.size() < frameSize)
+      {
+        break;
+      }
+      auto const frame = received.substr(0, frameSize);
+      received.erase(0, frameSize);
+      auto const it = outstanding.find(Get16(frame, 0));
+      if (it == outstanding.end())
+      {
+        continue;
+      }
+      auto const rtu = ToRtu(frame);
+      if (_capture)
+      {
+        // Exchanges are recorded when completed, so pipelined captures replay as sequential ones
+        _capture->Request(requests[it->second].data(), requests[it->second].size());
+        _capture->Chunk(rtu.data(), rtu.size());
+        _capture->End(true);
+      }
+      response(it->second, rtu, false, started);
+      outstanding.erase(it);
+    }
+    if (outstanding.empty())
+    {
+      _timer.cancel();
+      return;
+    }
+    _socket.async_read_some(boost::asio::buffer(chunk), onRead);
+  };
+  _socket.async_read_some(boost::asio::buffer(chunk), onRead);
+  _timer.expires_from_now(boost::posix_time::milliseconds(timeoutResponseMs));
+  _timer.async_wait([&](const boost::system::error_code& error) {
+    if (!error)
+    {
+      _socket.cancel();
+    }
+  });
+  boost::system::error_code errorCode;
+  boost::asio::write(_socket, boost::asio::buffer(frames), errorCode);
+  if (errorCode)
+  {
+    _socket.cancel();
+    _timer.cancel();
+  }
+  _io.run();
+  _io.reset();
+  for (auto const& transaction : outstanding)
+  {
+    if (_capture)
+    {
+      _capture->Request(requests[transaction.second].data(), requests[transaction.second].size());
+      _capture->End(false);
+    }
+    response(transaction.second, {}, true, started);
+  }
+}
+
+bool TcpTransport::Send(std::string const& data)
+{
+  boost::system::error_code errorCode;
+  auto const frame = (_framing == eFraming::MODBUS_TCP) ? ToMbap(data, ++_transactionId) : data;
+  if (_capture)
+  {
+    _capture->Request(data.data(), data.size());
+  }
+  auto bytesTranfered = boost::asio::write(_socket, boost::asio::buffer(frame), errorCode);
+  if (_capture)
+  {
+    _capture->End(true);
+  }
+  return !errorCode && (bytesTranfered == frame.size());
+}
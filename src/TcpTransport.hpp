@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CaptureWriter.hpp"
+#include "Transport.hpp"
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <memory>
+
+/**
+ * Modbus over TCP: Modbus TCP (MBAP header, transaction identifiers, several outstanding transactions)
+ * or RTU frames tunneled through a TCP connection to an Ethernet-RS485 gateway.
+ */
+class TcpTransport : public Transport
+{
+public:
+  enum class eFraming
+  {
+    MODBUS_TCP,     ///< tcp://host[:port], default port 502
+    RTU_OVER_TCP    ///< rtutcp://host:port
+  };
+
+  static constexpr uint16_t MODBUS_TCP_PORT = 502;
+
+public:
+  /**
+   * Connect to the URL.
+   * @throw std::runtime_error if URL is malformed, boost::system::system_error if connection failed.
+   */
+  explicit TcpTransport(std::string const& url);
+
+  /**
+   * True if path is a URL of one of TCP schemes, not a serial port path.
+   */
+  static bool IsUrl(std::string const& path);
+
+  void SendCommand(std::string const& data,
+                   tResponseCallback && response = [](std::string const&, bool error){},
+                   size_t timeoutResponseMs = 0,
+                   tResponseComplete const& isComplete = {}) override;
+
+  /**
+   * Modbus TCP sends all requests at once and matches responses by transaction identifier,
+   * so the batch costs one round trip. RTU over TCP sends requests one by one.
+   */
+  void SendCommands(std::vector<std::string> const& requests,
+                    tIndexedResponseCallback const& response,
+                    size_t timeoutResponseMs,
+                    std::vector<tResponseComplete> const& isComplete) override;
+
+  bool Send(std::string const& data) override;
+
+  auto Path() const -> std::string const& override
+  {
+    return _url;
+  }
+
+  void Capture(std::string const& capturePath) override;
+
+private:
+  /**
+   * Discard bytes of replies which came after previous timeout.
+   */
+  void DiscardStale();
+
+  auto ToMbap(std::string const& rtu, uint16_t transactionId) const -> std::string;
+
+  void SendRtu(std::string const& data, tResponseCallback const& response, size_t timeoutResponseMs, tResponseComplete const& isComplete);
+
+private:
+  std::string _url;
+  eFraming _framing{};
+  boost::asio::io_service _io;
+  boost::asio::ip::tcp::socket _socket;
+  boost::asio::deadline_timer _timer;
+  uint16_t _transactionId{};
+  std::unique_ptr<CaptureWriter> _capture;
+};
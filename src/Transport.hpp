@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Link to Modbus slaves. Requests and responses are RTU frames (address, PDU, CRC) whatever the link is,
+ * transports with other framing (Modbus TCP) convert them, so ModBus and its codec do not depend on the link.
+ */
+class Transport
+{
+public:
+  using tResponseCallback = std::function<void(std::string const&, bool error)>;
+  using tResponseComplete = std::function<bool(std::string const&)>;
+  using tIndexedResponseCallback = std::function<void(size_t index, std::string const&, bool error,
+                                                      std::chrono::steady_clock::time_point started)>;
+
+public:
+  virtual ~Transport() = default;
+
+  /**
+   * Send data and wait for response.
+   * @param response callback with received data, error is true if nothing was received or response is incomplete.
+   * @param timeoutResponseMs time to wait for complete response.
+   * @param isComplete tells if received data is a complete response, reading continues until it returns true
+   *                   (a response split by the line into several chunks is reassembled). If empty, first received
+   *                   chunk is the response.
+   */
+  virtual void SendCommand(std::string const& data,
+                           tResponseCallback && response = [](std::string const&, bool error){},
+                           size_t timeoutResponseMs = 0,
+                           tResponseComplete const& isComplete = {}) = 0;
+
+  /**
+   * Send several requests and wait for all responses. Transports which can keep several transactions
+   * outstanding (Modbus TCP) send all requests at once, others send them one by one.
+   * @param response called once for every request with its index and the time its exchange started: when it was
+   *                 sent or, if the link serves the requests one by one, when the response to the previous one came.
+   * @param isComplete completion predicates in order of requests.
+   */
+  virtual void SendCommands(std::vector<std::string> const& requests,
+                            tIndexedResponseCallback const& response,
+                            size_t timeoutResponseMs,
+                            std::vector<tResponseComplete> const& isComplete)
+  {
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+      auto const started = std::chrono::steady_clock::now();
+      SendCommand(requests[i], [&](std::string const& data, bool error) {
+        response(i, data, error, started);
+      }, timeoutResponseMs, (i < isComplete.size()) ? isComplete[i] : tResponseComplete{});
+    }
+  }
+
+  /**
+   * Send data without waiting for any response (broadcast).
+   * @return true if all data has been written.
+   */
+  virtual bool Send(std::string const& data) = 0;
+
+  /**
+   * True if the asynchronous calls below complete on a reactor thread (see Reactor), false if they complete
+   * in the calling thread before returning.
+   */
+  virtual bool IsAsync() const
+  {
+    return false;
+  }
+
+  /**
+   * SendCommand which does not wait for the response, done is called once with it.
+   */
+  virtual void AsyncSendCommand(std::string const& data,
+                                tResponseCallback done,
+                                size_t timeoutResponseMs,
+                                tResponseComplete isComplete)
+  {
+    SendCommand(data, std::move(done), timeoutResponseMs, isComplete);
+  }
+
+  /**
+   * Send which does not wait for the data to be written, done is called once with its result.
+   */
+  virtual void AsyncSend(std::string const& data, std::function<void(bool sent)> done)
+  {
+    done(Send(data));
+  }
+
+  /**
+   * Path or URL the transport is connected to.
+   */
+  virtual auto Path() const -> std::string const& = 0;
+
+  /**
+   * Record every exchange to a capture file, see CaptureWriter for the format.
+   * @throw std::runtime_error if file could not be created.
+   */
+  virtual void Capture(std::string const& capturePath) = 0;
+};
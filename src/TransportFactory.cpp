@@ -0,0 +1,94 @@
+#include "TransportFactory.hpp"
+
+#include "MuxTransport.hpp"
+#include "ReactorSerialPort.hpp"
+#include "SerialPort.hpp"
+#include "TcpTransport.hpp"
+
+namespace OWEN {
+
+namespace {
+
+auto ToSerialPortType(ImpulseCounter30::CommunicationOptions::eParity parity) -> SerialPort::eParity
+{
+   using eParity = ImpulseCounter30::CommunicationOptions::eParity;
+   switch(parity)
+   {
+      case eParity::EVEN:
+         return SerialPort::eParity::even;
+      case eParity::ODD:
+         return SerialPort::eParity::odd;
+      case eParity::NO:
+      default:
+         return SerialPort::eParity::none;
+   }
+}
+
+auto ToSerialPortType(ImpulseCounter30::CommunicationOptions::eBaudrate baudrate) -> uint32_t
+{
+   using eBaudrate = ImpulseCounter30::CommunicationOptions::eBaudrate;
+   switch(baudrate)
+   {
+      case eBaudrate::_2400bps:
+         return 2400;
+      case eBaudrate::_4800bps:
+         return 4800;
+      case eBaudrate::_9600bps:
+         return 9600;
+      case eBaudrate::_14400bps:
+         return 14400;
+      case eBaudrate::_19200bps:
+         return 19200;
+      case eBaudrate::_28800bps:
+         return 28800;
+      case eBaudrate::_38400bps:
+         return 38400;
+      case eBaudrate::_57600bps:
+         return 57600;
+      case eBaudrate::_115200bps:
+         return 115200;
+      default: return 0;
+   }
+}
+
+} /// end namespace anonymous
+
+auto SerialSettingsOf(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> SerialLineSettings
+{
+   return SerialLineSettings{ToSerialPortType(communicationOptions._baudrate.value()),
+                             ToSerialPortType(communicationOptions._parity.value()),
+                             communicationOptions._stopBitsExtended.value() ? SerialPort::eStopBits::two : SerialPort::eStopBits::one,
+                             communicationOptions._dataBitsExtended.value() ? static_cast<uint8_t>(8) : static_cast<uint8_t>(7)};
+}
+
+auto CreateSerialPort(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<Transport>
+{
+   auto const settings = SerialSettingsOf(communicationOptions);
+   if (communicationOptions._sharedReactor.value_or(false))
+   {
+      return std::make_unique<ReactorSerialPort>(Reactor::Shared(), communicationOptions._portPath, settings.baudrate,
+                                                 settings.parity, settings.stopBits, settings.characterSize);
+   }
+   return std::make_unique<SerialPort>(communicationOptions._portPath, settings.baudrate, settings.parity,
+                                       settings.stopBits, settings.characterSize);
+}
+
+auto CreateTransport(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<Transport>
+{
+   if (TcpTransport::IsUrl(communicationOptions._portPath))
+   {
+      return std::make_unique<TcpTransport>(communicationOptions._portPath);
+   }
+   if (MuxTransport::IsUrl(communicationOptions._portPath))
+   {
+      return std::make_unique<MuxTransport>(communicationOptions._portPath);
+   }
+   return CreateSerialPort(communicationOptions);
+}
+
+bool IsTransportUrl(std::string const& portPath)
+{
+   return TcpTransport::IsUrl(portPath) || MuxTransport::IsUrl(portPath);
+}
+
+} /// end namespace OWEN
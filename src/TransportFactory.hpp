@@ -0,0 +1,33 @@
+#pragma once
+
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include "SerialLine.hpp"
+#include "Transport.hpp"
+
+#include <memory>
+
+namespace OWEN {
+
+/**
+ * Line settings of the serial options, all of them have to be set.
+ */
+auto SerialSettingsOf(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> SerialLineSettings;
+
+/**
+ * Serial port with the serial options, all of them have to be set, driven by the shared reactor if it is asked for.
+ */
+auto CreateSerialPort(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<Transport>;
+
+/**
+ * Transport for the port path: TCP connection for tcp:// and rtutcp:// URLs, multiplexing daemon client
+ * for mux:// URLs, serial port otherwise.
+ */
+auto CreateTransport(ImpulseCounter30::CommunicationOptions const& communicationOptions) -> std::unique_ptr<Transport>;
+
+/**
+ * True if port path is a URL (no serial options are needed and device is never searched).
+ */
+bool IsTransportUrl(std::string const& portPath);
+
+} /// end namespace OWEN
@@ -37,7 +37,7 @@ const uint16_t Crc16Table[256] = {
   0x0182, 0xC042, 0x8043, 0x4183, 0x0041, 0xC181, 0x8180, 0x4040
 };
 
-auto Crc16(uint8_t const* pcBlock, uint16_t len) -> uint16_t
+inline auto Crc16(uint8_t const* pcBlock, uint16_t len) -> uint16_t
 {
   uint16_t crc = 0xFFFF;
 
@@ -0,0 +1,177 @@
+#include <OWEN/BatchController.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --port PATH --address ADDR --target COUNT [options]\n"
+             << "  --port PATH          serial port of the counter\n"
+             << "  --address ADDR       slave address of the counter\n"
+             << "  --baudrate BPS       line baudrate, 8N1 (default 9600)\n"
+             << "  --target COUNT       pulses of a batch\n"
+             << "  --batches N          batches to run (default 10)\n"
+             << "  --mode MODE          software | setpoint | naive (default software), naive stops when a polled value\n"
+             << "                       reaches the target, for comparison\n"
+             << "  --latency US         initial stop latency (default learned from the first batch)\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+/**
+ * Stop of the batch as it is done without prediction.
+ */
+auto RunNaive(OWEN::ImpulseCounter30& counter, int32_t target) -> std::optional<OWEN::BatchController::Batch>
+{
+   auto const start = std::chrono::steady_clock::now();
+   OWEN::BatchController::Batch batch;
+   batch.target = target;
+   if (!counter.ResetCount() || !counter.StartCounter(true))
+   {
+      return {};
+   }
+   while (true)
+   {
+      auto const value = counter.GetCounterValue();
+      if (!value.has_value())
+      {
+         counter.StartCounter(false);
+         return {};
+      }
+      if (value.value() >= target)
+      {
+         batch.stopAt = value.value();
+         break;
+      }
+   }
+   auto const count = counter.StartCounter(false) ? counter.GetCounterValue() : std::nullopt;
+   if (!count.has_value())
+   {
+      return {};
+   }
+   batch.count = count.value();
+   batch.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+   return batch;
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::string portPath;
+   uint32_t address{};
+   uint32_t baudrate{9600};
+   int32_t target{};
+   uint32_t batches{10};
+   std::string mode{"software"};
+   std::optional<uint32_t> latencyUs;
+   try
+   {
+      for (int32_t i = 1; i < argc; ++i)
+      {
+         auto const arg = std::string{argv[i]};
+         if ((i + 1) >= argc)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         auto const value = std::string{argv[++i]};
+         if (arg == "--port") portPath = value;
+         else if (arg == "--address") address = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--target") target = static_cast<int32_t>(std::stol(value));
+         else if (arg == "--batches") batches = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--mode") mode = value;
+         else if (arg == "--latency") latencyUs = static_cast<uint32_t>(std::stoul(value));
+         else
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+      }
+   }
+   catch (std::exception const&)
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   if (portPath.empty() || (address == 0) || (target <= 0) || ((mode != "software") && (mode != "setpoint") && (mode != "naive")))
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   try
+   {
+      auto communicationOptions = CommunicationOptions{};
+      communicationOptions.PortPath(portPath)
+              .BaudeRate(ToBaudrate(baudrate))
+              .Parity(CommunicationOptions::eParity::NO)
+              .StopBits(false)
+              .DataBits(true)
+              .BaseAddr(static_cast<uint8_t>(address));
+      OWEN::ImpulseCounter30 counter{communicationOptions};
+      auto options = OWEN::BatchController::Options{};
+      options.stop = (mode == "setpoint") ? OWEN::BatchController::eStop::SET_POINT : OWEN::BatchController::eStop::SOFTWARE;
+      OWEN::BatchController controller{counter, options};
+      if (latencyUs.has_value())
+      {
+         controller.SetStopLatency(std::chrono::microseconds(latencyUs.value()));
+      }
+
+      std::cout << std::left << std::setw(8) << "Batch" << std::setw(10) << "Stop at" << std::setw(10) << "Count"
+                << std::setw(11) << "Overshoot" << std::setw(12) << "Rate /s" << std::setw(14) << "Latency us"
+                << std::setw(14) << "Learned us" << "Duration ms" << std::endl;
+      uint32_t failed{};
+      int64_t overshoot{};
+      int64_t overshootSquares{};
+      for (uint32_t i = 0; i < batches; ++i)
+      {
+         auto const batch = (mode == "naive") ? RunNaive(counter, target) : controller.Run(target);
+         if (!batch.has_value())
+         {
+            std::cout << std::setw(8) << i << "failed" << std::endl;
+            ++failed;
+            continue;
+         }
+         overshoot += batch->Overshoot();
+         overshootSquares += static_cast<int64_t>(batch->Overshoot()) * batch->Overshoot();
+         std::cout << std::setw(8) << i
+                   << std::setw(10) << batch->stopAt
+                   << std::setw(10) << batch->count
+                   << std::setw(11) << batch->Overshoot()
+                   << std::setw(12) << std::lround(batch->rate)
+                   << std::setw(14) << batch->stopLatency.count()
+                   << std::setw(14) << controller.GetStopLatency().count()
+                   << batch->duration.count() << std::endl;
+      }
+      auto const done = batches - failed;
+      if (done != 0)
+      {
+         std::cout << "Mean overshoot " << (static_cast<double>(overshoot) / done)
+                   << ", RMS " << std::sqrt(static_cast<double>(overshootSquares) / done)
+                   << ", failed " << failed << std::endl;
+      }
+      return (failed == 0) ? 0 : 1;
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+}
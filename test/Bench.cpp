@@ -0,0 +1,205 @@
+#include "MetricsRecorder.hpp"
+#include "ModBusCodec.hpp"
+#include "SI30RegisterMap.hpp"
+#include "crc16.hpp"
+
+#include <OWEN/SnapshotShm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocations{};
+
+template <typename T>
+void DoNotOptimize(T const& value)
+{
+#if defined(__GNUC__)
+   asm volatile("" : : "r,m"(value) : "memory");
+#else
+   static volatile char const* sink;
+   sink = reinterpret_cast<char const*>(&value);
+#endif
+}
+
+/**
+ * Run benchmark for about 200 ms and print time and heap allocations per operation.
+ */
+template <typename Benchmark>
+void Run(std::string const& name, Benchmark&& benchmark)
+{
+   using namespace std::chrono;
+   uint64_t iterations{1000};
+   for (auto i = 0; i < 1000; ++i)
+   {
+      benchmark();
+   }
+   while (true)
+   {
+      auto const allocationsBefore = allocations.load();
+      auto const start = steady_clock::now();
+      for (uint64_t i = 0; i < iterations; ++i)
+      {
+         benchmark();
+      }
+      auto const elapsed = steady_clock::now() - start;
+      if ((elapsed < milliseconds(200)) && (iterations < (1ull << 32)))
+      {
+         iterations *= 4;
+         continue;
+      }
+      auto const allocationsPerOp = static_cast<double>(allocations.load() - allocationsBefore) / iterations;
+      std::cout << std::left << std::setw(40) << name
+                << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                << (static_cast<double>(duration_cast<nanoseconds>(elapsed).count()) / iterations) << " ns/op"
+                << std::setprecision(2) << std::setw(10) << allocationsPerOp << " allocs/op" << std::endl;
+      return;
+   }
+}
+
+auto WithCrc(std::string frame) -> std::string
+{
+   auto const crc16 = Crc16(reinterpret_cast<uint8_t const*>(frame.data()), frame.size());
+   frame += static_cast<char>(crc16 >> 8);
+   frame += static_cast<char>(crc16 & 0xFF);
+   return frame;
+}
+
+auto ReadResponse(uint8_t function, uint16_t count) -> std::string
+{
+   auto const isBits = (function == 0x01) || (function == 0x02);
+   auto const bytes = isBits ? (count + 7) / 8 : count * 2;
+   std::string response{0x10, static_cast<char>(function), static_cast<char>(bytes)};
+   for (auto i = 0; i < bytes; ++i)
+   {
+      response += static_cast<char>(0x5A + i);
+   }
+   return WithCrc(response);
+}
+
+} /// end namespace anonymous
+
+void* operator new(size_t size)
+{
+   ++allocations;
+   if (auto* memory = std::malloc(size ? size : 1))
+   {
+      return memory;
+   }
+   throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+   std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+   std::free(memory);
+}
+
+int main()
+{
+   constexpr uint8_t address = 0x10;
+
+   std::cout << "--- crc" << std::endl;
+   for (auto size : {8, 53, 256})
+   {
+      auto const data = std::string(size, '\x5A');
+      Run("Crc16/" + std::to_string(size), [&] {
+         DoNotOptimize(Crc16(reinterpret_cast<uint8_t const*>(data.data()), static_cast<uint16_t>(data.size())));
+      });
+   }
+
+   std::cout << "--- request frame construction" << std::endl;
+   for (uint8_t function : {0x01, 0x02, 0x03, 0x04})
+   {
+      Run("Request/0x0" + std::to_string(function), [&] {
+         DoNotOptimize(ModBusCodec::ReadRequest(address, function, 0x0000, 2));
+      });
+   }
+   Run("Request/0x05", [&] { DoNotOptimize(ModBusCodec::ForceSingleCoilRequest(address, 0x0002, true)); });
+   Run("Request/0x06", [&] { DoNotOptimize(ModBusCodec::WriteSingleHoldingRegisterRequest(address, 0x0007, 1)); });
+   auto const values2 = std::vector<uint16_t>{0x0001, 0x86A0};
+   auto const values24 = std::vector<uint16_t>(24, 0x1234);
+   Run("Request/0x10 2 registers", [&] { DoNotOptimize(ModBusCodec::WriteMultipleHoldingRegisterRequest(address, 0x000C, values2)); });
+   Run("Request/0x10 24 registers", [&] { DoNotOptimize(ModBusCodec::WriteMultipleHoldingRegisterRequest(address, 0x0007, values24)); });
+   Run("Request/0x17 write 2 read 24", [&] {
+      DoNotOptimize(ModBusCodec::ReadWriteMultipleRegistersRequest(address, 0x0007, 24, 0x000C, values2));
+   });
+
+   std::cout << "--- response validation" << std::endl;
+   auto const coils = ReadResponse(0x01, 5);
+   auto const discreteInputs = ReadResponse(0x02, 2);
+   auto const holding24 = ReadResponse(0x03, 24);
+   auto const input2 = ReadResponse(0x04, 2);
+   auto const input7 = ReadResponse(0x04, 7);
+   auto const readWrite24 = ReadResponse(0x17, 24);
+   auto const echo = ModBusCodec::ForceSingleCoilRequest(address, 0x0002, true);
+   auto const echoCopy = echo;
+   auto const writeMultiple = WithCrc(std::string{0x10, 0x10, 0x00, 0x0C, 0x00, 0x02});
+   auto const exception = WithCrc(std::string{0x10, static_cast<char>(0x97), 0x01});
+   Run("Validate/0x01 5 bits", [&] { DoNotOptimize(ModBusCodec::IsReadResponseValid(coils, address, 0x01, 5)); });
+   Run("Validate/0x02 2 bits", [&] { DoNotOptimize(ModBusCodec::IsReadResponseValid(discreteInputs, address, 0x02, 2)); });
+   Run("Validate/0x03 24 registers", [&] { DoNotOptimize(ModBusCodec::IsReadResponseValid(holding24, address, 0x03, 24)); });
+   Run("Validate/0x04 2 registers", [&] { DoNotOptimize(ModBusCodec::IsReadResponseValid(input2, address, 0x04, 2)); });
+   Run("Validate/0x05 0x06 echo", [&] { DoNotOptimize(echo == echoCopy); });
+   Run("Validate/0x10", [&] { DoNotOptimize(ModBusCodec::IsWriteMultipleResponseValid(writeMultiple, address, 0x000C, 2)); });
+   Run("Validate/0x17 24 registers", [&] { DoNotOptimize(ModBusCodec::IsReadResponseValid(readWrite24, address, 0x17, 24)); });
+   Run("Validate/exception", [&] { DoNotOptimize(ModBusCodec::ExceptionCode(exception, address, 0x17)); });
+
+   std::cout << "--- decoding" << std::endl;
+   Run("Decode/0x01 5 bits", [&] { DoNotOptimize(ModBusCodec::DecodeBits(coils, 5)); });
+   Run("Decode/0x02 2 bits", [&] { DoNotOptimize(ModBusCodec::DecodeBits(discreteInputs, 2)); });
+   Run("Decode/0x03 24 registers", [&] { DoNotOptimize(ModBusCodec::DecodeRegisters(holding24, 24)); });
+   Run("Decode/0x04 2 registers", [&] { DoNotOptimize(ModBusCodec::DecodeRegisters(input2, 2)); });
+   Run("Decode/0x17 24 registers", [&] { DoNotOptimize(ModBusCodec::DecodeRegisters(readWrite24, 24)); });
+   {
+      using namespace OWEN::SI30;
+      using tSnapshot = detail::Fields<CounterValue, CounterEU, StartStopMode, CurrentMode, CodeErrNet>;
+      std::array<std::vector<uint16_t>, tSnapshot::readPlan.spanCount> spans{ModBusCodec::DecodeRegisters(input7, 7)};
+      Run("Decode/SI30 snapshot fields", [&] {
+         DoNotOptimize(tSnapshot::Decode(spans, std::index_sequence_for<CounterValue, CounterEU, StartStopMode, CurrentMode, CodeErrNet>{}));
+      });
+   }
+
+   std::cout << "--- metrics" << std::endl;
+   {
+      MetricsRecorder metrics;
+      Run("Metrics/Record", [&] {
+         metrics.Record(0x04, MetricsRecorder::eOutcome::OK, 8, 9, std::chrono::microseconds(1800));
+      });
+      Run("Metrics/steady_clock::now", [&] { DoNotOptimize(std::chrono::steady_clock::now()); });
+   }
+
+   std::cout << "--- snapshot seqlock" << std::endl;
+   {
+      static OWEN::SnapshotShm::Slot slot{};
+      OWEN::SnapshotShm::Snapshot snapshot{123456, 1234, 1, 2, 0, 0, 0, 0};
+      Run("SnapshotShm/Write", [&] {
+         ++snapshot.counterValue;
+         OWEN::SnapshotShm::Write(slot, snapshot);
+      });
+      Run("SnapshotShm/TryRead", [&] {
+         DoNotOptimize(OWEN::SnapshotShm::TryRead(slot, snapshot));
+      });
+   }
+
+   std::cout << "--- transaction (request + validation + decoding)" << std::endl;
+   Run("Transaction/GetCounterValue", [&] {
+      DoNotOptimize(ModBusCodec::ReadRequest(address, 0x04, 0x0000, 2));
+      if (ModBusCodec::IsReadResponseValid(input2, address, 0x04, 2))
+      {
+         DoNotOptimize(ModBusCodec::DecodeRegisters(input2, 2));
+      }
+   });
+   return 0;
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "SI30Simulator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * Pseudo terminal which serves a capture recorded by SerialPort::Capture: every received request is answered with
+ * the response chunks of the next recorded exchange with the same request, with recorded timing scaled by speed.
+ */
+class CaptureReplay
+{
+public:
+  struct Chunk
+  {
+    std::chrono::microseconds delay;   ///< since request (first chunk) or previous chunk
+    std::string data;
+  };
+
+  struct Exchange
+  {
+    std::string request;
+    std::vector<Chunk> chunks;
+  };
+
+  struct Options
+  {
+    double speed{1.0};      ///< timing acceleration, 0 - reply immediately
+    bool loop{};            ///< start from the beginning when capture is over
+  };
+
+  struct Counters
+  {
+    std::atomic<uint64_t> requests{};
+    std::atomic<uint64_t> replayed{};
+    std::atomic<uint64_t> skipped{};    ///< recorded exchanges skipped to find matching request
+    std::atomic<uint64_t> unmatched{};  ///< requests which are not in the rest of the capture
+  };
+
+public:
+  CaptureReplay(std::string const& capturePath, Options const& options)
+    : _exchanges{Load(capturePath)}
+    , _options{options}
+  {
+  }
+
+  ~CaptureReplay()
+  {
+    Stop();
+    for (auto fd : {_masterFd, _slaveFd})
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+    }
+    if (!_linkPath.empty())
+    {
+      ::unlink(_linkPath.c_str());
+    }
+  }
+
+  /**
+   * Parse capture file.
+   * @throw std::runtime_error if file could not be read or has a malformed line.
+   */
+  static auto Load(std::string const& capturePath) -> std::vector<Exchange>
+  {
+    std::ifstream file{capturePath};
+    if (!file)
+    {
+      throw std::runtime_error("Could not open " + capturePath);
+    }
+    std::vector<Exchange> exchanges;
+    int64_t lastTimeUs{};
+    size_t lineNumber{};
+    for (std::string line; std::getline(file, line);)
+    {
+      ++lineNumber;
+      if (line.empty() || (line[0] == '#'))
+      {
+        continue;
+      }
+      std::istringstream record{line};
+      char kind{};
+      int64_t timeUs{};
+      if (!(record >> kind >> timeUs))
+      {
+        throw std::runtime_error("Malformed capture line " + std::to_string(lineNumber));
+      }
+      std::string bytes;
+      for (uint32_t byte; record >> std::hex >> byte;)
+      {
+        bytes += static_cast<char>(byte);
+      }
+      switch (kind)
+      {
+        case '>':
+          exchanges.emplace_back(Exchange{bytes, {}});
+          break;
+        case '<':
+          if (exchanges.empty())
+          {
+            throw std::runtime_error("Response without request at line " + std::to_string(lineNumber));
+          }
+          exchanges.back().chunks.emplace_back(Chunk{std::chrono::microseconds(timeUs - lastTimeUs), bytes});
+          break;
+        case '=':
+          break;
+        default:
+          throw std::runtime_error("Malformed capture line " + std::to_string(lineNumber));
+      }
+      lastTimeUs = timeUs;
+    }
+    return exchanges;
+  }
+
+  auto Start(std::string const& linkPath = {}) -> std::string
+  {
+    _masterFd = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if ((_masterFd < 0) || (::grantpt(_masterFd) != 0) || (::unlockpt(_masterFd) != 0))
+    {
+      throw std::runtime_error("Could not open pseudo terminal");
+    }
+    std::string slavePath = ::ptsname(_masterFd);
+    _slaveFd = ::open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+    termios tio{};
+    ::tcgetattr(_slaveFd, &tio);
+    ::cfmakeraw(&tio);
+    ::tcsetattr(_slaveFd, TCSANOW, &tio);
+    if (!linkPath.empty())
+    {
+      ::unlink(linkPath.c_str());
+      if (::symlink(slavePath.c_str(), linkPath.c_str()) != 0)
+      {
+        throw std::runtime_error("Could not create symlink " + linkPath);
+      }
+      _linkPath = linkPath;
+    }
+    _running = true;
+    _thread = std::thread([this] { Serve(); });
+    return _linkPath.empty() ? slavePath : _linkPath;
+  }
+
+  void Stop()
+  {
+    _running = false;
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+  }
+
+  auto Exchanges() const -> std::vector<Exchange> const&
+  {
+    return _exchanges;
+  }
+
+  auto GetCounters() const -> Counters const&
+  {
+    return _counters;
+  }
+
+  /**
+   * True when all recorded exchanges were served (never in loop mode).
+   */
+  bool IsFinished() const
+  {
+    return _finished;
+  }
+
+private:
+  auto ReadRequest() -> std::string
+  {
+    std::string request;
+    auto timeoutMs = 50;
+    while (_running)
+    {
+      pollfd pfd{_masterFd, POLLIN, 0};
+      if (::poll(&pfd, 1, timeoutMs) <= 0)
+      {
+        if (request.empty())
+        {
+          continue;
+        }
+        return request;
+      }
+      char chunk[256];
+      auto const bytes = ::read(_masterFd, chunk, sizeof(chunk));
+      if (bytes <= 0)
+      {
+        continue;
+      }
+      request.append(chunk, static_cast<size_t>(bytes));
+      auto const length = SI30Simulator::RequestLength(request);
+      if ((length != 0) && (request.size() >= length))
+      {
+        return request;
+      }
+      timeoutMs = 5;
+    }
+    return {};
+  }
+
+  /**
+   * Find next recorded exchange of this request, skipping exchanges which did not happen this time.
+   */
+  auto Match(std::string const& request) -> Exchange const*
+  {
+    for (auto passes = 0; passes < (_options.loop ? 2 : 1); ++passes)
+    {
+      for (auto position = _position; position < _exchanges.size(); ++position)
+      {
+        if (_exchanges[position].request == request)
+        {
+          _counters.skipped += position - _position;
+          _position = position + 1;
+          return &_exchanges[position];
+        }
+      }
+      _position = 0;
+    }
+    return nullptr;
+  }
+
+  void Serve()
+  {
+    using namespace std::chrono;
+    while (_running)
+    {
+      auto const request = ReadRequest();
+      if (request.empty())
+      {
+        continue;
+      }
+      auto const received = steady_clock::now();
+      ++_counters.requests;
+      auto const* exchange = Match(request);
+      if (exchange == nullptr)
+      {
+        ++_counters.unmatched;
+        continue;
+      }
+      ++_counters.replayed;
+      auto sendTime = received;
+      for (auto const& chunk : exchange->chunks)
+      {
+        if (_options.speed > 0.0)
+        {
+          sendTime += duration_cast<steady_clock::duration>(duration<double, std::micro>(chunk.delay.count() / _options.speed));
+          std::this_thread::sleep_until(sendTime);
+        }
+        for (size_t offset = 0; offset < chunk.data.size();)
+        {
+          auto const bytes = ::write(_masterFd, chunk.data.data() + offset, chunk.data.size() - offset);
+          if (bytes <= 0)
+          {
+            break;
+          }
+          offset += static_cast<size_t>(bytes);
+        }
+      }
+      if (!_options.loop && (_position >= _exchanges.size()))
+      {
+        _finished = true;
+      }
+    }
+  }
+
+private:
+  std::vector<Exchange> _exchanges;
+  Options _options;
+  Counters _counters;
+  size_t _position{};
+  std::atomic<bool> _finished{};
+  int _masterFd{-1};
+  int _slaveFd{-1};
+  std::string _linkPath;
+  std::atomic<bool> _running{};
+  std::thread _thread;
+};
@@ -0,0 +1,139 @@
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+using CounterOptions = OWEN::ImpulseCounter30::CounterOptions;
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --device PORT:ADDR [options]\n"
+             << "  --device PORT:ADDR   device, may be repeated; all devices are driven by the shared reactor\n"
+             << "  --rounds N           workflows per device (default 100)\n";
+}
+
+struct Stats
+{
+   std::atomic<uint64_t> completed{};
+   std::atomic<uint64_t> failed{};
+};
+
+/**
+ * Read the counter, put set point 1 ahead of it and verify the write by readback, as sequential code.
+ */
+auto Workflow(OWEN::ImpulseCounter30& counter, uint32_t rounds, Stats& stats) -> OWEN::Task<void>
+{
+   for (uint32_t round = 0; round < rounds; ++round)
+   {
+      auto const options = co_await counter.GetCounterOptionsAsync();
+      auto const value = co_await counter.GetCounterValueAsync();
+      if (!options.has_value() || !value.has_value())
+      {
+         ++stats.failed;
+         continue;
+      }
+      auto const setPoint = std::clamp<int32_t>(value.value() + 1000 + static_cast<int32_t>(round), -99999, 999999);
+      auto const written = co_await counter.SetCounterOptionsAsync(CounterOptions{}.SetPoint1(setPoint), true);
+      ++(written ? stats.completed : stats.failed);
+   }
+}
+
+auto ThreadCount() -> size_t
+{
+   auto const tasks = std::filesystem::directory_iterator{"/proc/self/task"};
+   return static_cast<size_t>(std::distance(std::filesystem::begin(tasks), std::filesystem::end(tasks)));
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::vector<std::pair<std::string, uint16_t>> devices;
+   uint32_t rounds{100};
+   try
+   {
+      for (int32_t i = 1; i < argc; ++i)
+      {
+         auto const arg = std::string{argv[i]};
+         if ((i + 1) >= argc)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         auto const value = std::string{argv[++i]};
+         auto const colon = value.rfind(':');
+         if ((arg == "--device") && (colon != std::string::npos))
+         {
+            devices.emplace_back(value.substr(0, colon), static_cast<uint16_t>(std::stoul(value.substr(colon + 1))));
+         }
+         else if (arg == "--rounds") rounds = static_cast<uint32_t>(std::stoul(value));
+         else
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+      }
+   }
+   catch (std::exception const&)
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   if (devices.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   try
+   {
+      std::vector<std::unique_ptr<OWEN::ImpulseCounter30>> counters;
+      for (auto const& device : devices)
+      {
+         auto communicationOptions = CommunicationOptions{};
+         communicationOptions.PortPath(device.first)
+                 .BaudeRate(CommunicationOptions::eBaudrate::_115200bps)
+                 .Parity(CommunicationOptions::eParity::NO)
+                 .StopBits(false)
+                 .DataBits(true)
+                 .BaseAddr(device.second)
+                 .SharedReactor(true);
+         counters.emplace_back(std::make_unique<OWEN::ImpulseCounter30>(communicationOptions));
+      }
+
+      Stats stats;
+      std::atomic<size_t> running{counters.size()};
+      std::promise<void> allDone;
+      auto const start = std::chrono::steady_clock::now();
+      for (auto& counter : counters)
+      {
+         Workflow(*counter, rounds, stats).Start([&] {
+            if (--running == 0)
+            {
+               allDone.set_value();
+            }
+         });
+      }
+      auto const threads = ThreadCount();
+      allDone.get_future().wait();
+      auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "Workflows " << counters.size() << " x " << rounds << " rounds: completed " << stats.completed
+                << ", failed " << stats.failed << " in " << elapsed << " s ("
+                << static_cast<uint64_t>(stats.completed / elapsed) << " workflows/s), threads " << threads << std::endl;
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
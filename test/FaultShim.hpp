@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * Pseudo terminal in the middle between a client and the real port (or a simulator) which injects line faults
+ * into replies: corrupted bytes, truncated frames, added latency, frames split to chunks and dropped replies.
+ */
+class FaultShim
+{
+public:
+  struct Options
+  {
+    double corruptProbability{};    ///< flip one random bit of the reply
+    double truncateProbability{};   ///< cut random count of bytes from the reply tail
+    double latencyProbability{};    ///< delay reply by latencyMs
+    uint32_t latencyMs{50};
+    double splitProbability{};      ///< send reply by chunks with gaps between them
+    uint32_t splitGapMs{2};
+    double dropProbability{};       ///< do not send reply at all
+    uint32_t seed{1};
+  };
+
+  struct Counters
+  {
+    std::atomic<uint64_t> requests{};
+    std::atomic<uint64_t> replies{};
+    std::atomic<uint64_t> corrupted{};
+    std::atomic<uint64_t> truncated{};
+    std::atomic<uint64_t> delayed{};
+    std::atomic<uint64_t> split{};
+    std::atomic<uint64_t> dropped{};
+  };
+
+public:
+  FaultShim(std::string upstreamPath, Options const& options)
+    : _upstreamPath{std::move(upstreamPath)}
+    , _options{options}
+    , _random{options.seed}
+  {
+  }
+
+  ~FaultShim()
+  {
+    Stop();
+    for (auto fd : {_masterFd, _slaveFd, _upstreamFd})
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+    }
+    if (!_linkPath.empty())
+    {
+      ::unlink(_linkPath.c_str());
+    }
+  }
+
+  /**
+   * Open upstream port and client side pseudo terminal and start forwarding.
+   * @param linkPath if not empty symlink to the client side is created at this path.
+   * @return path which client should use as port path.
+   */
+  auto Start(std::string const& linkPath = {}) -> std::string
+  {
+    _upstreamFd = ::open(_upstreamPath.c_str(), O_RDWR | O_NOCTTY);
+    if (_upstreamFd < 0)
+    {
+      throw std::runtime_error("Could not open " + _upstreamPath);
+    }
+    MakeRaw(_upstreamFd);
+    _masterFd = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if ((_masterFd < 0) || (::grantpt(_masterFd) != 0) || (::unlockpt(_masterFd) != 0))
+    {
+      throw std::runtime_error("Could not open pseudo terminal");
+    }
+    std::string slavePath = ::ptsname(_masterFd);
+    _slaveFd = ::open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+    MakeRaw(_slaveFd);
+    if (!linkPath.empty())
+    {
+      ::unlink(linkPath.c_str());
+      if (::symlink(slavePath.c_str(), linkPath.c_str()) != 0)
+      {
+        throw std::runtime_error("Could not create symlink " + linkPath);
+      }
+      _linkPath = linkPath;
+    }
+    _running = true;
+    _thread = std::thread([this] { Forward(); });
+    return _linkPath.empty() ? slavePath : _linkPath;
+  }
+
+  void Stop()
+  {
+    _running = false;
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+  }
+
+  auto GetCounters() const -> Counters const&
+  {
+    return _counters;
+  }
+
+private:
+  static void MakeRaw(int fd)
+  {
+    termios tio{};
+    ::tcgetattr(fd, &tio);
+    ::cfmakeraw(&tio);
+    ::tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  bool Happens(double probability)
+  {
+    return (probability > 0.0) && (std::uniform_real_distribution<double>{0.0, 1.0}(_random) < probability);
+  }
+
+  /**
+   * Read everything which arrives until the line is silent for silenceMs.
+   */
+  static auto ReadFrame(int fd, int firstByteTimeoutMs, int silenceMs) -> std::string
+  {
+    std::string frame;
+    auto timeoutMs = firstByteTimeoutMs;
+    while (true)
+    {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, timeoutMs) <= 0)
+      {
+        return frame;
+      }
+      std::array<char, 512> chunk{};
+      auto const bytes = ::read(fd, chunk.data(), chunk.size());
+      if (bytes <= 0)
+      {
+        return frame;
+      }
+      frame.append(chunk.data(), static_cast<size_t>(bytes));
+      timeoutMs = silenceMs;
+    }
+  }
+
+  static void Write(int fd, std::string const& data)
+  {
+    size_t offset{};
+    while (offset < data.size())
+    {
+      auto const bytes = ::write(fd, data.data() + offset, data.size() - offset);
+      if (bytes <= 0)
+      {
+        return;
+      }
+      offset += static_cast<size_t>(bytes);
+    }
+  }
+
+  void Forward()
+  {
+    while (_running)
+    {
+      auto const request = ReadFrame(_masterFd, 50, 2);
+      if (request.empty())
+      {
+        continue;
+      }
+      ++_counters.requests;
+      Write(_upstreamFd, request);
+      auto reply = ReadFrame(_upstreamFd, 1000, 2);
+      if (reply.empty())
+      {
+        continue;
+      }
+      ++_counters.replies;
+      if (Happens(_options.dropProbability))
+      {
+        ++_counters.dropped;
+        continue;
+      }
+      if (Happens(_options.corruptProbability))
+      {
+        ++_counters.corrupted;
+        auto const byte = std::uniform_int_distribution<size_t>{0, reply.size() - 1}(_random);
+        auto const bit = std::uniform_int_distribution<int>{0, 7}(_random);
+        reply[byte] = static_cast<char>(reply[byte] ^ (1 << bit));
+      }
+      if ((reply.size() > 1) && Happens(_options.truncateProbability))
+      {
+        ++_counters.truncated;
+        reply.resize(std::uniform_int_distribution<size_t>{1, reply.size() - 1}(_random));
+      }
+      if (Happens(_options.latencyProbability))
+      {
+        ++_counters.delayed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(_options.latencyMs));
+      }
+      if ((reply.size() > 1) && Happens(_options.splitProbability))
+      {
+        ++_counters.split;
+        for (size_t offset = 0; offset < reply.size();)
+        {
+          auto const chunkSize = std::uniform_int_distribution<size_t>{1, reply.size() - offset}(_random);
+          Write(_masterFd, reply.substr(offset, chunkSize));
+          offset += chunkSize;
+          std::this_thread::sleep_for(std::chrono::milliseconds(_options.splitGapMs));
+        }
+        continue;
+      }
+      Write(_masterFd, reply);
+    }
+  }
+
+  std::string _upstreamPath;
+  Options _options;
+  std::mt19937 _random;
+  Counters _counters;
+  int _upstreamFd{-1};
+  int _masterFd{-1};
+  int _slaveFd{-1};
+  std::string _linkPath;
+  std::atomic<bool> _running{};
+  std::thread _thread;
+};
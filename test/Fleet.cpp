@@ -0,0 +1,217 @@
+#include <OWEN/Fleet.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <thread>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --device PORT:ADDR [options]\n"
+             << "  --device PORT:ADDR   device of the fleet, may be repeated\n"
+             << "  --baudrate BPS       line baudrate, 8N1 (default 115200)\n"
+             << "  --period MS          sample period of every port, 0 - continuously (default 1000)\n"
+             << "  --duration S         run time (default until interrupted)\n"
+             << "  --aligned MS         also read all counters at aligned ticks every MS and report their skews\n"
+             << "  --reactor MODE       port - thread per serial port (default), shared - one thread for all serial ports\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::vector<std::pair<std::string, uint16_t>> devices;
+   uint32_t baudrate{115200};
+   uint32_t periodMs{1000};
+   uint32_t durationS{};
+   uint32_t alignedMs{};
+   bool sharedReactor{};
+   try
+   {
+      for (int32_t i = 1; i < argc; ++i)
+      {
+         auto const arg = std::string{argv[i]};
+         if ((i + 1) >= argc)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         auto const value = std::string{argv[++i]};
+         auto const colon = value.rfind(':');
+         if ((arg == "--device") && (colon != std::string::npos))
+         {
+            devices.emplace_back(value.substr(0, colon), static_cast<uint16_t>(std::stoul(value.substr(colon + 1))));
+         }
+         else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--period") periodMs = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--duration") durationS = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--aligned") alignedMs = static_cast<uint32_t>(std::stoul(value));
+         else if ((arg == "--reactor") && ((value == "port") || (value == "shared"))) sharedReactor = (value == "shared");
+         else
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+      }
+   }
+   catch (std::exception const&)
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   if (devices.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   try
+   {
+      std::vector<CommunicationOptions> inventory;
+      for (auto const& device : devices)
+      {
+         auto communicationOptions = CommunicationOptions{};
+         communicationOptions.PortPath(device.first)
+                 .BaudeRate(ToBaudrate(baudrate))
+                 .Parity(CommunicationOptions::eParity::NO)
+                 .StopBits(false)
+                 .DataBits(true)
+                 .BaseAddr(device.second)
+                 .SharedReactor(sharedReactor);
+         inventory.emplace_back(communicationOptions);
+      }
+
+      // Samples per port, only touched by the callback which is never called concurrently
+      std::map<std::string, uint64_t> portSamples;
+      OWEN::Fleet fleet{inventory, std::chrono::milliseconds(periodMs)};
+      fleet.OnSamples([&](std::vector<OWEN::Fleet::Sample> const& samples) {
+         for (auto const& sample : samples)
+         {
+            ++portSamples[devices[sample.device].first];
+         }
+      });
+
+      // Skews of aligned reads per device: sum and maximum of absolute values, and spread of every tick
+      struct Skews
+      {
+         uint64_t reads{};
+         int64_t sumUs{};
+         int64_t maxUs{};
+      };
+      std::vector<Skews> skews(devices.size());
+      int64_t maxSpreadUs{};
+      uint64_t ticks{};
+
+      auto const start = std::chrono::steady_clock::now();
+      fleet.OnConnected([&](size_t device) {
+         auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+         std::cout << devices[device].first << ":" << devices[device].second << " connected in " << ms.count() << " ms" << std::endl;
+      });
+      fleet.Start();
+      while (!interrupted && ((durationS == 0) || (std::chrono::steady_clock::now() - start < std::chrono::seconds(durationS))))
+      {
+         if (alignedMs == 0)
+         {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+         }
+         // Next wall clock multiple of the period, at least 50 ms ahead for workers to complete their exchanges
+         auto const period = std::chrono::milliseconds(alignedMs);
+         auto const sinceEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 (std::chrono::system_clock::now() + std::chrono::milliseconds(50)).time_since_epoch());
+         auto const tick = std::chrono::system_clock::time_point{(sinceEpoch / period + 1) * period};
+         auto const snapshot = fleet.SampleAligned(tick);
+         if (!snapshot.has_value())
+         {
+            break;
+         }
+         int64_t minUs{std::numeric_limits<int64_t>::max()};
+         int64_t maxUs{std::numeric_limits<int64_t>::min()};
+         for (auto const& sample : snapshot->samples)
+         {
+            if (!sample.counterValue.has_value())
+            {
+               continue;
+            }
+            auto const us = static_cast<int64_t>(sample.skew.count());
+            auto& device = skews[sample.device];
+            ++device.reads;
+            device.sumUs += std::abs(us);
+            device.maxUs = std::max(device.maxUs, std::abs(us));
+            minUs = std::min(minUs, us);
+            maxUs = std::max(maxUs, us);
+         }
+         if (minUs <= maxUs)
+         {
+            ++ticks;
+            maxSpreadUs = std::max(maxSpreadUs, maxUs - minUs);
+         }
+      }
+      fleet.Stop();
+      auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      uint64_t total{};
+      for (auto const& port : portSamples)
+      {
+         std::cout << port.first << ": " << static_cast<uint64_t>(port.second / elapsed) << " samples/s" << std::endl;
+         total += port.second;
+      }
+      std::cout << "Total: " << static_cast<uint64_t>(total / elapsed) << " samples/s" << std::endl;
+
+      auto const health = fleet.GetHealth();
+      std::cout << std::left << std::setw(24) << "Device" << std::setw(8) << "Online" << std::setw(10) << "Samples"
+                << std::setw(10) << "Failures" << "Last error" << std::endl;
+      for (size_t i = 0; i < health.size(); ++i)
+      {
+         std::cout << std::setw(24) << (devices[i].first + ":" + std::to_string(devices[i].second))
+                   << std::setw(8) << (health[i].online ? "yes" : "no")
+                   << std::setw(10) << health[i].samples
+                   << std::setw(10) << health[i].failures
+                   << health[i].lastError << std::endl;
+      }
+      if (alignedMs != 0)
+      {
+         std::cout << "Aligned ticks " << ticks << ", max spread " << maxSpreadUs << " us" << std::endl;
+         std::cout << std::setw(24) << "Device" << std::setw(10) << "Reads" << std::setw(16) << "Mean |skew| us"
+                   << "Max |skew| us" << std::endl;
+         for (size_t i = 0; i < skews.size(); ++i)
+         {
+            std::cout << std::setw(24) << (devices[i].first + ":" + std::to_string(devices[i].second))
+                      << std::setw(10) << skews[i].reads
+                      << std::setw(16) << ((skews[i].reads == 0) ? 0 : skews[i].sumUs / static_cast<int64_t>(skews[i].reads))
+                      << skews[i].maxUs << std::endl;
+         }
+      }
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,98 @@
+#include "FrameLogger.hpp"
+
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+namespace {
+
+constexpr char const* OUTCOME_NAMES[] = {"ok", "timeout", "bad frame", "exception"};
+
+template <typename T>
+bool ReadValue(std::ifstream& file, T& value)
+{
+   return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void PrintTime(int64_t timeNs)
+{
+   auto const seconds = static_cast<std::time_t>(timeNs / 1000000000);
+   std::tm tm{};
+   ::localtime_r(&seconds, &tm);
+   std::cout << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(6) << std::setfill('0') << (timeNs % 1000000000) / 1000
+             << std::setfill(' ');
+}
+
+} /// end namespace anonymous
+
+/**
+ * Print frame log written by OWEN::FrameLog: time, port, direction, frame bytes and transaction outcome.
+ */
+auto main(int argc, char** argv) -> int32_t
+{
+   if (argc < 2)
+   {
+      std::cout << "Usage: " << argv[0] << " LOG_FILE" << std::endl;
+      return 1;
+   }
+   std::ifstream file{argv[1], std::ios::binary};
+   char magic[sizeof(FrameLogFormat::MAGIC)]{};
+   if (!file.read(magic, sizeof(magic)) || (std::memcmp(magic, FrameLogFormat::MAGIC, sizeof(magic)) != 0))
+   {
+      std::cout << argv[1] << " is not a frame log" << std::endl;
+      return 1;
+   }
+   std::map<uint16_t, std::string> channels;
+   FrameLogFormat::eRecord record{};
+   while (ReadValue(file, record))
+   {
+      if (record == FrameLogFormat::eRecord::CHANNEL)
+      {
+         uint16_t channel{};
+         uint16_t length{};
+         ReadValue(file, channel);
+         ReadValue(file, length);
+         std::string name(length, '\0');
+         file.read(&name[0], length);
+         channels[channel] = name;
+         continue;
+      }
+      if (record != FrameLogFormat::eRecord::FRAME)
+      {
+         std::cout << "Corrupted record at offset " << file.tellg() << std::endl;
+         return 1;
+      }
+      int64_t timeNs{};
+      uint16_t channel{};
+      FrameLogFormat::eDirection direction{};
+      FrameLogFormat::eOutcome outcome{};
+      uint16_t length{};
+      ReadValue(file, timeNs);
+      ReadValue(file, channel);
+      ReadValue(file, direction);
+      ReadValue(file, outcome);
+      ReadValue(file, length);
+      std::string frame(length, '\0');
+      if (!file.read(&frame[0], length))
+      {
+         std::cout << "Truncated frame" << std::endl;
+         return 1;
+      }
+      PrintTime(timeNs);
+      std::cout << ' ' << channels[channel] << ((direction == FrameLogFormat::eDirection::TX) ? " TX" : " RX");
+      for (auto byte : frame)
+      {
+         std::cout << ' ' << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(static_cast<uint8_t>(byte));
+      }
+      std::cout << std::dec << std::setfill(' ');
+      if ((direction == FrameLogFormat::eDirection::RX) && (static_cast<size_t>(outcome) < std::size(OUTCOME_NAMES)))
+      {
+         std::cout << "  [" << OUTCOME_NAMES[static_cast<size_t>(outcome)] << ']';
+      }
+      std::cout << '\n';
+   }
+   std::cout << std::flush;
+   return 0;
+}
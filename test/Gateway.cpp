@@ -0,0 +1,146 @@
+#include <OWEN/Gateway.hpp>
+#include <OWEN/PrometheusExporter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --device PORT:ADDR [options]\n"
+             << "  --device PORT:ADDR   counter to serve as unit ADDR, may be repeated (every port is polled by its own thread)\n"
+             << "  --baudrate BPS       line baudrate, 8N1 (default 115200)\n"
+             << "  --listen PORT        Modbus TCP port (default 502, 0 - any free port)\n"
+             << "  --period MS          poll period of every port (default 100)\n"
+             << "  --max-age MS         oldest cached image served to clients (default 5000)\n"
+             << "  --shm NAME           publish snapshots of all counters to shared memory (e.g. /owen-si30)\n"
+             << "  --metrics PORT       serve Prometheus metrics of all counters on localhost:PORT/metrics\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   using namespace std::chrono;
+
+   std::map<std::string, std::vector<uint8_t>> ports;
+   uint32_t baudrate{115200};
+   uint16_t listenPort{OWEN::Gateway::MODBUS_TCP_PORT};
+   milliseconds period{100};
+   milliseconds maxAge{5000};
+   std::string shmName;
+   std::optional<uint16_t> metricsPort;
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      if ((i + 1) >= argc)
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+      auto const value = std::string{argv[++i]};
+      if (arg == "--device")
+      {
+         auto const separator = value.rfind(':');
+         if (separator == std::string::npos)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         ports[value.substr(0, separator)].emplace_back(static_cast<uint8_t>(std::stoul(value.substr(separator + 1))));
+      }
+      else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--listen") listenPort = static_cast<uint16_t>(std::stoul(value));
+      else if (arg == "--period") period = milliseconds(std::stoul(value));
+      else if (arg == "--max-age") maxAge = milliseconds(std::stoul(value));
+      else if (arg == "--shm") shmName = value;
+      else if (arg == "--metrics") metricsPort = static_cast<uint16_t>(std::stoul(value));
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+   if (ports.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   try
+   {
+      std::vector<std::unique_ptr<OWEN::Poller>> pollers;
+      std::vector<std::reference_wrapper<OWEN::Poller>> pollerRefs;
+      for (auto const& port : ports)
+      {
+         pollers.emplace_back(std::make_unique<OWEN::Poller>(period));
+         for (auto const address : port.second)
+         {
+            auto communicationOptions = CommunicationOptions{};
+            communicationOptions.PortPath(port.first)
+                    .BaudeRate(ToBaudrate(baudrate))
+                    .Parity(CommunicationOptions::eParity::NO)
+                    .StopBits(false)
+                    .DataBits(true)
+                    .BaseAddr(address);
+            pollers.back()->Add(address, OWEN::ImpulseCounter30{communicationOptions});
+         }
+         if (!shmName.empty())
+         {
+            pollers.back()->Publish(shmName);
+         }
+         pollers.back()->Start();
+         pollerRefs.emplace_back(*pollers.back());
+      }
+      OWEN::Gateway gateway{pollerRefs, listenPort, maxAge};
+      std::cout << "Modbus TCP gateway is listening on port " << gateway.Port() << std::endl;
+      std::unique_ptr<OWEN::PrometheusExporter> exporter;
+      if (metricsPort.has_value())
+      {
+         exporter = std::make_unique<OWEN::PrometheusExporter>(pollerRefs, metricsPort.value());
+         std::cout << "Metrics are served on port " << exporter->Port() << std::endl;
+      }
+      while (!interrupted)
+      {
+         std::this_thread::sleep_for(milliseconds(100));
+      }
+      for (auto const& poller : pollers)
+      {
+         for (auto const& deviceMetrics : poller->GetMetrics())
+         {
+            std::cout << deviceMetrics << std::endl;
+         }
+      }
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
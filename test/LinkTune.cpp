@@ -0,0 +1,122 @@
+#include <OWEN/LinkTuner.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+constexpr uint32_t BAUDRATES[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --port PATH --address ADDR [options]\n"
+             << "  --port PATH          serial port of the bus, no other master may use it while tuning\n"
+             << "  --address ADDR       slave address of a counter, all counters of the bus have to be given\n"
+             << "  --baudrate BPS       current line baudrate, 8N1 (default 9600)\n"
+             << "  --max-baudrate BPS   highest baudrate to try (default 115200)\n"
+             << "  --min-delay MS       lowest DelayAnswer to try (default 0)\n"
+             << "  --reads N            reads per counter and step (default 50)\n"
+             << "  --budget PERCENT     tolerated share of failed reads (default 2)\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   auto const it = std::find(std::begin(BAUDRATES), std::end(BAUDRATES), bps);
+   if (it == std::end(BAUDRATES))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(BAUDRATES), it));
+}
+
+auto ToBps(CommunicationOptions::eBaudrate baudrate) -> uint32_t
+{
+   return BAUDRATES[static_cast<uint32_t>(baudrate)];
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::string portPath;
+   std::vector<uint8_t> addresses;
+   uint32_t baudrate{9600};
+   auto options = OWEN::LinkTuner::Options{};
+   try
+   {
+      for (int32_t i = 1; i < argc; ++i)
+      {
+         auto const arg = std::string{argv[i]};
+         if ((i + 1) >= argc)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         auto const value = std::string{argv[++i]};
+         if (arg == "--port") portPath = value;
+         else if (arg == "--address") addresses.push_back(static_cast<uint8_t>(std::stoul(value)));
+         else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--max-baudrate") options.maxBaudrate = ToBaudrate(static_cast<uint32_t>(std::stoul(value)));
+         else if (arg == "--min-delay") options.minDelayAnswerMs = static_cast<uint8_t>(std::stoul(value));
+         else if (arg == "--reads") options.burstReads = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--budget") options.errorBudget = std::stod(value) / 100;
+         else
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+      }
+   }
+   catch (std::exception const&)
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   if (portPath.empty() || addresses.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   try
+   {
+      auto communicationOptions = CommunicationOptions{};
+      communicationOptions.PortPath(portPath)
+              .BaudeRate(ToBaudrate(baudrate))
+              .Parity(CommunicationOptions::eParity::NO)
+              .StopBits(false)
+              .DataBits(true);
+      OWEN::LinkTuner tuner{communicationOptions, addresses, options};
+      std::cout << std::left << std::setw(10) << "Baudrate" << std::setw(10) << "Counter" << std::setw(8) << "Delay"
+                << std::setw(8) << "Reads" << std::setw(8) << "Errors" << std::setw(14) << "Mean RTT us" << "Result" << std::endl;
+      tuner.OnProgress([](OWEN::LinkTuner::Step const& step) {
+         std::cout << std::setw(10) << ToBps(step.baudrate)
+                   << std::setw(10) << (step.address.has_value() ? std::to_string(step.address.value()) : "all")
+                   << std::setw(8) << (step.address.has_value() ? std::to_string(step.delayAnswerMs) : "-")
+                   << std::setw(8) << step.reads
+                   << std::setw(8) << step.errors
+                   << std::setw(14) << step.meanRoundTrip.count()
+                   << (step.accepted ? "accepted" : "rolled back") << std::endl;
+      });
+      auto const result = tuner.Run();
+
+      std::cout << "Settled on " << ToBps(result.baudrate) << " bps" << (result.rolledBack ? " after rollback" : "") << std::endl;
+      for (auto const& delayAnswer : result.delayAnswerMs)
+      {
+         std::cout << "Counter " << static_cast<uint32_t>(delayAnswer.first) << ": DelayAnswer " << static_cast<uint32_t>(delayAnswer.second) << " ms" << std::endl;
+      }
+      for (auto const address : result.lost)
+      {
+         std::cout << "Counter " << static_cast<uint32_t>(address) << " is lost" << std::endl;
+      }
+      return result.lost.empty() ? 0 : 1;
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+}
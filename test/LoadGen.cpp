@@ -0,0 +1,348 @@
+#include <OWEN/ImpulseCounter30.hpp>
+#include <OWEN/FrameLog.hpp>
+#include "SI30Simulator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+enum class eOperation : size_t
+{
+   VALUE,
+   SNAPSHOT,
+   CONFIG_READ,
+   CONFIG_WRITE,
+   COUNT
+};
+
+constexpr char const* OPERATION_NAMES[] = {"value", "snapshot", "config", "write"};
+
+/**
+ * Bytes on the wire per operation (requests and responses) and count of frames (each followed by 3.5 characters of silence).
+ */
+struct WireCost
+{
+   uint32_t bytes;
+   uint32_t frames;
+};
+
+constexpr WireCost OPERATION_WIRE_COST[] = {
+   {8 + 9, 2},                       // 0x04 2 registers
+   {8 + 19, 2},                      // 0x04 7 registers
+   {(8 + 31) + (8 + 27), 4},         // 0x03 13 registers + 0x03 11 registers
+   {8 + 8, 2}                        // 0x06
+};
+
+struct DeviceSpec
+{
+   std::string portPath;
+   uint16_t address{};
+};
+
+struct OperationStats
+{
+   uint64_t count{};
+   uint64_t errors{};
+   std::vector<uint32_t> latenciesUs;
+};
+
+struct PortStats
+{
+   std::string portPath;
+   uint64_t wireBytes{};
+   uint64_t wireFrames{};
+   std::array<OperationStats, static_cast<size_t>(eOperation::COUNT)> operations{};
+};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " [options]\n"
+             << "  --device PORT:ADDR   device to load, may be repeated (ports are driven in parallel)\n"
+             << "  --simulators N       start N in-process simulator ports instead of --device (default 1)\n"
+             << "  --addresses A,B      slave addresses on every simulator port (default 16)\n"
+             << "  --baudrate BPS       line baudrate (default 115200)\n"
+             << "  --duration S         test duration in seconds (default 10)\n"
+             << "  --mix V,S,C,W        weights of value, snapshot, config read and config write (default 70,20,9,1)\n"
+             << "  --seed N             random seed of operation mix (default 1)\n"
+             << "  --frame-log PATH     log all frames\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+auto Percentile(std::vector<uint32_t>& values, double percentile) -> double
+{
+   if (values.empty())
+   {
+      return 0.0;
+   }
+   auto const index = std::min(values.size() - 1, static_cast<size_t>(percentile * values.size()));
+   std::nth_element(values.begin(), std::next(values.begin(), index), values.end());
+   return values[index] / 1000.0;
+}
+
+/**
+ * Drive all devices of one port for the given duration with random operations of the mix.
+ */
+void RunPort(std::vector<DeviceSpec> const& devices,
+             uint32_t baudrate,
+             std::array<uint32_t, static_cast<size_t>(eOperation::COUNT)> const& mix,
+             std::chrono::steady_clock::time_point finish,
+             uint32_t seed,
+             PortStats& stats)
+{
+   using namespace std::chrono;
+   std::vector<std::unique_ptr<OWEN::ImpulseCounter30>> counters;
+   std::vector<OWEN::ImpulseCounter30::CounterOptions> initialOptions;
+   for (auto const& device : devices)
+   {
+      auto communicationOptions = CommunicationOptions{};
+      communicationOptions.PortPath(device.portPath)
+              .BaudeRate(ToBaudrate(baudrate))
+              .Parity(CommunicationOptions::eParity::NO)
+              .StopBits(false)
+              .DataBits(true)
+              .BaseAddr(device.address);
+      counters.emplace_back(std::make_unique<OWEN::ImpulseCounter30>(communicationOptions));
+      // Write operation writes back the current value so device configuration is not changed
+      auto const counterOptions = counters.back()->GetCounterOptions();
+      if (!counterOptions.has_value())
+      {
+         throw std::runtime_error("Could not read counter options of " + device.portPath + ":" + std::to_string(device.address));
+      }
+      initialOptions.emplace_back(OWEN::ImpulseCounter30::CounterOptions{}.Brightness(counterOptions->_brightness.value()));
+   }
+
+   std::mt19937 random{seed};
+   std::discrete_distribution<size_t> operationDistribution{mix.cbegin(), mix.cend()};
+   for (size_t device = 0; steady_clock::now() < finish; device = (device + 1) % counters.size())
+   {
+      auto& counter = *counters[device];
+      auto const operation = static_cast<eOperation>(operationDistribution(random));
+      auto const start = steady_clock::now();
+      bool result{};
+      switch (operation)
+      {
+         case eOperation::VALUE:
+            result = counter.GetCounterValue().has_value();
+            break;
+         case eOperation::SNAPSHOT:
+            result = counter.GetSnapshot().has_value();
+            break;
+         case eOperation::CONFIG_READ:
+            result = counter.GetCounterOptions().has_value();
+            break;
+         case eOperation::CONFIG_WRITE:
+            result = counter.SetCounterOptions(initialOptions[device]);
+            break;
+         default:
+            break;
+      }
+      auto const latency = duration_cast<microseconds>(steady_clock::now() - start);
+      auto& operationStats = stats.operations[static_cast<size_t>(operation)];
+      ++operationStats.count;
+      operationStats.errors += result ? 0 : 1;
+      operationStats.latenciesUs.emplace_back(static_cast<uint32_t>(latency.count()));
+      stats.wireBytes += OPERATION_WIRE_COST[static_cast<size_t>(operation)].bytes;
+      stats.wireFrames += OPERATION_WIRE_COST[static_cast<size_t>(operation)].frames;
+   }
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   using namespace std::chrono;
+
+   std::vector<DeviceSpec> devices;
+   uint32_t simulators{1};
+   std::vector<uint8_t> simulatorAddresses{16};
+   uint32_t baudrate{115200};
+   uint32_t durationS{10};
+   uint32_t seed{1};
+   std::string frameLogPath;
+   std::array<uint32_t, static_cast<size_t>(eOperation::COUNT)> mix{70, 20, 9, 1};
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      if ((i + 1) >= argc)
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+      auto const value = std::string{argv[++i]};
+      if (arg == "--device")
+      {
+         auto const separator = value.rfind(':');
+         if (separator == std::string::npos)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         devices.emplace_back(DeviceSpec{value.substr(0, separator), static_cast<uint16_t>(std::stoul(value.substr(separator + 1)))});
+      }
+      else if (arg == "--simulators") simulators = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--addresses")
+      {
+         simulatorAddresses.clear();
+         std::stringstream addresses{value};
+         for (std::string address; std::getline(addresses, address, ',');)
+         {
+            simulatorAddresses.emplace_back(static_cast<uint8_t>(std::stoul(address)));
+         }
+      }
+      else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--duration") durationS = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--seed") seed = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--frame-log") frameLogPath = value;
+      else if (arg == "--mix")
+      {
+         std::stringstream weights{value};
+         size_t index{};
+         for (std::string weight; std::getline(weights, weight, ',') && (index < mix.size()); ++index)
+         {
+            mix[index] = static_cast<uint32_t>(std::stoul(weight));
+         }
+      }
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+
+   if (!frameLogPath.empty() && !OWEN::FrameLog::Open(frameLogPath))
+   {
+      std::cout << "Could not open " << frameLogPath << std::endl;
+      return 1;
+   }
+
+   std::vector<std::unique_ptr<SI30Simulator>> simulatorInstances;
+   if (devices.empty())
+   {
+      for (uint32_t i = 0; i < simulators; ++i)
+      {
+         auto simulatorOptions = SI30Simulator::Options{};
+         simulatorOptions.addresses = simulatorAddresses;
+         simulatorOptions.baudrate = static_cast<uint8_t>(ToBaudrate(baudrate));
+         simulatorInstances.emplace_back(std::make_unique<SI30Simulator>(simulatorOptions));
+         auto const portPath = simulatorInstances.back()->Start();
+         for (auto address : simulatorAddresses)
+         {
+            devices.emplace_back(DeviceSpec{portPath, address});
+         }
+      }
+   }
+
+   std::map<std::string, std::vector<DeviceSpec>> ports;
+   for (auto const& device : devices)
+   {
+      ports[device.portPath].emplace_back(device);
+   }
+
+   std::vector<PortStats> portStats(ports.size());
+   std::vector<std::thread> workers;
+   std::mutex errorMutex;
+   std::string error;
+   auto const start = steady_clock::now();
+   auto const finish = start + seconds(durationS);
+   size_t portIndex{};
+   for (auto const& port : ports)
+   {
+      auto& stats = portStats[portIndex];
+      stats.portPath = port.first;
+      workers.emplace_back([&, portSeed = seed + static_cast<uint32_t>(portIndex)] {
+         try
+         {
+            RunPort(port.second, baudrate, mix, finish, portSeed, stats);
+         }
+         catch (std::exception const& ex)
+         {
+            std::lock_guard<std::mutex> lock{errorMutex};
+            error = ex.what();
+         }
+      });
+      ++portIndex;
+   }
+   for (auto& worker : workers)
+   {
+      worker.join();
+   }
+   if (!error.empty())
+   {
+      std::cout << "Error: " << error << std::endl;
+      return 1;
+   }
+   auto const elapsedS = duration<double>(steady_clock::now() - start).count();
+   OWEN::FrameLog::Close();
+
+   // 8N1: start bit, 8 data bits and stop bit
+   constexpr double BITS_PER_CHARACTER = 10.0;
+   constexpr double SILENCE_CHARACTERS = 3.5;
+   std::cout << std::dec << std::fixed << std::setprecision(2)
+             << "ports: " << ports.size() << ", devices: " << devices.size() << ", duration: " << elapsedS << " s\n\n"
+             << std::left << std::setw(10) << "operation" << std::right << std::setw(10) << "count" << std::setw(10) << "errors"
+             << std::setw(12) << "ops/s" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "p999 ms" << '\n';
+   uint64_t totalCount{};
+   uint64_t totalErrors{};
+   for (size_t operation = 0; operation < static_cast<size_t>(eOperation::COUNT); ++operation)
+   {
+      OperationStats merged;
+      for (auto& stats : portStats)
+      {
+         auto& operationStats = stats.operations[operation];
+         merged.count += operationStats.count;
+         merged.errors += operationStats.errors;
+         merged.latenciesUs.insert(merged.latenciesUs.end(), operationStats.latenciesUs.cbegin(), operationStats.latenciesUs.cend());
+      }
+      totalCount += merged.count;
+      totalErrors += merged.errors;
+      std::cout << std::left << std::setw(10) << OPERATION_NAMES[operation] << std::right
+                << std::setw(10) << merged.count << std::setw(10) << merged.errors
+                << std::setw(12) << (merged.count / elapsedS)
+                << std::setw(12) << Percentile(merged.latenciesUs, 0.5)
+                << std::setw(12) << Percentile(merged.latenciesUs, 0.99)
+                << std::setw(12) << Percentile(merged.latenciesUs, 0.999) << '\n';
+   }
+   std::cout << std::left << std::setw(10) << "total" << std::right << std::setw(10) << totalCount << std::setw(10) << totalErrors
+             << std::setw(12) << (totalCount / elapsedS) << "\n\n";
+
+   for (auto const& stats : portStats)
+   {
+      uint64_t transactions{};
+      for (auto const& operationStats : stats.operations)
+      {
+         transactions += operationStats.count;
+      }
+      auto const wireS = (stats.wireBytes + stats.wireFrames * SILENCE_CHARACTERS) * BITS_PER_CHARACTER / baudrate;
+      // Transactions per second if the line carried nothing but frames and mandatory silence of this mix
+      auto const wireRate = (wireS > 0.0) ? (transactions / wireS) : 0.0;
+      std::cout << stats.portPath << ": " << (transactions / elapsedS) << " ops/s, bus utilization "
+                << (100.0 * wireS / elapsedS) << "%, wire-rate limit " << wireRate << " ops/s\n";
+   }
+   if (!frameLogPath.empty())
+   {
+      std::cout << "frame log dropped: " << OWEN::FrameLog::Dropped() << '\n';
+   }
+   std::cout << std::flush;
+   return (totalErrors == 0) ? 0 : 2;
+}
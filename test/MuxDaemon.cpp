@@ -0,0 +1,104 @@
+#include <OWEN/MuxServer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --port PATH [options]\n"
+             << "  --port PATH          port to own, may be repeated; clients use mux://SOCKET#PATH as port path\n"
+             << "  --socket PATH        Unix domain socket of the daemon (default /tmp/owen-mux.sock)\n"
+             << "  --baudrate BPS       line baudrate, 8N1 (default 115200)\n"
+             << "  --reactor MODE       port - thread per serial port (default), shared - one thread for all serial ports\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::vector<std::string> portPaths;
+   std::string socketPath{"/tmp/owen-mux.sock"};
+   uint32_t baudrate{115200};
+   bool sharedReactor{};
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      if ((i + 1) >= argc)
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+      auto const value = std::string{argv[++i]};
+      if (arg == "--port") portPaths.emplace_back(value);
+      else if (arg == "--socket") socketPath = value;
+      else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+      else if ((arg == "--reactor") && ((value == "port") || (value == "shared"))) sharedReactor = (value == "shared");
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+   if (portPaths.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   try
+   {
+      std::vector<CommunicationOptions> ports;
+      for (auto const& portPath : portPaths)
+      {
+         auto communicationOptions = CommunicationOptions{};
+         communicationOptions.PortPath(portPath)
+                 .BaudeRate(ToBaudrate(baudrate))
+                 .Parity(CommunicationOptions::eParity::NO)
+                 .StopBits(false)
+                 .DataBits(true)
+                 .SharedReactor(sharedReactor);
+         ports.emplace_back(communicationOptions);
+      }
+      OWEN::MuxServer server{socketPath, ports};
+      for (auto const& portPath : portPaths)
+      {
+         std::cout << "Serving mux://" << socketPath << "#" << portPath << std::endl;
+      }
+      while (!interrupted)
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      auto const counters = server.GetCounters();
+      std::cout << "Connections " << counters.connections << ", requests " << counters.requests
+                << ", transactions " << counters.transactions << ", coalesced " << counters.coalesced << std::endl;
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -1,5 +1,4 @@
 #include <OWEN/ImpulseCounter30.hpp>
-#include "TimeMeasuring.hpp"
 
 #include <iostream>
 #include <thread>
@@ -14,6 +13,10 @@ auto main(int argc, char** argv) -> int32_t
            .StopBits(false)
            .DataBits(true)
            .BaseAddr(16);
+   if (argc > 2)
+   {
+     communicationOptions.CapturePath(argv[2]);
+   }
    auto impulseCounter = OWEN::ImpulseCounter30{communicationOptions};
    auto const communicationOptionsGotten = impulseCounter.GetCommunicationOptions();
    if (communicationOptionsGotten.has_value())
@@ -36,15 +39,21 @@ auto main(int argc, char** argv) -> int32_t
    }
 
    auto file = std::ofstream("testOVENSI30_.txt");
-   while(1)
+   for (uint64_t iteration = 1;; ++iteration)
    {
-     TAKEN_TIME();
      auto counterValue = impulseCounter.GetCounterValue().value();
      auto counterEU = impulseCounter.GetCounterEU().value();
      std::cout << "Counter EU:" << std::dec << counterEU << std::endl;
      std::cout << "Counter value: " << std::dec << counterValue << std::endl;
      //std::this_thread::sleep_for(std::chrono::milliseconds(500));
      file << counterEU << '\t' << counterValue << std::endl;
+     if ((iteration % 100) == 0)
+     {
+       for (auto const& deviceMetrics : impulseCounter.GetMetrics())
+       {
+         std::cout << deviceMetrics << std::endl;
+       }
+     }
    }
    return 0;
 }
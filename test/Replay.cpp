@@ -0,0 +1,72 @@
+#include "CaptureReplay.hpp"
+
+#include <csignal>
+#include <iostream>
+
+namespace {
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --capture PATH [options]\n"
+             << "  --capture PATH       capture file recorded with CommunicationOptions::CapturePath\n"
+             << "  --link PATH          symlink to the slave side of pseudo terminal (default /tmp/ttySI30)\n"
+             << "  --speed X            timing acceleration, 0 - reply immediately (default 1 - original timing)\n"
+             << "  --loop               start from the beginning when capture is over\n";
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::string capturePath;
+   std::string linkPath{"/tmp/ttySI30"};
+   auto options = CaptureReplay::Options{};
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      auto const hasValue = (i + 1) < argc;
+      if ((arg == "--capture") && hasValue)
+      {
+         capturePath = argv[++i];
+      }
+      else if ((arg == "--link") && hasValue)
+      {
+         linkPath = argv[++i];
+      }
+      else if ((arg == "--speed") && hasValue)
+      {
+         options.speed = std::stod(argv[++i]);
+      }
+      else if (arg == "--loop")
+      {
+         options.loop = true;
+      }
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+   if (capturePath.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   auto replay = CaptureReplay{capturePath, options};
+   auto const portPath = replay.Start(linkPath);
+   std::cout << "Replaying " << replay.Exchanges().size() << " exchanges on " << portPath << std::endl;
+   while (!interrupted && !replay.IsFinished())
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   }
+   auto const& counters = replay.GetCounters();
+   std::cout << "Requests " << counters.requests << ", replayed " << counters.replayed
+             << ", skipped " << counters.skipped << ", unmatched " << counters.unmatched << std::endl;
+   return (counters.unmatched == 0) ? 0 : 2;
+}
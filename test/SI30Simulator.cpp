@@ -0,0 +1,120 @@
+#include "SI30Simulator.hpp"
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " [options]\n"
+             << "  --link PATH          symlink to the slave side of pseudo terminal (default /tmp/ttySI30)\n"
+             << "  --address A[,B...]   slave addresses of emulated devices (default 16)\n"
+             << "  --frequency HZ       pulse generator frequency (default 100)\n"
+             << "  --delay-answer MS    initial DelayAnswer register value (default 0)\n"
+             << "  --baudrate INDEX     initial baudrate register value, eBaudrate index (default 8 - 115200bps)\n"
+             << "  --no-wire-time       do not delay replies by wire time\n"
+             << "  --reliable-baudrate INDEX lose half of the replies above this baudrate index (default 8)\n"
+             << "  --reliable-delay MS  lose half of the replies with shorter DelayAnswer (default 0)\n"
+             << "  --check-baudrate     ignore requests sent with another baudrate than the device's\n"
+             << "  --line-stop-ms MS    OUT1 stops the pulses of the line after MS of coasting, reset restarts them\n"
+             << "  --no-0x17            reply to function 0x17 with ILLEGAL FUNCTION exception\n"
+             << "  --tcp PORT           also listen for Modbus TCP clients on loopback port\n"
+             << "  --rtu-tcp PORT       also listen for RTU over TCP clients on loopback port\n";
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   auto options = SI30Simulator::Options{};
+   std::string linkPath{"/tmp/ttySI30"};
+   std::optional<std::pair<uint16_t, SI30Simulator::eTcpFraming>> tcp;
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      auto const hasValue = (i + 1) < argc;
+      if ((arg == "--link") && hasValue)
+      {
+         linkPath = argv[++i];
+      }
+      else if ((arg == "--address") && hasValue)
+      {
+         options.addresses.clear();
+         std::stringstream addresses{argv[++i]};
+         for (std::string address; std::getline(addresses, address, ',');)
+         {
+            options.addresses.emplace_back(static_cast<uint8_t>(std::stoul(address)));
+         }
+      }
+      else if ((arg == "--frequency") && hasValue)
+      {
+         options.pulseFrequencyHz = std::stod(argv[++i]);
+      }
+      else if ((arg == "--delay-answer") && hasValue)
+      {
+         options.delayAnswerMs = static_cast<uint8_t>(std::stoul(argv[++i]));
+      }
+      else if ((arg == "--baudrate") && hasValue)
+      {
+         options.baudrate = static_cast<uint8_t>(std::stoul(argv[++i]));
+      }
+      else if ((arg == "--reliable-baudrate") && hasValue)
+      {
+         options.maxReliableBaudrate = static_cast<uint8_t>(std::stoul(argv[++i]));
+      }
+      else if ((arg == "--reliable-delay") && hasValue)
+      {
+         options.minReliableDelayAnswerMs = static_cast<uint8_t>(std::stoul(argv[++i]));
+      }
+      else if ((arg == "--line-stop-ms") && hasValue)
+      {
+         options.lineStopMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+      }
+      else if (arg == "--check-baudrate")
+      {
+         options.checkLineBaudrate = true;
+      }
+      else if (arg == "--no-wire-time")
+      {
+         options.emulateWireTime = false;
+      }
+      else if (arg == "--no-0x17")
+      {
+         options.readWriteMultipleSupported = false;
+      }
+      else if (((arg == "--tcp") || (arg == "--rtu-tcp")) && hasValue)
+      {
+         tcp = std::make_pair(static_cast<uint16_t>(std::stoul(argv[++i])),
+                              (arg == "--tcp") ? SI30Simulator::eTcpFraming::MODBUS_TCP : SI30Simulator::eTcpFraming::RTU_OVER_TCP);
+      }
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   auto simulator = SI30Simulator{options};
+   auto const portPath = simulator.Start(linkPath);
+   std::cout << "SI30 simulator is listening on " << portPath << std::endl;
+   if (tcp.has_value())
+   {
+      auto const port = simulator.StartTcp(tcp->first, tcp->second);
+      std::cout << "SI30 simulator is listening on "
+                << ((tcp->second == SI30Simulator::eTcpFraming::MODBUS_TCP) ? "tcp" : "rtutcp") << "://127.0.0.1:" << port << std::endl;
+   }
+   while (!interrupted)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   }
+   std::cout << "Served " << simulator.Requests() << " requests" << std::endl;
+   return 0;
+}
@@ -0,0 +1,724 @@
+#pragma once
+
+#include "crc16.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * Emulation of OWEN SI30 slaves behind a pseudo terminal or behind an Ethernet gateway (TCP on loopback).
+ * Register map is the same as used by ImpulseCounter30: holding registers 0x0000-0x001E (communication and
+ * counter options), input registers 0x0000-0x000A, coils 0x0000-0x0004 and discrete inputs 0x0000-0x0001.
+ */
+class SI30Simulator
+{
+public:
+  struct Options
+  {
+    std::vector<uint8_t> addresses{16};
+    double pulseFrequencyHz{100.0};   ///< pulses generated on the counter input while counter is started
+    uint8_t delayAnswerMs{0};         ///< initial value of DelayAnswer register
+    uint8_t baudrate{8};              ///< initial value of baudrate register (eBaudrate), used for wire time emulation
+    bool emulateWireTime{true};       ///< delay reply by time which request and reply take on the wire
+    bool readWriteMultipleSupported{true};
+    uint8_t maxReliableBaudrate{8};       ///< above it half of the replies are lost, as on a cable which can not carry the rate
+    uint8_t minReliableDelayAnswerMs{0};  ///< below it half of the replies are lost, as the master still drives the line
+    bool checkLineBaudrate{false};        ///< ignore requests the master sent with another baudrate than the device's
+    std::optional<uint32_t> lineStopMs;   ///< OUT1 stops the line (the pulse generator), which coasts this long; reset restarts it
+  };
+
+  enum class eTcpFraming
+  {
+    MODBUS_TCP,     ///< Modbus TCP gateway: MBAP header, unit id is the slave address
+    RTU_OVER_TCP    ///< transparent gateway: RTU frames in TCP stream
+  };
+
+  static constexpr uint16_t HOLDING_COUNT = 0x001F;
+  static constexpr uint16_t INPUT_COUNT = 0x000B;
+  static constexpr uint16_t COIL_COUNT = 0x0005;
+  static constexpr uint16_t DISCRETE_INPUT_COUNT = 0x0002;
+
+  class Device
+  {
+  public:
+    Device(uint8_t address, Options const& options)
+      : _pulseFrequencyHz{options.pulseFrequencyHz}
+      , _lineStopMs{options.lineStopMs}
+      , _startTime{std::chrono::steady_clock::now()}
+    {
+      _holding[0x0000] = options.baudrate;
+      _holding[0x0001] = 1;                      // 8 data bits
+      _holding[0x0005] = address;
+      _holding[0x0006] = options.delayAnswerMs;
+      _holding[0x0015] = 0;                      // Multiplexer = 1
+      _holding[0x0016] = 1;
+      _holding[0x0017] = 10000;                  // MaxFreq
+      _holding[0x0018] = 0;                      // MinControl = 1
+      _holding[0x0019] = 1;
+      _holding[0x001C] = 2;                      // Brightness
+      _coils[0x0004] = true;                     // counter is started
+    }
+
+    auto Holding() -> std::array<uint16_t, HOLDING_COUNT>&
+    {
+      return _holding;
+    }
+
+    auto DelayAnswerMs() const -> uint16_t
+    {
+      return _holding[0x0006];
+    }
+
+    auto Baudrate() const -> uint16_t
+    {
+      return _holding[0x0000];
+    }
+
+    auto BaudrateBps() const -> uint32_t
+    {
+      static constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+      return (_holding[0x0000] < 9) ? baudrates[_holding[0x0000]] : 115200;
+    }
+
+    auto Input() -> std::array<uint16_t, INPUT_COUNT>
+    {
+      Update();
+      auto const eu = static_cast<int32_t>(static_cast<int64_t>(_counter) * Get32(0x0015) /
+                                           static_cast<int64_t>(std::pow(10, _holding[0x0014])));
+      std::array<uint16_t, INPUT_COUNT> input{};
+      input[0x0000] = static_cast<uint16_t>(static_cast<uint32_t>(_counter) >> 16);
+      input[0x0001] = static_cast<uint16_t>(static_cast<uint32_t>(_counter) & 0xFFFF);
+      input[0x0002] = static_cast<uint16_t>(static_cast<uint32_t>(eu) >> 16);
+      input[0x0003] = static_cast<uint16_t>(static_cast<uint32_t>(eu) & 0xFFFF);
+      input[0x0004] = _coils[0x0004] ? 1 : 0;
+      input[0x0005] = _coils[0x0003] ? 2 : 0;
+      input[0x0006] = 0;
+      input[0x0007] = ('S' << 8) | 'I';
+      input[0x0008] = ('3' << 8) | '0';
+      input[0x0009] = ('V' << 8) | '1';
+      input[0x000A] = ('.' << 8) | '0';
+      return input;
+    }
+
+    auto Coils() -> std::array<bool, COIL_COUNT>
+    {
+      Update();
+      auto coils = _coils;
+      coils[0x0000] = _counter >= static_cast<int32_t>(Get32(0x000C));
+      coils[0x0001] = _counter >= static_cast<int32_t>(Get32(0x000E));
+      return coils;
+    }
+
+    auto DiscreteInputs() const -> std::array<bool, DISCRETE_INPUT_COUNT>
+    {
+      return {};
+    }
+
+    void ForceCoil(uint16_t address, bool isOn)
+    {
+      Update();
+      if ((address == 0x0002) && isOn)
+      {
+        _counter = 0;
+        _pulsesFraction = 0.0;
+        _lineStopAt.reset();
+        return;
+      }
+      _coils[address] = isOn;
+    }
+
+  private:
+    auto Get32(uint16_t address) const -> uint32_t
+    {
+      return (static_cast<uint32_t>(_holding[address]) << 16) | _holding[address + 1];
+    }
+
+    void Update()
+    {
+      auto const now = std::chrono::steady_clock::now();
+      auto const start = _startTime;
+      auto elapsed = std::chrono::duration<double>(now - start).count();
+      _startTime = now;
+      if (!_coils[0x0004])
+      {
+        return;
+      }
+      if (_lineStopMs.has_value())
+      {
+        // OUT1 switches on when the counter reaches set point 1, pulses of the coasting line are still counted
+        if (!_lineStopAt.has_value())
+        {
+          auto const toSetPoint = static_cast<int32_t>(Get32(0x000C)) - _counter - _pulsesFraction;
+          if (toSetPoint <= (elapsed * _pulseFrequencyHz))
+          {
+            auto const reached = std::chrono::duration<double>(std::max(0.0, toSetPoint) / _pulseFrequencyHz);
+            _lineStopAt = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(reached) +
+                          std::chrono::milliseconds(_lineStopMs.value());
+          }
+        }
+        if (_lineStopAt.has_value())
+        {
+          elapsed = std::clamp(std::chrono::duration<double>(_lineStopAt.value() - start).count(), 0.0, elapsed);
+        }
+      }
+      _pulsesFraction += elapsed * _pulseFrequencyHz;
+      auto const pulses = static_cast<int32_t>(_pulsesFraction);
+      _pulsesFraction -= pulses;
+      auto const backward = (_holding[0x0008] == 1) || (_holding[0x0008] == 4);
+      _counter += backward ? -pulses : pulses;
+    }
+
+    double _pulseFrequencyHz{};
+    std::optional<uint32_t> _lineStopMs;
+    std::optional<std::chrono::steady_clock::time_point> _lineStopAt;
+    std::chrono::steady_clock::time_point _startTime;
+    double _pulsesFraction{};
+    int32_t _counter{};
+    std::array<uint16_t, HOLDING_COUNT> _holding{};
+    std::array<bool, COIL_COUNT> _coils{};
+  };
+
+public:
+  explicit SI30Simulator(Options options)
+    : _options{std::move(options)}
+  {
+    for (auto address : _options.addresses)
+    {
+      _devices.emplace(address, Device{address, _options});
+    }
+  }
+
+  ~SI30Simulator()
+  {
+    Stop();
+    if (_listenFd >= 0)
+    {
+      ::close(_listenFd);
+    }
+    if (_slaveFd >= 0)
+    {
+      ::close(_slaveFd);
+    }
+    if (_masterFd >= 0)
+    {
+      ::close(_masterFd);
+    }
+    if (!_linkPath.empty())
+    {
+      ::unlink(_linkPath.c_str());
+    }
+  }
+
+  /**
+   * Open pseudo terminal pair and start serving requests in background thread.
+   * @param linkPath if not empty symlink to the slave side is created at this path.
+   * @return path of the slave side which should be used as port path.
+   */
+  auto Start(std::string const& linkPath = {}) -> std::string
+  {
+    _masterFd = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if ((_masterFd < 0) || (::grantpt(_masterFd) != 0) || (::unlockpt(_masterFd) != 0))
+    {
+      throw std::runtime_error("Could not open pseudo terminal");
+    }
+    std::string slavePath = ::ptsname(_masterFd);
+    // Slave side is kept open so master does not get EIO between client sessions
+    _slaveFd = ::open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+    termios tio{};
+    ::tcgetattr(_slaveFd, &tio);
+    ::cfmakeraw(&tio);
+    ::tcsetattr(_slaveFd, TCSANOW, &tio);
+    if (!linkPath.empty())
+    {
+      ::unlink(linkPath.c_str());
+      if (::symlink(slavePath.c_str(), linkPath.c_str()) != 0)
+      {
+        throw std::runtime_error("Could not create symlink " + linkPath);
+      }
+      _linkPath = linkPath;
+    }
+    _running = true;
+    _thread = std::thread([this] { Serve(_masterFd); });
+    return _linkPath.empty() ? slavePath : _linkPath;
+  }
+
+  /**
+   * Listen on loopback and serve every accepted connection in its own thread, like an Ethernet-RS485 gateway.
+   * Modbus TCP requests are served in order, so clients may pipeline them.
+   * @param port TCP port, 0 - any free port.
+   * @return port which is listened.
+   */
+  auto StartTcp(uint16_t port, eTcpFraming framing) -> uint16_t
+  {
+    _listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse{1};
+    ::setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t addressSize = sizeof(address);
+    if ((_listenFd < 0) ||
+        (::bind(_listenFd, reinterpret_cast<sockaddr*>(&address), addressSize) != 0) ||
+        (::listen(_listenFd, 8) != 0) ||
+        (::getsockname(_listenFd, reinterpret_cast<sockaddr*>(&address), &addressSize) != 0))
+    {
+      throw std::runtime_error("Could not listen on port " + std::to_string(port));
+    }
+    _running = true;
+    _acceptThread = std::thread([this, framing] {
+      while (_running)
+      {
+        pollfd pfd{_listenFd, POLLIN, 0};
+        if (::poll(&pfd, 1, 50) <= 0)
+        {
+          continue;
+        }
+        auto const fd = ::accept(_listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+          continue;
+        }
+        int noDelay{1};
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        std::lock_guard<std::mutex> lock{_connectionsMutex};
+        _connections.emplace_back([this, fd, framing] {
+          if (framing == eTcpFraming::MODBUS_TCP)
+          {
+            ServeModbusTcp(fd);
+          }
+          else
+          {
+            Serve(fd);
+          }
+          ::close(fd);
+        });
+      }
+    });
+    return ntohs(address.sin_port);
+  }
+
+  void Stop()
+  {
+    _running = false;
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+    if (_acceptThread.joinable())
+    {
+      _acceptThread.join();
+    }
+    std::lock_guard<std::mutex> lock{_connectionsMutex};
+    for (auto& connection : _connections)
+    {
+      connection.join();
+    }
+    _connections.clear();
+  }
+
+  auto Requests() const -> uint64_t
+  {
+    return _requests;
+  }
+
+  /**
+   * Process one complete RTU frame.
+   * @return reply frame or nullopt if frame should be ignored (bad crc, other address or broadcast).
+   */
+  auto Process(std::string const& frame) -> std::optional<std::string>
+  {
+    if ((frame.size() < 4) || !CheckCrc(frame))
+    {
+      return {};
+    }
+    std::lock_guard<std::mutex> lock{_processMutex};
+    auto const address = static_cast<uint8_t>(frame[0]);
+    if (address == 0)
+    {
+      for (auto& device : _devices)
+      {
+        Execute(device.second, frame);
+      }
+      return {};
+    }
+    auto const device = _devices.find(address);
+    if (device == _devices.end())
+    {
+      return {};
+    }
+    ++_requests;
+    return Execute(device->second, frame);
+  }
+
+  auto Devices() -> std::map<uint8_t, Device>&
+  {
+    return _devices;
+  }
+
+  /**
+   * Expected length of request frame or 0 if it is not known yet.
+   */
+  static auto RequestLength(std::string const& buffer) -> size_t
+  {
+    if (buffer.size() < 2)
+    {
+      return 0;
+    }
+    switch (static_cast<uint8_t>(buffer[1]))
+    {
+      case 0x01:
+      case 0x02:
+      case 0x03:
+      case 0x04:
+      case 0x05:
+      case 0x06:
+        return 8;
+      case 0x10:
+        return (buffer.size() < 7) ? 0 : (9 + static_cast<uint8_t>(buffer[6]));
+      case 0x17:
+        return (buffer.size() < 11) ? 0 : (13 + static_cast<uint8_t>(buffer[10]));
+      default:
+        return buffer.size();
+    }
+  }
+
+  static auto AppendCrc(std::string frame) -> std::string
+  {
+    auto const crc16 = Crc16(reinterpret_cast<uint8_t const*>(frame.data()), frame.size());
+    frame += static_cast<char>(crc16 >> 8);
+    frame += static_cast<char>(crc16 & 0xFF);
+    return frame;
+  }
+
+  static bool CheckCrc(std::string const& frame)
+  {
+    auto const crc16 = Crc16(reinterpret_cast<uint8_t const*>(frame.data()), frame.size() - 2);
+    return (static_cast<uint8_t>(frame[frame.size() - 2]) == (crc16 >> 8)) &&
+           (static_cast<uint8_t>(frame.back()) == (crc16 & 0xFF));
+  }
+
+private:
+  static auto Get16(std::string const& frame, size_t offset) -> uint16_t
+  {
+    return static_cast<uint16_t>((static_cast<uint8_t>(frame[offset]) << 8) | static_cast<uint8_t>(frame[offset + 1]));
+  }
+
+  static void Put16(std::string& frame, uint16_t value)
+  {
+    frame += static_cast<char>(value >> 8);
+    frame += static_cast<char>(value & 0xFF);
+  }
+
+  static auto Exception(std::string const& frame, uint8_t code) -> std::string
+  {
+    return AppendCrc(std::string{frame[0], static_cast<char>(frame[1] | 0x80), static_cast<char>(code)});
+  }
+
+  template <typename Values>
+  static auto ReadBits(std::string const& frame, Values const& values) -> std::string
+  {
+    auto const start = Get16(frame, 2);
+    auto const count = Get16(frame, 4);
+    if ((count == 0) || ((start + count) > values.size()))
+    {
+      return Exception(frame, 0x02);
+    }
+    std::string reply{frame[0], frame[1], static_cast<char>((count + 7) / 8)};
+    reply.append((count + 7) / 8, '\0');
+    for (uint16_t i = 0; i < count; ++i)
+    {
+      if (values[start + i])
+      {
+        reply[3 + i / 8] = static_cast<char>(reply[3 + i / 8] | (1 << (i % 8)));
+      }
+    }
+    return AppendCrc(reply);
+  }
+
+  template <typename Values>
+  static auto ReadRegisters(std::string const& frame, Values const& values, uint16_t start, uint16_t count) -> std::string
+  {
+    if ((count == 0) || ((start + count) > values.size()))
+    {
+      return Exception(frame, 0x02);
+    }
+    std::string reply{frame[0], frame[1], static_cast<char>(count * 2)};
+    for (uint16_t i = 0; i < count; ++i)
+    {
+      Put16(reply, values[start + i]);
+    }
+    return AppendCrc(reply);
+  }
+
+  static bool WriteRegisters(Device& device, std::string const& frame, uint16_t start, uint16_t count, size_t valuesOffset)
+  {
+    if ((count == 0) || ((start + count) > HOLDING_COUNT) || (frame.size() < (valuesOffset + count * 2 + 2)))
+    {
+      return false;
+    }
+    for (uint16_t i = 0; i < count; ++i)
+    {
+      device.Holding()[start + i] = Get16(frame, valuesOffset + i * 2);
+    }
+    return true;
+  }
+
+  auto Execute(Device& device, std::string const& frame) -> std::string
+  {
+    auto const function = static_cast<uint8_t>(frame[1]);
+    switch (function)
+    {
+      case 0x01:
+        return ReadBits(frame, device.Coils());
+      case 0x02:
+        return ReadBits(frame, device.DiscreteInputs());
+      case 0x03:
+        return ReadRegisters(frame, device.Holding(), Get16(frame, 2), Get16(frame, 4));
+      case 0x04:
+        return ReadRegisters(frame, device.Input(), Get16(frame, 2), Get16(frame, 4));
+      case 0x05:
+      {
+        auto const address = Get16(frame, 2);
+        auto const value = Get16(frame, 4);
+        if (address >= COIL_COUNT)
+        {
+          return Exception(frame, 0x02);
+        }
+        if ((value != 0xFF00) && (value != 0x0000))
+        {
+          return Exception(frame, 0x03);
+        }
+        device.ForceCoil(address, value == 0xFF00);
+        return frame;
+      }
+      case 0x06:
+        if (!WriteRegisters(device, frame, Get16(frame, 2), 1, 4))
+        {
+          return Exception(frame, 0x02);
+        }
+        return frame;
+      case 0x10:
+        if (!WriteRegisters(device, frame, Get16(frame, 2), Get16(frame, 4), 7))
+        {
+          return Exception(frame, 0x02);
+        }
+        return AppendCrc(frame.substr(0, 6));
+      case 0x17:
+        if (!_options.readWriteMultipleSupported)
+        {
+          return Exception(frame, 0x01);
+        }
+        if (!WriteRegisters(device, frame, Get16(frame, 6), Get16(frame, 8), 11))
+        {
+          return Exception(frame, 0x02);
+        }
+        return ReadRegisters(frame, device.Holding(), Get16(frame, 2), Get16(frame, 4));
+      default:
+        return Exception(frame, 0x01);
+    }
+  }
+
+  /**
+   * True if the master side of the pseudo terminal (which shares termios with the slave side) is set to the baudrate
+   * of the addressed device, a real device can not decode frames sent with another one.
+   */
+  bool IsLineBaudrate(int fd, std::string const& frame)
+  {
+    std::lock_guard<std::mutex> lock{_processMutex};
+    auto const it = _devices.find(static_cast<uint8_t>(frame[0]));
+    termios tio{};
+    if ((it == _devices.end()) || (::tcgetattr(fd, &tio) != 0))
+    {
+      return true;
+    }
+    switch (::cfgetospeed(&tio))
+    {
+      case B2400: return it->second.BaudrateBps() == 2400;
+      case B4800: return it->second.BaudrateBps() == 4800;
+      case B9600: return it->second.BaudrateBps() == 9600;
+      case B19200: return it->second.BaudrateBps() == 19200;
+      case B38400: return it->second.BaudrateBps() == 38400;
+      case B57600: return it->second.BaudrateBps() == 57600;
+      case B115200: return it->second.BaudrateBps() == 115200;
+      default: return false;
+    }
+  }
+
+  /**
+   * Process request and wait answer delay (and wire time) of the device before it may be sent.
+   */
+  auto Reply(std::string const& frame) -> std::optional<std::string>
+  {
+    auto const reply = Process(frame);
+    if (!reply.has_value())
+    {
+      return {};
+    }
+    auto& device = _devices.at(static_cast<uint8_t>(frame[0]));
+    // The request is processed even when its reply is lost on the line
+    thread_local std::minstd_rand random{std::random_device{}()};
+    if (((device.Baudrate() > _options.maxReliableBaudrate) || (device.DelayAnswerMs() < _options.minReliableDelayAnswerMs)) &&
+        ((random() % 2) == 0))
+    {
+      return {};
+    }
+    auto delay = std::chrono::microseconds(device.DelayAnswerMs() * 1000);
+    if (_options.emulateWireTime)
+    {
+      // 10 bits per character and 3.5 characters of silence before the reply
+      delay += std::chrono::microseconds((frame.size() + reply->size() + 3) * 10000000ull / device.BaudrateBps());
+    }
+    std::this_thread::sleep_for(delay);
+    return reply;
+  }
+
+  static void Write(int fd, std::string const& data)
+  {
+    for (size_t offset = 0; offset < data.size();)
+    {
+      auto const bytes = ::write(fd, data.data() + offset, data.size() - offset);
+      if (bytes <= 0)
+      {
+        return;
+      }
+      offset += static_cast<size_t>(bytes);
+    }
+  }
+
+  /**
+   * Serve RTU frames from pseudo terminal or TCP stream.
+   */
+  void Serve(int fd)
+  {
+    std::string buffer;
+    auto lastByteTime = std::chrono::steady_clock::now();
+    while (_running)
+    {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, 50) <= 0)
+      {
+        continue;
+      }
+      char chunk[512];
+      auto const bytes = ::read(fd, chunk, sizeof(chunk));
+      if (bytes <= 0)
+      {
+        if (fd != _masterFd)
+        {
+          return;
+        }
+        continue;
+      }
+      auto const now = std::chrono::steady_clock::now();
+      // Silence longer than any inter character gap starts a new frame
+      if ((now - lastByteTime) > std::chrono::milliseconds(20))
+      {
+        buffer.clear();
+      }
+      lastByteTime = now;
+      buffer.append(chunk, static_cast<size_t>(bytes));
+      while (true)
+      {
+        auto const length = RequestLength(buffer);
+        if ((length == 0) || (buffer.size() < length))
+        {
+          break;
+        }
+        auto const frame = buffer.substr(0, length);
+        buffer.erase(0, length);
+        if (_options.checkLineBaudrate && (fd == _masterFd) && !IsLineBaudrate(fd, frame))
+        {
+          continue;
+        }
+        auto const reply = Reply(frame);
+        if (reply.has_value())
+        {
+          Write(fd, reply.value());
+        }
+      }
+    }
+  }
+
+  /**
+   * Serve MBAP frames: requests are converted to RTU frames of the unit id, replies back to MBAP.
+   * Unit which is not emulated gets exception 0x0B (gateway target device failed to respond).
+   */
+  void ServeModbusTcp(int fd)
+  {
+    constexpr size_t HEADER_SIZE = 7;
+    std::string buffer;
+    while (_running)
+    {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, 50) <= 0)
+      {
+        continue;
+      }
+      char chunk[512];
+      auto const bytes = ::read(fd, chunk, sizeof(chunk));
+      if (bytes <= 0)
+      {
+        return;
+      }
+      buffer.append(chunk, static_cast<size_t>(bytes));
+      while ((buffer.size() >= HEADER_SIZE) && (buffer.size() >= (HEADER_SIZE - 1 + Get16(buffer, 4))))
+      {
+        auto const frameSize = HEADER_SIZE - 1 + Get16(buffer, 4);
+        auto const frame = buffer.substr(0, frameSize);
+        buffer.erase(0, frameSize);
+        auto const rtu = AppendCrc(frame.substr(HEADER_SIZE - 1));
+        auto const address = static_cast<uint8_t>(rtu[0]);
+        if (address == 0)
+        {
+          Process(rtu);
+          continue;
+        }
+        auto const reply = (_devices.count(address) != 0) ? Reply(rtu) : std::optional<std::string>{Exception(rtu, 0x0B)};
+        if (!reply.has_value())
+        {
+          continue;
+        }
+        auto mbap = frame.substr(0, 4);
+        Put16(mbap, static_cast<uint16_t>(reply->size() - 2));
+        mbap.append(*reply, 0, reply->size() - 2);
+        Write(fd, mbap);
+      }
+    }
+  }
+
+  Options _options;
+  std::map<uint8_t, Device> _devices;
+  int _masterFd{-1};
+  int _slaveFd{-1};
+  std::string _linkPath;
+  std::atomic<bool> _running{};
+  std::atomic<uint64_t> _requests{};
+  std::mutex _processMutex;
+  int _listenFd{-1};
+  std::thread _acceptThread;
+  std::mutex _connectionsMutex;
+  std::vector<std::thread> _connections;
+  std::thread _thread;
+};
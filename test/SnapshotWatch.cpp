@@ -0,0 +1,94 @@
+#include <OWEN/SnapshotShm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " [options]\n"
+             << "  --shm NAME           shared memory segment (default /owen-si30)\n"
+             << "  --interval MS        print period (default 1000)\n"
+             << "  --count N            print N times and exit (default 0 - until interrupted)\n";
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   using namespace std::chrono;
+
+   std::string shmName{"/owen-si30"};
+   milliseconds interval{1000};
+   uint32_t count{};
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      if ((i + 1) >= argc)
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+      auto const value = std::string{argv[++i]};
+      if (arg == "--shm") shmName = value;
+      else if (arg == "--interval") interval = milliseconds(std::stoul(value));
+      else if (arg == "--count") count = static_cast<uint32_t>(std::stoul(value));
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   try
+   {
+      OWEN::SnapshotShm::Reader reader{shmName};
+      for (uint32_t iteration = 0; !interrupted && ((count == 0) || (iteration < count)); ++iteration)
+      {
+         if (iteration != 0)
+         {
+            std::this_thread::sleep_for(interval);
+         }
+         auto const nowNs = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+         std::cout << "unit     counter          EU  run  mode  err     updates    age ms" << std::endl;
+         for (uint32_t unit = 0; unit < OWEN::SnapshotShm::SLOT_COUNT; ++unit)
+         {
+            OWEN::SnapshotShm::Snapshot snapshot;
+            auto const result = reader.Read(static_cast<uint8_t>(unit), snapshot);
+            if (result == OWEN::SnapshotShm::eRead::EMPTY)
+            {
+               continue;
+            }
+            if (result == OWEN::SnapshotShm::eRead::TORN)
+            {
+               std::cout << std::setw(4) << unit << "  torn" << std::endl;
+               continue;
+            }
+            std::cout << std::setw(4) << unit
+                      << std::setw(12) << snapshot.counterValue
+                      << std::setw(12) << snapshot.counterEU
+                      << std::setw(5) << static_cast<uint32_t>(snapshot.startStopMode)
+                      << std::setw(6) << static_cast<uint32_t>(snapshot.currentMode)
+                      << std::setw(5) << static_cast<uint32_t>(snapshot.codeErrNet)
+                      << std::setw(12) << snapshot.updates
+                      << std::setw(10) << (nowNs - snapshot.timeNs) / 1000000 << std::endl;
+         }
+      }
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,170 @@
+#include <OWEN/BusSniffer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+
+std::atomic<bool> interrupted{};
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --port PATH [options]\n"
+             << "  --port PATH          serial port attached to the bus of another master, only read\n"
+             << "  --baudrate BPS       line baudrate, 8N1 (default 115200)\n"
+             << "  --unit ADDR          slave address of a counter, may be repeated (default every slave)\n"
+             << "  --gap US             silence which ends a frame (default t3.5 of the baudrate)\n"
+             << "  --shm NAME           also publish snapshots to the shared memory segment\n"
+             << "  --interval MS        print period (default 1000)\n"
+             << "  --duration S         run time (default until interrupted)\n";
+}
+
+auto ToBaudrate(uint32_t bps) -> CommunicationOptions::eBaudrate
+{
+   constexpr uint32_t baudrates[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200};
+   auto const it = std::find(std::begin(baudrates), std::end(baudrates), bps);
+   if (it == std::end(baudrates))
+   {
+      throw std::runtime_error("Unsupported baudrate " + std::to_string(bps));
+   }
+   return static_cast<CommunicationOptions::eBaudrate>(std::distance(std::begin(baudrates), it));
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::string portPath;
+   uint32_t baudrate{115200};
+   std::vector<uint8_t> units;
+   uint32_t gapUs{};
+   std::string shmName;
+   uint32_t intervalMs{1000};
+   uint32_t durationS{};
+   try
+   {
+      for (int32_t i = 1; i < argc; ++i)
+      {
+         auto const arg = std::string{argv[i]};
+         if ((i + 1) >= argc)
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+         auto const value = std::string{argv[++i]};
+         if (arg == "--port") portPath = value;
+         else if (arg == "--baudrate") baudrate = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--unit") units.push_back(static_cast<uint8_t>(std::stoul(value)));
+         else if (arg == "--gap") gapUs = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--shm") shmName = value;
+         else if (arg == "--interval") intervalMs = static_cast<uint32_t>(std::stoul(value));
+         else if (arg == "--duration") durationS = static_cast<uint32_t>(std::stoul(value));
+         else
+         {
+            PrintUsage(argv[0]);
+            return 1;
+         }
+      }
+   }
+   catch (std::exception const&)
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   if (portPath.empty())
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   std::signal(SIGINT, [](int) { interrupted = true; });
+   std::signal(SIGTERM, [](int) { interrupted = true; });
+
+   try
+   {
+      auto communicationOptions = CommunicationOptions{};
+      communicationOptions.PortPath(portPath)
+              .BaudeRate(ToBaudrate(baudrate))
+              .Parity(CommunicationOptions::eParity::NO)
+              .StopBits(false)
+              .DataBits(true);
+      OWEN::BusSniffer sniffer{communicationOptions, units, std::chrono::microseconds(gapUs)};
+
+      // Snapshots of every unit since the last print and the latest one
+      struct Seen
+      {
+         uint64_t snapshots{};
+         uint64_t mixed{};   ///< snapshots with values of different transactions
+         OWEN::ImpulseCounter30::Snapshot latest;
+      };
+      std::mutex mutex;
+      std::map<uint8_t, Seen> seen;
+      sniffer.OnSnapshot([&](uint8_t unit,
+                             std::chrono::system_clock::time_point,
+                             OWEN::ImpulseCounter30::Snapshot const& snapshot,
+                             OWEN::BusSniffer::SnapshotStamps const& stamps) {
+         std::lock_guard<std::mutex> lock{mutex};
+         auto& unitSeen = seen[unit];
+         ++unitSeen.snapshots;
+         unitSeen.mixed += stamps.IsCoherent() ? 0 : 1;
+         unitSeen.latest = snapshot;
+      });
+      if (!shmName.empty())
+      {
+         sniffer.Publish(shmName);
+      }
+      sniffer.Start();
+
+      auto const start = std::chrono::steady_clock::now();
+      while (!interrupted && ((durationS == 0) || (std::chrono::steady_clock::now() - start < std::chrono::seconds(durationS))))
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+         std::lock_guard<std::mutex> lock{mutex};
+         for (auto& unit : seen)
+         {
+            std::cout << "unit " << std::setw(3) << static_cast<uint32_t>(unit.first)
+                      << "  snapshots " << std::setw(6) << unit.second.snapshots
+                      << "  mixed " << std::setw(6) << unit.second.mixed
+                      << "  value " << std::setw(8) << unit.second.latest.counterValue
+                      << "  EU " << std::setw(8) << unit.second.latest.counterEU
+                      << "  running " << unit.second.latest.startStopMode << std::endl;
+            unit.second.snapshots = 0;
+            unit.second.mixed = 0;
+         }
+      }
+      sniffer.Stop();
+
+      auto const statistics = sniffer.GetStatistics();
+      std::cout << "Frames " << statistics.frames << ", transactions " << statistics.transactions
+                << ", exceptions " << statistics.exceptions << ", unanswered " << statistics.unanswered
+                << ", discarded bytes " << statistics.discardedBytes << ", snapshots " << statistics.snapshots << std::endl;
+      for (auto const unit : sniffer.Units())
+      {
+         auto const observed = sniffer.Image(unit);
+         if (!observed)
+         {
+            continue;
+         }
+         std::cout << "unit " << static_cast<uint32_t>(unit) << " holding registers:";
+         for (auto const value : observed->image.holdingRegisters)
+         {
+            std::cout << ' ' << value;
+         }
+         std::cout << std::endl;
+      }
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,175 @@
+#include <OWEN/ImpulseCounter30.hpp>
+#include <OWEN/FrameLog.hpp>
+#include "SI30Simulator.hpp"
+#include "FaultShim.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " [options]\n"
+             << "  --port PATH          real port or simulator (default in-process simulator)\n"
+             << "  --address N          slave address (default 16)\n"
+             << "  --duration S         soak duration in seconds (default 30)\n"
+             << "  --corrupt P          probability of corrupted reply\n"
+             << "  --truncate P         probability of truncated reply\n"
+             << "  --latency P          probability of delayed reply\n"
+             << "  --latency-ms MS      added latency (default 50)\n"
+             << "  --split P            probability of reply split to chunks\n"
+             << "  --drop P             probability of dropped reply\n"
+             << "  --seed N             random seed (default 1)\n"
+             << "  --frame-log PATH     log frames of failed transactions\n";
+}
+
+auto Connect(std::string const& portPath, uint16_t address) -> std::unique_ptr<OWEN::ImpulseCounter30>
+{
+   auto communicationOptions = OWEN::ImpulseCounter30::CommunicationOptions{};
+   communicationOptions.PortPath(portPath)
+           .BaudeRate(OWEN::ImpulseCounter30::CommunicationOptions::eBaudrate::_115200bps)
+           .Parity(OWEN::ImpulseCounter30::CommunicationOptions::eParity::NO)
+           .StopBits(false)
+           .DataBits(true)
+           .BaseAddr(address);
+   // Connection check itself goes through the faulty line
+   for (auto attempt = 0; attempt < 10; ++attempt)
+   {
+      try
+      {
+         return std::make_unique<OWEN::ImpulseCounter30>(communicationOptions);
+      }
+      catch (std::runtime_error const& ex)
+      {
+         std::cout << ex.what() << std::endl;
+      }
+   }
+   return {};
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   using namespace std::chrono;
+
+   std::string upstreamPath;
+   uint16_t address{16};
+   uint32_t durationS{30};
+   std::string frameLogPath;
+   auto faults = FaultShim::Options{};
+   for (int32_t i = 1; i < argc; ++i)
+   {
+      auto const arg = std::string{argv[i]};
+      if ((i + 1) >= argc)
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+      auto const value = std::string{argv[++i]};
+      if (arg == "--port") upstreamPath = value;
+      else if (arg == "--address") address = static_cast<uint16_t>(std::stoul(value));
+      else if (arg == "--duration") durationS = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--corrupt") faults.corruptProbability = std::stod(value);
+      else if (arg == "--truncate") faults.truncateProbability = std::stod(value);
+      else if (arg == "--latency") faults.latencyProbability = std::stod(value);
+      else if (arg == "--latency-ms") faults.latencyMs = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--split") faults.splitProbability = std::stod(value);
+      else if (arg == "--drop") faults.dropProbability = std::stod(value);
+      else if (arg == "--seed") faults.seed = static_cast<uint32_t>(std::stoul(value));
+      else if (arg == "--frame-log") frameLogPath = value;
+      else
+      {
+         PrintUsage(argv[0]);
+         return 1;
+      }
+   }
+
+   if (!frameLogPath.empty() && !OWEN::FrameLog::Open(frameLogPath, OWEN::FrameLog::eLevel::ERRORS))
+   {
+      std::cout << "Could not open " << frameLogPath << std::endl;
+      return 1;
+   }
+
+   std::unique_ptr<SI30Simulator> simulator;
+   if (upstreamPath.empty())
+   {
+      auto simulatorOptions = SI30Simulator::Options{};
+      simulatorOptions.addresses = {static_cast<uint8_t>(address)};
+      simulatorOptions.pulseFrequencyHz = 1000.0;
+      simulator = std::make_unique<SI30Simulator>(simulatorOptions);
+      upstreamPath = simulator->Start();
+   }
+   auto shim = FaultShim{upstreamPath, faults};
+   auto const portPath = shim.Start();
+
+   auto impulseCounter = Connect(portPath, address);
+   if (!impulseCounter)
+   {
+      std::cout << "Could not connect through " << portPath << std::endl;
+      return 1;
+   }
+
+   uint64_t samples{};
+   uint64_t timeouts{};
+   uint64_t badFrames{};
+   uint64_t wrongValues{};
+   uint64_t recoveries{};
+   nanoseconds recoveryTotal{};
+   nanoseconds recoveryMax{};
+   std::optional<steady_clock::time_point> failedSince;
+   std::optional<int32_t> lastValue;
+
+   auto const start = steady_clock::now();
+   auto const finish = start + seconds(durationS);
+   while (steady_clock::now() < finish)
+   {
+      auto const requestStart = steady_clock::now();
+      auto const counterValue = impulseCounter->GetCounterValue();
+      auto const requestEnd = steady_clock::now();
+      if (!counterValue.has_value())
+      {
+         // Library does not tell the reason, the time spent does: only missing or incomplete replies wait for timeout
+         ++(((requestEnd - requestStart) >= milliseconds(900)) ? timeouts : badFrames);
+         failedSince = failedSince.value_or(requestStart);
+         continue;
+      }
+      ++samples;
+      // Simulator counts forward only, decreasing value means corrupted data has been accepted
+      wrongValues += (lastValue.has_value() && (counterValue.value() < lastValue.value())) ? 1 : 0;
+      lastValue = counterValue;
+      if (failedSince.has_value())
+      {
+         auto const recovery = requestEnd - failedSince.value();
+         ++recoveries;
+         recoveryTotal += recovery;
+         recoveryMax = std::max(recoveryMax, duration_cast<nanoseconds>(recovery));
+         failedSince.reset();
+      }
+   }
+   auto const elapsedS = duration<double>(steady_clock::now() - start).count();
+   shim.Stop();
+
+   auto const& injected = shim.GetCounters();
+   std::cout << std::dec << std::fixed << std::setprecision(2)
+             << "duration:            " << elapsedS << " s\n"
+             << "samples:             " << samples << '\n'
+             << "samples/sec:         " << (samples / elapsedS) << '\n'
+             << "errors:              " << (timeouts + badFrames) << '\n'
+             << "  timeouts:          " << timeouts << '\n'
+             << "  bad frames:        " << badFrames << '\n'
+             << "  wrong values:      " << wrongValues << '\n'
+             << "recoveries:          " << recoveries << '\n'
+             << "recovery avg:        " << (recoveries ? duration<double, std::milli>(recoveryTotal).count() / recoveries : 0.0) << " ms\n"
+             << "recovery max:        " << duration<double, std::milli>(recoveryMax).count() << " ms\n"
+             << "injected (requests/replies " << injected.requests << '/' << injected.replies << "):\n"
+             << "  corrupted:         " << injected.corrupted << '\n'
+             << "  truncated:         " << injected.truncated << '\n'
+             << "  delayed:           " << injected.delayed << '\n'
+             << "  split:             " << injected.split << '\n'
+             << "  dropped:           " << injected.dropped << std::endl;
+   return (wrongValues == 0) ? 0 : 2;
+}
@@ -0,0 +1,180 @@
+#include <OWEN/ImpulseCounter30.hpp>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using CommunicationOptions = OWEN::ImpulseCounter30::CommunicationOptions;
+using CounterOptions = OWEN::ImpulseCounter30::CounterOptions;
+
+void PrintUsage(char const* name)
+{
+   std::cout << "Usage: " << name << " --simulator PATH --framing tcp|rtutcp\n"
+             << "  --simulator PATH     simulator executable, started on a free loopback port\n"
+             << "  --framing FRAMING    tcp - Modbus TCP (--tcp), rtutcp - RTU over TCP (--rtu-tcp)\n";
+}
+
+/**
+ * Simulator process listening on loopback, stopped when it goes out of scope.
+ */
+class Simulator
+{
+public:
+   Simulator(std::string const& path, std::string const& framing)
+   {
+      int fds[2];
+      if (::pipe(fds) != 0)
+      {
+         throw std::runtime_error("Could not create pipe");
+      }
+      auto const linkPath = "/tmp/ttySI30-tcptest-" + std::to_string(::getpid()) + "-" + framing;
+      auto const option = (framing == "tcp") ? "--tcp" : "--rtu-tcp";
+      _pid = ::fork();
+      if (_pid == 0)
+      {
+         ::dup2(fds[1], STDOUT_FILENO);
+         ::close(fds[0]);
+         ::close(fds[1]);
+         ::execl(path.c_str(), path.c_str(), "--link", linkPath.c_str(), option, "0", static_cast<char*>(nullptr));
+         ::_exit(127);
+      }
+      ::close(fds[1]);
+      if (_pid < 0)
+      {
+         ::close(fds[0]);
+         throw std::runtime_error("Could not start " + path);
+      }
+      // The simulator prints the URL it listens on after the path of its pseudo terminal. The pipe stays open
+      // until it exits, its last output would kill it by SIGPIPE before it removes the link otherwise.
+      _output = ::fdopen(fds[0], "r");
+      char* line{};
+      size_t size{};
+      auto const prefix = framing + "://";
+      while (_url.empty() && (::getline(&line, &size, _output) > 0))
+      {
+         auto const text = std::string{line};
+         auto const position = text.find(prefix);
+         if ((position != std::string::npos) && ((position == 0) || (text[position - 1] == ' ')))
+         {
+            _url = text.substr(position, text.find_last_not_of("\r\n") + 1 - position);
+         }
+      }
+      ::free(line);
+      if (_url.empty())
+      {
+         Stop();
+         throw std::runtime_error("Simulator did not listen on " + framing);
+      }
+   }
+
+   Simulator(Simulator const&) = delete;
+   Simulator& operator=(Simulator const&) = delete;
+
+   ~Simulator()
+   {
+      Stop();
+   }
+
+   auto Url() const -> std::string const&
+   {
+      return _url;
+   }
+
+private:
+   void Stop()
+   {
+      if (_pid > 0)
+      {
+         ::kill(_pid, SIGTERM);
+         ::waitpid(_pid, nullptr, 0);
+         _pid = 0;
+      }
+      if (_output)
+      {
+         ::fclose(_output);
+         _output = nullptr;
+      }
+   }
+
+private:
+   pid_t _pid{};
+   FILE* _output{};
+   std::string _url;
+};
+
+bool Check(char const* what, bool isPassed)
+{
+   std::cout << (isPassed ? "passed " : "FAILED ") << what << std::endl;
+   return isPassed;
+}
+
+/**
+ * Single, batched and read-write-multiple transactions through the URL.
+ */
+auto RoundTrips(std::string const& url) -> uint32_t
+{
+   auto communicationOptions = CommunicationOptions{};
+   communicationOptions.PortPath(url)
+           .BaudeRate(CommunicationOptions::eBaudrate::_115200bps)
+           .Parity(CommunicationOptions::eParity::NO)
+           .StopBits(false)
+           .DataBits(true)
+           .BaseAddr(16);
+   auto counter = OWEN::ImpulseCounter30{communicationOptions};
+   uint32_t failed{};
+   failed += !Check("read communication options", counter.GetCommunicationOptions().has_value());
+   failed += !Check("write counter options with readback", counter.SetCounterOptions(CounterOptions{}.SetPoint1(1234).Brightness(2), true));
+   auto options = counter.GetCounterOptions();
+   failed += !Check("read written counter options",
+                    options.has_value() && (options->_point1Threshold == 1234) && (options->_brightness == 2));
+   failed += !Check("write counter options", counter.SetCounterOptions(CounterOptions{}.SetPoint1(-5678)));
+   options = counter.GetCounterOptions();
+   failed += !Check("read written set point", options.has_value() && (options->_point1Threshold == -5678));
+   failed += !Check("reset count", counter.ResetCount());
+   failed += !Check("read counter value", counter.GetCounterValue().has_value());
+   failed += !Check("read snapshot", counter.GetSnapshot().has_value());
+   auto const image = counter.GetRegisterImage();
+   failed += !Check("read register image", image.has_value() && (image->holdingRegisters.size() == 31) && (image->inputRegisters.size() == 11));
+   return failed;
+}
+
+} /// end namespace anonymous
+
+auto main(int argc, char** argv) -> int32_t
+{
+   std::string simulatorPath;
+   std::string framing;
+   for (int32_t i = 1; (i + 1) < argc; i += 2)
+   {
+      auto const arg = std::string{argv[i]};
+      if (arg == "--simulator") simulatorPath = argv[i + 1];
+      else if (arg == "--framing") framing = argv[i + 1];
+   }
+   if (simulatorPath.empty() || ((framing != "tcp") && (framing != "rtutcp")) || ((argc % 2) == 0))
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+
+   try
+   {
+      Simulator simulator{simulatorPath, framing};
+      std::cout << "Simulator is listening on " << simulator.Url() << std::endl;
+      auto const failed = RoundTrips(simulator.Url());
+      std::cout << failed << " checks failed" << std::endl;
+      return (failed == 0) ? 0 : 1;
+   }
+   catch (std::exception const& ex)
+   {
+      std::cout << "Error: " << ex.what() << std::endl;
+      return 1;
+   }
+}